@@ -8,24 +8,122 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <stdatomic.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/stream_buffer.h"
 #include "freertos/event_groups.h"
+#include "freertos/semphr.h"
 
+#include "sdkconfig.h"
 #include "audio_doa.h"
+#if CONFIG_AUDIO_DOA_ENGINE_SRP_PHAT
+#include "audio_doa_srp.h"
+#endif  /* CONFIG_AUDIO_DOA_ENGINE_SRP_PHAT */
+#if CONFIG_AUDIO_DOA_ENGINE_ONE_BIT
+#include "audio_doa_onebit.h"
+#endif  /* CONFIG_AUDIO_DOA_ENGINE_ONE_BIT */
+#include "audio_doa_pipeline.h"
+#include "audio_doa_profiling.h"
+#include "audio_doa_specialize.h"
 
+#if CONFIG_AUDIO_DOA_ENGINE_ESP_SR
 #include "esp_doa.h"
+#endif  /* CONFIG_AUDIO_DOA_ENGINE_ESP_SR */
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+
+#if !CONFIG_AUDIO_DOA_ENGINE_ESP_SR && !CONFIG_AUDIO_DOA_ENGINE_SRP_PHAT && !CONFIG_AUDIO_DOA_ENGINE_ONE_BIT
+#error "audio_doa: enable at least one DOA engine"
+#endif
 
 #define TAG "AUDIO_DOA"
 
-#define AUDIO_DOA_DATA_BUS_SIZE 2048
+#define AUDIO_DOA_FRAME_SAMPLES CONFIG_AUDIO_DOA_FRAME_SAMPLES
+#define AUDIO_DOA_SAMPLE_RATE   16000
+#define AUDIO_DOA_DEFAULT_MICS  2
+#define AUDIO_DOA_DEFAULT_DISTANCE 0.046f
+#define AUDIO_DOA_FRAME_US      ((uint32_t)((uint64_t)AUDIO_DOA_FRAME_SAMPLES * 1000000 / AUDIO_DOA_SAMPLE_RATE))
+
+#define DEADLINE_DEFAULT_MISS_LIMIT    3
+#define DEADLINE_DEFAULT_WINDOW_FRAMES 32
+#define AUDIO_DOA_STREAM_FRAMES CONFIG_AUDIO_DOA_QUEUE_FRAMES
 
-#define DOA_WINDOW_SIZE 7
-#define GAUSSIAN_SIGMA  1.0
+#define DECIM_FACTOR      2
+#define DECIM_FIR_TAPS    15
+#define DECIM_FIR_HISTORY (DECIM_FIR_TAPS - 1)
+#define DECIM_FIR_CENTER  (DECIM_FIR_HISTORY / 2)
+#define DECIM_FIR_ODD_TAPS ((DECIM_FIR_TAPS + 1) / 4)
+
+#if CONFIG_AUDIO_DOA_SMOOTHING
+#define DOA_WINDOW_SIZE CONFIG_AUDIO_DOA_SMOOTHING_WINDOW
+#define DOA_WINDOW_MAX  15
+#define SMOOTH_MIN_WEIGHT 1.0f  // One LSB of RMS
+
+/**
+ * Gaussian smoothing weights (sigma 1.0) folded to constants at build time.
+ * GAUSS_TERM(d) is exp(-(d / 2)^2 / 2) for the doubled distance d from the
+ * window center, so even windows with a half-sample center stay exact.
+ */
+#define GAUSS_TERM(d)                                                         \
+    ((d) == 0 ? 1.0f : (d) == 1 ? 0.882496903f : (d) == 2 ? 0.60653066f :    \
+     (d) == 3 ? 0.324652467f : (d) == 4 ? 0.135335283f :                      \
+     (d) == 5 ? 0.0439369336f : (d) == 6 ? 0.0111089965f :                    \
+     (d) == 7 ? 0.00218749112f : (d) == 8 ? 0.000335462628f :                 \
+     (d) == 9 ? 4.00652974e-05f : (d) == 10 ? 3.72665317e-06f :              \
+     (d) == 11 ? 2.6995785e-07f : (d) == 12 ? 1.52299797e-08f :              \
+     (d) == 13 ? 6.69158609e-10f : 2.28973485e-11f)
+#define GAUSS_DIST(i) (2 * (i) > DOA_WINDOW_SIZE - 1 ? 2 * (i) - (DOA_WINDOW_SIZE - 1) : (DOA_WINDOW_SIZE - 1) - 2 * (i))
+#define GAUSS_RAW(i)  ((i) < DOA_WINDOW_SIZE ? GAUSS_TERM(GAUSS_DIST(i)) : 0.0f)
+#define GAUSS_SUM                                                             \
+    (GAUSS_RAW(0) + GAUSS_RAW(1) + GAUSS_RAW(2) + GAUSS_RAW(3) + GAUSS_RAW(4) + \
+     GAUSS_RAW(5) + GAUSS_RAW(6) + GAUSS_RAW(7) + GAUSS_RAW(8) + GAUSS_RAW(9) + \
+     GAUSS_RAW(10) + GAUSS_RAW(11) + GAUSS_RAW(12) + GAUSS_RAW(13) + GAUSS_RAW(14))
+#define GAUSS_WEIGHT(i) (GAUSS_RAW(i) / GAUSS_SUM)
+
+static const float s_gaussian_weights[DOA_WINDOW_MAX] = {
+    GAUSS_WEIGHT(0), GAUSS_WEIGHT(1), GAUSS_WEIGHT(2), GAUSS_WEIGHT(3), GAUSS_WEIGHT(4),
+    GAUSS_WEIGHT(5), GAUSS_WEIGHT(6), GAUSS_WEIGHT(7), GAUSS_WEIGHT(8), GAUSS_WEIGHT(9),
+    GAUSS_WEIGHT(10), GAUSS_WEIGHT(11), GAUSS_WEIGHT(12), GAUSS_WEIGHT(13), GAUSS_WEIGHT(14),
+};
+#endif  /* CONFIG_AUDIO_DOA_SMOOTHING */
 
 #define START_BIT (1 << 0)
+#define PARKED_BIT (1 << 1)  // Set by the DOA task while it waits for START_BIT
+#define EXIT_BIT (1 << 2)    // Set by audio_doa_delete(), the tasks leave their loops
+#define TASK_EXITED_BIT (1 << 3)    // The DOA task is done with the instance and suspended
+#define SHADOW_EXITED_BIT (1 << 4)  // The shadow task is done with the instance and suspended
+
+#define BAD_FRAME_WORD_BITS 32  // Frames per word of the bad frame mask, also its minimum size
+
+#define NOISE_FLOOR_RISE   1.001f  // Per-frame rise of the floor follower, about 3 %/s at 16 kHz / 512
+#define GATE_FLOOR_MARGIN  2.0f    // Gate at 6 dB above the noise floor when that is above gate_rms
+
+#define INSTANCE_ID_MASK (0x7fffffffu)  // The top bit marks the shadow chain for the profiling hooks
+
+#define PARK_TIMEOUT_MS      1000  // Longest frame plus margin, for callers waiting on PARKED_BIT
+
+#define BENCH_DEFAULT_FRAMES 100
+#define BENCH_SOURCE_DELAY   1     // Samples between adjacent channels, a source off broadside
+#define BENCH_RING_SIZE      8     // Power of two above (AUDIO_DOA_MAX_MICS - 1) * BENCH_SOURCE_DELAY
+
+#define SHADOW_TASK_PRIORITY 5  // Below audio_doa_thread so the shadow only runs on idle time
+#define SHADOW_RING_SIZE     8
+// Primary result slot: low 16 bits of the frame index and the angle in centi-degrees, one
+// word so the shadow task never pairs an index with the angle of a later frame
+#define SHADOW_RESULT(index, angle) (((uint32_t)(index) << 16) | (uint16_t)((angle) * 100.0f + 0.5f))
+
+#define WINDOW_SAMPLES(n, w) ((w) == AUDIO_DOA_WINDOW_SHORT ? (n) / 2 : (w) == AUDIO_DOA_WINDOW_LONG ? 2 * (n) : (n))
+
+#if CONFIG_AUDIO_DOA_DECIMATION
+/**
+ * Half-band low-pass (Hamming windowed sinc, cutoff fs/4) in Q15. Only the odd
+ * offsets from the center tap are non-zero and the center tap is 0.5, so a
+ * 15-tap filter costs 5 multiplies per output sample.
+ */
+static const int16_t decim_halfband_q15[DECIM_FIR_ODD_TAPS] = {10097, -2494, 761, -172};
+#endif  /* CONFIG_AUDIO_DOA_DECIMATION */
 
 typedef enum {
     AUDIO_DOA_STATE_IDLE,
@@ -39,52 +137,142 @@ typedef enum {
     MIC_DIRECTION_MAX,
 } mic_direction_t;
 
+/**
+ * @brief  Engine instance sized for one analysis window
+ */
+typedef struct {
+#if CONFIG_AUDIO_DOA_ENGINE_ESP_SR
+    doa_handle_t         *doa_handle;
+#endif  /* CONFIG_AUDIO_DOA_ENGINE_ESP_SR */
+#if CONFIG_AUDIO_DOA_ENGINE_SRP_PHAT
+    audio_doa_srp_t      *srp;
+#endif  /* CONFIG_AUDIO_DOA_ENGINE_SRP_PHAT */
+#if CONFIG_AUDIO_DOA_ENGINE_ONE_BIT
+    audio_doa_onebit_t   *onebit;
+#endif  /* CONFIG_AUDIO_DOA_ENGINE_ONE_BIT */
+} audio_doa_engine_inst_t;
+
+/**
+ * @brief  Deinterleave -> decimation -> engine -> smoothing -> calibration chain
+ *
+ *         The stages are put in `pipeline` at create time. The primary pipeline also
+ *         holds the gate, custom stages and the result sink, the optional shadow
+ *         chain runs the same frames through another configuration for comparison.
+ */
+typedef struct {
+    audio_doa_engine_t    engine;
+    bool                  decimate;
+    int                   samples;        /*!< Samples per channel reaching the engine */
+    int                   sample_rate;
+    audio_doa_pipeline_t  pipeline;
+    audio_doa_engine_inst_t engines[AUDIO_DOA_WINDOW_NUM];  /*!< Only AUDIO_DOA_WINDOW_FRAME unless adaptive */
+    audio_doa_window_t    window;         /*!< Window analysed for the current frame */
+    int16_t              *window_data[AUDIO_DOA_MAX_MICS];  /*!< Start of that window per channel */
+    int16_t              *mic_data[AUDIO_DOA_MAX_MICS];
+#if CONFIG_AUDIO_DOA_ADAPTIVE_WINDOW
+    bool                  adaptive;
+    atomic_int            requested_window;  /*!< Set by audio_doa_set_window(), picked up per frame */
+    audio_doa_stage_process_t engine_process;  /*!< Engine stage wrapped by the window accounting */
+    int16_t              *history[AUDIO_DOA_MAX_MICS];  /*!< Last two frames per channel, oldest first */
+    int                   history_frames;   /*!< Frames in `history`, up to two */
+    uint32_t              window_frames[AUDIO_DOA_WINDOW_NUM];
+    int64_t               window_time_us[AUDIO_DOA_WINDOW_NUM];
+    uint32_t              window_switches;
+    portMUX_TYPE         *stats_lock;       /*!< Instance `stats_lock`, guards the window counters */
+#endif  /* CONFIG_AUDIO_DOA_ADAPTIVE_WINDOW */
+#if CONFIG_AUDIO_DOA_DECIMATION
+    int16_t              *decim_buf[AUDIO_DOA_MAX_MICS];
+#endif  /* CONFIG_AUDIO_DOA_DECIMATION */
+    void                (*deinterleave)(int16_t *const *out, const int16_t *in);  /*!< Fixed-format instantiation, NULL = generic */
+#if CONFIG_AUDIO_DOA_SMOOTHING
+    const float          *gaussian_weights;
+    float                 doa_history[2 * DOA_WINDOW_SIZE];  /*!< Second half only used by the fixed-window smoother */
+    float                 doa_confidence[2 * DOA_WINDOW_SIZE];  /*!< Weight of each history entry, same layout */
+    int                   doa_history_index;
+#endif  /* CONFIG_AUDIO_DOA_SMOOTHING */
+} audio_doa_chain_t;
+
 typedef struct {
     audio_doa_state_t     state;
     audio_doa_callback_t  cb;
     void                 *ctx;
     uint8_t              *audio_data;
     int                   audio_data_size;
-    doa_handle_t         *doa_handle;
+    audio_doa_chain_t     primary;
+#if CONFIG_AUDIO_DOA_SHADOW
+    audio_doa_chain_t    *shadow;
+    uint8_t              *shadow_frame;
+    atomic_bool           shadow_busy;
+    uint32_t              shadow_frame_index;
+    TaskHandle_t          shadow_task_handle;
+    audio_doa_callback_t  shadow_cb;
+    void                 *shadow_ctx;
+    atomic_uint           primary_results[SHADOW_RING_SIZE];  /*!< SHADOW_RESULT() by frame index, for disagreement */
+    int64_t               shadow_time_us;
+    float                 disagreement_sum;
+    uint32_t              disagreement_count;
+#endif  /* CONFIG_AUDIO_DOA_SHADOW */
     StreamBufferHandle_t  stream_buffer;
     TaskHandle_t          task_handle;
     EventGroupHandle_t    event_group;
-    int16_t              *mic_data[MIC_DIRECTION_MAX];
-    float                 doa_history[DOA_WINDOW_SIZE];
-    int                   doa_history_index;
-    float                *gaussian_weights;
+    int                   mic_num;
+    int                   frame_bytes;
+    audio_doa_gap_policy_t gap_policy;
+    int                   rx_fill;           /*!< Bytes of the current frame already received */
+    uint32_t              rx_frame_seq;
+    int                   tx_fill;           /*!< Bytes of the current frame already written */
+    uint32_t              tx_frame_seq;
+    bool                  seq_valid;
+    uint64_t              next_sample_index;
+    atomic_uint          *bad_frames;        /*!< Bit (frame_seq % bad_frame_slots) set for frames to skip */
+    uint32_t              bad_frame_slots;   /*!< Power of two above the frames the stream buffer and both partial frames can hold */
+    audio_doa_stats_t     stats;
+    portMUX_TYPE          stats_lock;        /*!< Guards `stats` and the time sums: 64-bit values and sum/count pairs must not tear */
+    uint32_t              batch_interval_ms;
+    uint32_t              batch_notify_bytes;  /*!< Writer wakes the task at this fill level (0 = never) */
+    float                 gate_rms;
+    float                 noise_floor_rms;   /*!< Minimum follower of the frame RMS (0 = not learned yet) */
+    int64_t               create_start_us;   /*!< esp_timer time audio_doa_new() was entered */
+    audio_doa_deadline_callback_t deadline_cb;
+    void                 *deadline_ctx;
+    uint32_t              deadline_miss_limit;
+    uint32_t              deadline_window_frames;
+    uint32_t              window_frames;     /*!< Frames of the current deadline window */
+    uint32_t              window_misses;     /*!< Deadline misses in the current window */
 } audio_doa_t;
 
-static float moving_weighted_average(float *data, int window_size, float *weights, int current_index)
+#if AUDIO_DOA_SPECIALIZE
+AUDIO_DOA_DEFINE_DEINTERLEAVE(deinterleave_2ch, 2, AUDIO_DOA_FRAME_SAMPLES)
+#if AUDIO_DOA_MAX_MICS >= 3
+AUDIO_DOA_DEFINE_DEINTERLEAVE(deinterleave_3ch, 3, AUDIO_DOA_FRAME_SAMPLES)
+#endif
+#if AUDIO_DOA_MAX_MICS >= 4
+AUDIO_DOA_DEFINE_DEINTERLEAVE(deinterleave_4ch, 4, AUDIO_DOA_FRAME_SAMPLES)
+#endif
+#endif  /* AUDIO_DOA_SPECIALIZE */
+
+#if CONFIG_AUDIO_DOA_SMOOTHING
+#if AUDIO_DOA_SPECIALIZE
+AUDIO_DOA_DEFINE_SMOOTHING(smooth_fixed_window, DOA_WINDOW_SIZE)
+#else
+static float moving_weighted_average(const float *data, const float *confidence, int window_size, const float *weights, int current_index)
 {
     float sum = 0.0f;
     float weight_sum = 0.0f;
 
     for (int i = 0; i < window_size; i++) {
         int data_index = (current_index - i + window_size) % window_size;
-        sum += data[data_index] * weights[i];
-        weight_sum += weights[i];
+        float weight = weights[i] * confidence[data_index];
+        sum += data[data_index] * weight;
+        weight_sum += weight;
     }
 
     return sum / weight_sum;
 }
+#endif  /* AUDIO_DOA_SPECIALIZE */
+#endif  /* CONFIG_AUDIO_DOA_SMOOTHING */
 
-static void generate_gaussian_weights(float *weights, int size, float sigma)
-{
-    float sum = 0.0f;
-    float center = (size - 1) / 2.0f;
-
-    for (int i = 0; i < size; i++) {
-        float x = i - center;
-        weights[i] = expf(-(x * x) / (2 * sigma * sigma));
-        sum += weights[i];
-    }
-
-    for (int i = 0; i < size; i++) {
-        weights[i] /= sum;
-    }
-}
-
+#if CONFIG_AUDIO_DOA_CALIBRATION
 static float doa_angle_calibration(float raw_angle)
 {
     if (raw_angle < 0) {
@@ -115,166 +303,1006 @@ static float doa_angle_calibration(float raw_angle)
 
     return corrected_angle;
 }
+#endif  /* CONFIG_AUDIO_DOA_CALIBRATION */
 
-static inline void extract_mic_data(audio_doa_t *doa)
+static inline void extract_mic_data(audio_doa_chain_t *chain, const int16_t *audio_buffer, int mic_num)
 {
-    int16_t *audio_buffer = (int16_t *)doa->audio_data;
-    int size = doa->audio_data_size / sizeof(int16_t);
-    int sample_count = size / 2;  // 每个通道的样本数
+    int sample_count = AUDIO_DOA_FRAME_SAMPLES;  // 每个通道的样本数
+    if (mic_num == 2) {
+        for (int i = 0; i < sample_count; i++) {
+            chain->mic_data[MIC_DIRECTION_LEFT][i] = audio_buffer[i * 2];
+            chain->mic_data[MIC_DIRECTION_RIGHT][i] = audio_buffer[i * 2 + 1];
+        }
+        return;
+    }
     for (int i = 0; i < sample_count; i++) {
-        doa->mic_data[MIC_DIRECTION_LEFT][i] = audio_buffer[i * 2];
-        doa->mic_data[MIC_DIRECTION_RIGHT][i] = audio_buffer[i * 2 + 1];
+        for (int m = 0; m < mic_num; m++) {
+            chain->mic_data[m][i] = audio_buffer[i * mic_num + m];
+        }
+    }
+}
+
+#if CONFIG_AUDIO_DOA_DECIMATION
+/**
+ * @brief  Low-pass and decimate one channel 2:1 in place
+ *
+ *         The last DECIM_FIR_HISTORY input samples are kept at the head of
+ *         `history` so the filter runs continuously across frame boundaries.
+ */
+static void decimate_channel(int16_t *samples, int sample_count, int16_t *history)
+{
+    int16_t *x = history + DECIM_FIR_HISTORY;
+    memcpy(x, samples, sample_count * sizeof(int16_t));
+
+    for (int m = 0; m < sample_count / DECIM_FACTOR; m++) {
+        const int16_t *c = history + m * DECIM_FACTOR + DECIM_FIR_CENTER;
+        int32_t acc = (int32_t)c[0] << 14;
+        for (int j = 0; j < DECIM_FIR_ODD_TAPS; j++) {
+            int off = 2 * j + 1;
+            acc += (int32_t)decim_halfband_q15[j] * ((int32_t)c[-off] + (int32_t)c[off]);
+        }
+        acc = (acc + (1 << 14)) >> 15;
+        if (acc > INT16_MAX) {
+            acc = INT16_MAX;
+        } else if (acc < INT16_MIN) {
+            acc = INT16_MIN;
+        }
+        samples[m] = (int16_t)acc;
+    }
+    memmove(history, history + sample_count, DECIM_FIR_HISTORY * sizeof(int16_t));
+}
+#endif  /* CONFIG_AUDIO_DOA_DECIMATION */
+
+/**
+ * @brief  Receive the rest of the current frame
+ *
+ *         A receive can time out with part of a frame, it is kept so frames stay aligned.
+ *
+ * @return  true once a whole frame is in `audio_data`
+ */
+static bool audio_doa_receive_frame(audio_doa_t *doa, TickType_t timeout)
+{
+    size_t bytes_received = xStreamBufferReceive(doa->stream_buffer, 
+                                                 doa->audio_data + doa->rx_fill, 
+                                                 doa->frame_bytes - doa->rx_fill, 
+                                                 timeout);
+    doa->rx_fill += bytes_received;
+    if (doa->rx_fill < doa->frame_bytes) {
+        return false;
+    }
+    doa->rx_fill = 0;
+    return true;
+}
+
+#if CONFIG_AUDIO_DOA_ADAPTIVE_WINDOW
+/**
+ * @brief  Append the conditioned frame to the history and point the engine at the requested window
+ *
+ *         The history holds the last two frames back to back, so every window is the
+ *         contiguous tail of it. The frame window is used until the history is full.
+ */
+static void audio_doa_select_window(audio_doa_chain_t *chain, int mic_num)
+{
+    int n = chain->samples;
+    for (int i = 0; i < mic_num; i++) {
+        memmove(chain->history[i], chain->history[i] + n, n * sizeof(int16_t));
+        memcpy(chain->history[i] + n, chain->mic_data[i], n * sizeof(int16_t));
+    }
+    if (chain->history_frames < 2) {
+        chain->history_frames++;
+    }
+    audio_doa_window_t window = (audio_doa_window_t)atomic_load(&chain->requested_window);
+    if (window == AUDIO_DOA_WINDOW_LONG && chain->history_frames < 2) {
+        window = AUDIO_DOA_WINDOW_FRAME;
+    }
+    if (window != chain->window) {
+        chain->window_switches++;
+        chain->window = window;
+    }
+    int samples = WINDOW_SAMPLES(n, window);
+    for (int i = 0; i < mic_num; i++) {
+        chain->window_data[i] = chain->history[i] + 2 * n - samples;
+    }
+}
+
+/**
+ * @brief  Engine stage of an adaptive chain: the engine for the selected window, timed per window
+ */
+static bool audio_doa_stage_windowed(audio_doa_frame_t *frame, void *ctx)
+{
+    audio_doa_chain_t *chain = (audio_doa_chain_t *)ctx;
+    int64_t start_us = esp_timer_get_time();
+    bool ret = chain->engine_process(frame, ctx);
+    int64_t elapsed_us = esp_timer_get_time() - start_us;
+    portENTER_CRITICAL(chain->stats_lock);
+    chain->window_time_us[chain->window] += elapsed_us;
+    chain->window_frames[chain->window]++;
+    portEXIT_CRITICAL(chain->stats_lock);
+    return ret;
+}
+#endif  /* CONFIG_AUDIO_DOA_ADAPTIVE_WINDOW */
+
+static bool audio_doa_stage_condition(audio_doa_frame_t *frame, void *ctx)
+{
+    audio_doa_chain_t *chain = (audio_doa_chain_t *)ctx;
+    if (chain->deinterleave) {
+        chain->deinterleave(chain->mic_data, frame->interleaved);
+    } else {
+        extract_mic_data(chain, frame->interleaved, frame->mic_num);
+    }
+#if CONFIG_AUDIO_DOA_DECIMATION
+    if (chain->decimate) {
+        for (int i = 0; i < frame->mic_num; i++) {
+            decimate_channel(chain->mic_data[i], AUDIO_DOA_FRAME_SAMPLES, chain->decim_buf[i]);
+        }
+    }
+#endif  /* CONFIG_AUDIO_DOA_DECIMATION */
+#if CONFIG_AUDIO_DOA_ADAPTIVE_WINDOW
+    if (chain->adaptive) {
+        audio_doa_select_window(chain, frame->mic_num);
+    }
+#endif  /* CONFIG_AUDIO_DOA_ADAPTIVE_WINDOW */
+    frame->mic_data = chain->mic_data;
+    frame->samples = chain->samples;
+    frame->sample_rate = chain->sample_rate;
+    return true;
+}
+
+static bool audio_doa_stage_gate(audio_doa_frame_t *frame, void *ctx)
+{
+    audio_doa_t *doa = (audio_doa_t *)ctx;
+    int total_samples = AUDIO_DOA_FRAME_SAMPLES * frame->mic_num;
+    float rms_value = 0.0f;
+    for (int i = 0; i < total_samples; i++) {
+        rms_value += (float)(frame->interleaved[i]) * (float)(frame->interleaved[i]);
+    }
+    rms_value = sqrtf(rms_value / total_samples);
+    // Follow quiet frames down at once and louder ones up slowly, so speech barely moves the floor
+    if (doa->noise_floor_rms == 0.0f || rms_value < doa->noise_floor_rms) {
+        doa->noise_floor_rms = rms_value;
+    } else {
+        doa->noise_floor_rms *= NOISE_FLOOR_RISE;
+    }
+    float threshold = doa->noise_floor_rms * GATE_FLOOR_MARGIN;
+    if (threshold < doa->gate_rms) {
+        threshold = doa->gate_rms;
+    }
+    if (rms_value < threshold) {
+        doa->stats.frames_gated++;
+        return false;
+    }
+    frame->weight = rms_value;
+    return true;
+}
+
+#if CONFIG_AUDIO_DOA_ENGINE_ESP_SR
+static bool audio_doa_stage_esp_sr(audio_doa_frame_t *frame, void *ctx)
+{
+    audio_doa_chain_t *chain = (audio_doa_chain_t *)ctx;
+    frame->angle = esp_doa_process(chain->engines[chain->window].doa_handle, chain->window_data[MIC_DIRECTION_LEFT],
+                                   chain->window_data[MIC_DIRECTION_RIGHT]);
+    return true;
+}
+#endif  /* CONFIG_AUDIO_DOA_ENGINE_ESP_SR */
+
+#if CONFIG_AUDIO_DOA_ENGINE_SRP_PHAT
+static bool audio_doa_stage_srp(audio_doa_frame_t *frame, void *ctx)
+{
+    audio_doa_chain_t *chain = (audio_doa_chain_t *)ctx;
+    frame->angle = audio_doa_srp_process(chain->engines[chain->window].srp, chain->window_data);
+    return true;
+}
+#endif  /* CONFIG_AUDIO_DOA_ENGINE_SRP_PHAT */
+
+#if CONFIG_AUDIO_DOA_ENGINE_ONE_BIT
+static bool audio_doa_stage_onebit(audio_doa_frame_t *frame, void *ctx)
+{
+    audio_doa_chain_t *chain = (audio_doa_chain_t *)ctx;
+    frame->angle = audio_doa_onebit_process(chain->engines[chain->window].onebit, chain->window_data[MIC_DIRECTION_LEFT],
+                                            chain->window_data[MIC_DIRECTION_RIGHT]);
+    return true;
+}
+#endif  /* CONFIG_AUDIO_DOA_ENGINE_ONE_BIT */
+
+#if CONFIG_AUDIO_DOA_SMOOTHING
+/**
+ * Confidence of the frame's angle: the weight set by an earlier stage (gate RMS or
+ * engine confidence), else the RMS of the first channel. Floored at one LSB so a
+ * window of digital silence still averages.
+ */
+static float audio_doa_frame_confidence(const audio_doa_frame_t *frame)
+{
+    float weight = frame->weight;
+    if (weight <= 0.0f) {
+        const int16_t *samples = frame->mic_data[0];
+        float energy = 0.0f;
+        for (int i = 0; i < frame->samples; i++) {
+            energy += (float)samples[i] * (float)samples[i];
+        }
+        weight = sqrtf(energy / frame->samples);
+    }
+    return weight > SMOOTH_MIN_WEIGHT ? weight : SMOOTH_MIN_WEIGHT;
+}
+
+#if AUDIO_DOA_SPECIALIZE
+static bool audio_doa_stage_smooth(audio_doa_frame_t *frame, void *ctx)
+{
+    audio_doa_chain_t *chain = (audio_doa_chain_t *)ctx;
+    frame->angle = smooth_fixed_window(chain->doa_history, chain->doa_confidence, &chain->doa_history_index,
+                                       chain->gaussian_weights, frame->angle, audio_doa_frame_confidence(frame));
+    return true;
+}
+#else
+static bool audio_doa_stage_smooth(audio_doa_frame_t *frame, void *ctx)
+{
+    audio_doa_chain_t *chain = (audio_doa_chain_t *)ctx;
+    chain->doa_history[chain->doa_history_index] = frame->angle;
+    chain->doa_confidence[chain->doa_history_index] = audio_doa_frame_confidence(frame);
+    frame->angle = moving_weighted_average(chain->doa_history, chain->doa_confidence, DOA_WINDOW_SIZE,
+                                           chain->gaussian_weights, chain->doa_history_index);
+    chain->doa_history_index = (chain->doa_history_index + 1) % DOA_WINDOW_SIZE;
+    return true;
+}
+#endif  /* AUDIO_DOA_SPECIALIZE */
+#endif  /* CONFIG_AUDIO_DOA_SMOOTHING */
+
+#if CONFIG_AUDIO_DOA_CALIBRATION
+static bool audio_doa_stage_calibrate(audio_doa_frame_t *frame, void *ctx)
+{
+    frame->angle = doa_angle_calibration(frame->angle);
+    return true;
+}
+#endif  /* CONFIG_AUDIO_DOA_CALIBRATION */
+
+#if CONFIG_AUDIO_DOA_SHADOW
+/**
+ * @brief  Hand the current frame to the shadow chain if it is idle
+ *
+ *         Shadow work is dropped first: when the shadow is still busy or the
+ *         primary already has the next frame queued, the frame is skipped.
+ */
+static bool audio_doa_stage_shadow_tap(audio_doa_frame_t *frame, void *ctx)
+{
+    audio_doa_t *doa = (audio_doa_t *)ctx;
+    if (xStreamBufferBytesAvailable(doa->stream_buffer) >= (size_t)doa->frame_bytes ||
+        atomic_exchange(&doa->shadow_busy, true)) {
+        doa->stats.shadow_frames_dropped++;
+        return true;
+    }
+    memcpy(doa->shadow_frame, frame->interleaved, doa->frame_bytes);
+    doa->shadow_frame_index = frame->index;
+    xTaskNotifyGive(doa->shadow_task_handle);
+    return true;
+}
+
+static bool audio_doa_stage_shadow_sink(audio_doa_frame_t *frame, void *ctx)
+{
+    audio_doa_t *doa = (audio_doa_t *)ctx;
+    uint32_t result = atomic_load_explicit(&doa->primary_results[frame->index % SHADOW_RING_SIZE], memory_order_acquire);
+    if ((result >> 16) == (frame->index & 0xFFFF)) {
+        float disagreement = fabsf(frame->angle - (result & 0xFFFF) / 100.0f);
+        portENTER_CRITICAL(&doa->stats_lock);
+        doa->disagreement_sum += disagreement;
+        doa->disagreement_count++;
+        if (disagreement > doa->stats.shadow_max_disagreement_deg) {
+            doa->stats.shadow_max_disagreement_deg = disagreement;
+        }
+        portEXIT_CRITICAL(&doa->stats_lock);
+    }
+    if (doa->shadow_cb) {
+        doa->shadow_cb(frame->angle, doa->shadow_ctx);
+    }
+    return true;
+}
+
+static void audio_doa_shadow_thread(void *arg)
+{
+    audio_doa_t *doa = (audio_doa_t *)arg;
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (xEventGroupGetBits(doa->event_group) & EXIT_BIT) {
+            break;
+        }
+        audio_doa_frame_t frame = {
+            .interleaved = (const int16_t *)doa->shadow_frame,
+            .mic_num = doa->mic_num,
+            .index = doa->shadow_frame_index,
+        };
+        int64_t start_us = esp_timer_get_time();
+        audio_doa_pipeline_run(&doa->shadow->pipeline, &frame);
+        int64_t elapsed_us = esp_timer_get_time() - start_us;
+        portENTER_CRITICAL(&doa->stats_lock);
+#if CONFIG_AUDIO_DOA_STAGE_TIMING
+        doa->shadow_time_us += elapsed_us;
+#endif  /* CONFIG_AUDIO_DOA_STAGE_TIMING */
+        doa->stats.shadow_frames++;
+        portEXIT_CRITICAL(&doa->stats_lock);
+        atomic_store(&doa->shadow_busy, false);
+    }
+    xEventGroupSetBits(doa->event_group, SHADOW_EXITED_BIT);
+    vTaskSuspend(NULL);
+}
+#endif  /* CONFIG_AUDIO_DOA_SHADOW */
+
+static bool audio_doa_stage_sink(audio_doa_frame_t *frame, void *ctx)
+{
+    audio_doa_t *doa = (audio_doa_t *)ctx;
+#if CONFIG_AUDIO_DOA_SHADOW
+    if (doa->shadow) {
+        atomic_store_explicit(&doa->primary_results[frame->index % SHADOW_RING_SIZE],
+                              SHADOW_RESULT(frame->index, frame->angle), memory_order_release);
     }
+#endif  /* CONFIG_AUDIO_DOA_SHADOW */
+    if (doa->stats.first_result_us == 0) {
+        doa->stats.first_result_us = (uint32_t)(esp_timer_get_time() - doa->create_start_us);
+    }
+    if (doa->cb) {
+        doa->cb(frame->angle, doa->ctx);
+    }
+    return true;
+}
+
+/**
+ * @brief  Count a frame against the deadline and its window, firing the callback at the miss limit
+ */
+static void audio_doa_check_deadline(audio_doa_t *doa, uint32_t elapsed_us)
+{
+    doa->window_frames++;
+    if (elapsed_us > doa->stats.deadline_us) {
+        uint32_t overrun_us = elapsed_us - doa->stats.deadline_us;
+        portENTER_CRITICAL(&doa->stats_lock);
+        doa->stats.deadline_misses++;
+        if (overrun_us > doa->stats.deadline_worst_overrun_us) {
+            doa->stats.deadline_worst_overrun_us = overrun_us;
+        }
+        portEXIT_CRITICAL(&doa->stats_lock);
+        if (++doa->window_misses == doa->deadline_miss_limit && doa->deadline_cb != NULL) {
+            doa->deadline_cb(doa->window_misses, doa->window_frames, doa->deadline_ctx);
+        }
+    }
+    if (doa->window_frames >= doa->deadline_window_frames) {
+        doa->window_frames = 0;
+        doa->window_misses = 0;
+    }
+}
+
+static void audio_doa_run_frame(audio_doa_t *doa, const int16_t *interleaved)
+{
+    audio_doa_frame_t frame = {
+        .interleaved = interleaved,
+        .mic_num = doa->mic_num,
+        .index = doa->stats.frames_processed + 1,
+    };
+    int64_t start_us = esp_timer_get_time();
+    audio_doa_pipeline_run(&doa->primary.pipeline, &frame);
+    uint32_t elapsed_us = (uint32_t)(esp_timer_get_time() - start_us);
+#if CONFIG_AUDIO_DOA_STAGE_TIMING
+    int bucket = 0;
+    while (bucket < AUDIO_DOA_FRAME_TIME_BUCKETS - 1 && elapsed_us >= AUDIO_DOA_FRAME_TIME_BUCKET_US(bucket)) {
+        bucket++;
+    }
+#endif  /* CONFIG_AUDIO_DOA_STAGE_TIMING */
+    // The frame is counted together with its time, so the histogram, its sum and the average agree
+    portENTER_CRITICAL(&doa->stats_lock);
+    doa->stats.frames_processed = frame.index;
+#if CONFIG_AUDIO_DOA_STAGE_TIMING
+    doa->stats.frame_time_sum_us += elapsed_us;
+    doa->stats.frame_time_hist[bucket]++;
+#endif  /* CONFIG_AUDIO_DOA_STAGE_TIMING */
+    portEXIT_CRITICAL(&doa->stats_lock);
+    audio_doa_check_deadline(doa, elapsed_us);
+}
+
+/**
+ * @brief  Word of the bad frame mask holding `frame_seq`, with its bit in `bit`
+ */
+static inline atomic_uint *audio_doa_bad_frame_word(audio_doa_t *doa, uint32_t frame_seq, unsigned int *bit)
+{
+    uint32_t slot = frame_seq & (doa->bad_frame_slots - 1);
+    *bit = 1u << (slot % BAD_FRAME_WORD_BITS);
+    return &doa->bad_frames[slot / BAD_FRAME_WORD_BITS];
+}
+
+static void audio_doa_process_frame(audio_doa_t *doa)
+{
+    unsigned int frame_bit;
+    atomic_uint *word = audio_doa_bad_frame_word(doa, doa->rx_frame_seq++, &frame_bit);
+    if (atomic_fetch_and(word, ~frame_bit) & frame_bit) {
+        return;
+    }
+    audio_doa_run_frame(doa, (const int16_t *)doa->audio_data);
 }
 
 static void audio_doa_thread(void *arg)
 {
     audio_doa_t *doa = (audio_doa_t *)arg;
     while (1) {
-        uint32_t bits = xEventGroupWaitBits(doa->event_group, START_BIT, pdFALSE, pdFALSE, pdMS_TO_TICKS(10));
+        uint32_t bits = xEventGroupWaitBits(doa->event_group, START_BIT | EXIT_BIT, pdFALSE, pdFALSE, pdMS_TO_TICKS(10));
+        if (bits & EXIT_BIT) {
+            break;
+        }
         if (!(bits & START_BIT)) {
+            xEventGroupSetBits(doa->event_group, PARKED_BIT);
             ESP_LOGI(TAG, "Audio DOA thread is not started");
             vTaskDelay(pdMS_TO_TICKS(10));
             continue;
         }
+        // Leave the parked state before looking at START_BIT again, so a caller that saw
+        // PARKED_BIT after stopping can rely on the task not touching the chain
+        xEventGroupClearBits(doa->event_group, PARKED_BIT);
+        if (!(xEventGroupGetBits(doa->event_group) & START_BIT)) {
+            continue;
+        }
         doa->state = AUDIO_DOA_STATE_RUNNING;
-        
-        size_t bytes_received = xStreamBufferReceive(doa->stream_buffer, 
-                                                     doa->audio_data, 
-                                                     AUDIO_DOA_DATA_BUS_SIZE, 
-                                                     pdMS_TO_TICKS(10));
-        if (bytes_received < AUDIO_DOA_DATA_BUS_SIZE) {
+
+        if (doa->batch_interval_ms > 0) {
+            // Sleep until the interval expires or the writer reports the fill threshold,
+            // then drain everything captured meanwhile in one burst
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(doa->batch_interval_ms));
+            // A stop or delete during the burst ends it at the next frame, whatever is
+            // left stays queued like in the non-batched path
+            uint32_t batch = 0;
+            while ((xEventGroupGetBits(doa->event_group) & (START_BIT | EXIT_BIT)) == START_BIT
+                   && audio_doa_receive_frame(doa, 0)) {
+                audio_doa_process_frame(doa);
+                batch++;
+            }
+            portENTER_CRITICAL(&doa->stats_lock);
+            doa->stats.wakeups++;
+            doa->stats.batch_frames += batch;
+            if (batch > doa->stats.max_batch_frames) {
+                doa->stats.max_batch_frames = batch;
+            }
+            portEXIT_CRITICAL(&doa->stats_lock);
+            continue;
+        }
+
+        portENTER_CRITICAL(&doa->stats_lock);
+        doa->stats.wakeups++;
+        portEXIT_CRITICAL(&doa->stats_lock);
+        if (!audio_doa_receive_frame(doa, pdMS_TO_TICKS(10))) {
             vTaskDelay(pdMS_TO_TICKS(10));
             continue;
         }
+        portENTER_CRITICAL(&doa->stats_lock);
+        doa->stats.batch_frames++;
+        if (doa->stats.max_batch_frames == 0) {
+            doa->stats.max_batch_frames = 1;
+        }
+        portEXIT_CRITICAL(&doa->stats_lock);
+        audio_doa_process_frame(doa);
 
-        int16_t *audio_data = (int16_t *)doa->audio_data;
-        float rms_value = 0.0f;
-        for (int i = 0; i < AUDIO_DOA_DATA_BUS_SIZE / sizeof(int16_t); i++) {
-            rms_value += (float)(audio_data[i]) * (float)(audio_data[i]);
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    // audio_doa_delete() deletes the task only after this, outside any frame
+    xEventGroupSetBits(doa->event_group, TASK_EXITED_BIT);
+    vTaskSuspend(NULL);
+}
+
+typedef struct {
+    audio_doa_t            *doa;
+    uint32_t                frames;
+    audio_doa_benchmark_t  *result;
+    SemaphoreHandle_t       done;
+    int16_t                *frame;      /*!< Private frame buffer, `audio_data` may hold a partial frame */
+    uint32_t                seed;
+    int16_t                 source[BENCH_RING_SIZE];
+    uint32_t                source_pos;
+} audio_doa_bench_t;
+
+/**
+ * @brief  Fill the frame buffer with white noise reaching each channel one sample after the previous one
+ */
+static void audio_doa_bench_fill(audio_doa_bench_t *bench)
+{
+    int16_t *out = bench->frame;
+    int mic_num = bench->doa->mic_num;
+    for (int i = 0; i < AUDIO_DOA_FRAME_SAMPLES; i++) {
+        bench->seed = bench->seed * 1664525u + 1013904223u;
+        uint32_t pos = bench->source_pos++;
+        bench->source[pos % BENCH_RING_SIZE] = (int16_t)(((int32_t)(bench->seed >> 16) - 32768) / 8);
+        for (int m = 0; m < mic_num; m++) {
+            out[i * mic_num + m] = bench->source[(pos - m * BENCH_SOURCE_DELAY) % BENCH_RING_SIZE];
         }
-        rms_value = sqrtf(rms_value / (AUDIO_DOA_DATA_BUS_SIZE / sizeof(int16_t)));
-        // ESP_LOGI(TAG, "RMS value: %.2f", rms_value);
-        // if (rms_value < 80.0f) {
-        //     continue;
-        // }
+    }
+}
 
-        // for (int i = 0; i < 10; i++) {
-        //     printf("channel1: %d, channel2: %d\n", audio_data[i * 2], audio_data[i * 2 + 1]);
-        // }
+static void audio_doa_bench_thread(void *arg)
+{
+    audio_doa_bench_t *bench = (audio_doa_bench_t *)arg;
+    audio_doa_t *doa = bench->doa;
+    audio_doa_pipeline_t *pipeline = &doa->primary.pipeline;
+    audio_doa_benchmark_t *result = bench->result;
+    uint64_t cycles[AUDIO_DOA_MAX_STAGES] = {0};
+    uint32_t calls[AUDIO_DOA_MAX_STAGES] = {0};
+    size_t free_start = heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+    size_t free_min = free_start;
+    int64_t busy_us = 0;
 
+    for (uint32_t i = 1; i <= bench->frames; i++) {
+        audio_doa_bench_fill(bench);
+        audio_doa_frame_t frame = {
+            .interleaved = bench->frame,
+            .mic_num = doa->mic_num,
+            .index = i,
+        };
+        int64_t start_us = esp_timer_get_time();
+        audio_doa_pipeline_run_counted(pipeline, &frame, cycles, calls);
+        busy_us += esp_timer_get_time() - start_us;
+        size_t free_now = heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+        if (free_now < free_min) {
+            free_min = free_now;
+        }
+    }
+
+    uint64_t total_cycles = 0;
+    for (int i = 0; i < pipeline->stage_num; i++) {
+        result->stages[i].name = pipeline->slots[i].stage.name;
+        result->stages[i].kind = pipeline->slots[i].stage.kind;
+        result->stages[i].cycles_per_frame = calls[i] ? (uint32_t)(cycles[i] / calls[i]) : 0;
+        total_cycles += cycles[i];
+    }
+    result->stage_num = pipeline->stage_num;
+    result->frames = bench->frames;
+    result->cycles_per_frame = (uint32_t)(total_cycles / bench->frames);
+    result->peak_heap_bytes = doa->stats.instance_heap_bytes + (uint32_t)(free_start - free_min);
+    int64_t audio_us = (int64_t)bench->frames * AUDIO_DOA_FRAME_SAMPLES * 1000000 / AUDIO_DOA_SAMPLE_RATE;
+    result->real_time_factor = (float)busy_us / (float)audio_us;
+    result->peak_stack_bytes = CONFIG_AUDIO_DOA_TASK_STACK_SIZE - uxTaskGetStackHighWaterMark(NULL);
+    xSemaphoreGive(bench->done);
+    vTaskDelete(NULL);
+}
 
-        extract_mic_data(doa);
-        float estimated_direction = esp_doa_process(doa->doa_handle, doa->mic_data[MIC_DIRECTION_LEFT], doa->mic_data[MIC_DIRECTION_RIGHT]);
-        // if (rms_value >= 80.0f && doa->doa_history_index > 0) {
-            // doa->doa_history[doa->doa_history_index] = doa->doa_history[doa->doa_history_index - 1];
-        // } else{
-            doa->doa_history[doa->doa_history_index] = estimated_direction;
-        // }
-        // doa->doa_history[doa->doa_history_index] = estimated_direction;
-        float filtered_direction = moving_weighted_average(doa->doa_history, DOA_WINDOW_SIZE, doa->gaussian_weights, doa->doa_history_index);
-        doa->doa_history_index = (doa->doa_history_index + 1) % DOA_WINDOW_SIZE;
-        float calibrated_direction = doa_angle_calibration(filtered_direction);
-        if (doa->cb) {
-            doa->cb(calibrated_direction, doa->ctx);
+static void audio_doa_chain_deinit(audio_doa_chain_t *chain)
+{
+    for (int i = 0; i < AUDIO_DOA_MAX_MICS; i++) {
+        if (chain->mic_data[i]) {
+            free(chain->mic_data[i]);
+        }
+#if CONFIG_AUDIO_DOA_DECIMATION
+        if (chain->decim_buf[i]) {
+            free(chain->decim_buf[i]);
+        }
+#endif  /* CONFIG_AUDIO_DOA_DECIMATION */
+#if CONFIG_AUDIO_DOA_ADAPTIVE_WINDOW
+        if (chain->history[i]) {
+            free(chain->history[i]);
+        }
+#endif  /* CONFIG_AUDIO_DOA_ADAPTIVE_WINDOW */
+    }
+    for (int w = 0; w < AUDIO_DOA_WINDOW_NUM; w++) {
+        audio_doa_engine_inst_t *inst = &chain->engines[w];
+#if CONFIG_AUDIO_DOA_ENGINE_ESP_SR
+        if (inst->doa_handle) {
+            esp_doa_destroy(inst->doa_handle);
+        }
+#endif  /* CONFIG_AUDIO_DOA_ENGINE_ESP_SR */
+#if CONFIG_AUDIO_DOA_ENGINE_SRP_PHAT
+        if (inst->srp) {
+            audio_doa_srp_destroy(inst->srp);
+        }
+#endif  /* CONFIG_AUDIO_DOA_ENGINE_SRP_PHAT */
+#if CONFIG_AUDIO_DOA_ENGINE_ONE_BIT
+        if (inst->onebit) {
+            audio_doa_onebit_destroy(inst->onebit);
         }
+#endif  /* CONFIG_AUDIO_DOA_ENGINE_ONE_BIT */
+    }
+    memset(chain, 0, sizeof(*chain));
+}
 
-        vTaskDelay(pdMS_TO_TICKS(10));
+static void audio_doa_free_resources(audio_doa_t *doa)
+{
+    audio_doa_chain_deinit(&doa->primary);
+#if CONFIG_AUDIO_DOA_SHADOW
+    if (doa->shadow) {
+        audio_doa_chain_deinit(doa->shadow);
+        free(doa->shadow);
+    }
+    if (doa->shadow_frame) {
+        free(doa->shadow_frame);
+    }
+#endif  /* CONFIG_AUDIO_DOA_SHADOW */
+    if (doa->audio_data) {
+        free(doa->audio_data);
+    }
+    free(doa->bad_frames);
+    if (doa->stream_buffer) {
+        vStreamBufferDelete(doa->stream_buffer);
+    }
+    if (doa->event_group) {
+        vEventGroupDelete(doa->event_group);
+    }
+    free(doa);
+}
+
+static esp_err_t audio_doa_chain_create_engine(audio_doa_t *doa, audio_doa_chain_t *chain, audio_doa_config_t *config,
+                                               audio_doa_engine_inst_t *inst, int samples)
+{
+    // The engines derive their lag range from the geometry and the rate they are created with
+    int sample_rate = chain->sample_rate;
+    float distance = config->distance > 0.0f ? config->distance : AUDIO_DOA_DEFAULT_DISTANCE;
+
+#if CONFIG_AUDIO_DOA_ENGINE_SRP_PHAT
+    if (chain->engine == AUDIO_DOA_ENGINE_SRP_PHAT) {
+        audio_doa_mic_pos_t linear_pos[AUDIO_DOA_MAX_MICS];
+        const audio_doa_mic_pos_t *mic_pos = config->mic_pos;
+        bool has_geometry = false;
+        for (int i = 0; i < doa->mic_num; i++) {
+            has_geometry |= (mic_pos[i].x != 0.0f || mic_pos[i].y != 0.0f);
+        }
+        if (!has_geometry) {
+            // Uniform linear array along x, microphone 0 on the 0 degree side
+            for (int i = 0; i < doa->mic_num; i++) {
+                linear_pos[i].x = (i - (doa->mic_num - 1) / 2.0f) * distance;
+                linear_pos[i].y = 0.0f;
+            }
+            mic_pos = linear_pos;
+        }
+        audio_doa_srp_cfg_t srp_cfg = {
+            .sample_rate = sample_rate,
+            .frame_samples = samples,
+            .mic_num = doa->mic_num,
+            .mic_pos = mic_pos,
+        };
+        inst->srp = audio_doa_srp_create(&srp_cfg);
+        return inst->srp ? ESP_OK : ESP_ERR_NO_MEM;
+    }
+#endif  /* CONFIG_AUDIO_DOA_ENGINE_SRP_PHAT */
+
+    if (chain->engine != AUDIO_DOA_ENGINE_ESP_SR && chain->engine != AUDIO_DOA_ENGINE_ONE_BIT) {
+        ESP_LOGE(TAG, "DOA engine %d is not enabled in this build", chain->engine);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    if (doa->mic_num != 2) {
+        ESP_LOGE(TAG, "Pairwise DOA engines support two microphones only");
+        return ESP_ERR_INVALID_ARG;
+    }
+#if CONFIG_AUDIO_DOA_ENGINE_ONE_BIT
+    if (chain->engine == AUDIO_DOA_ENGINE_ONE_BIT) {
+        inst->onebit = audio_doa_onebit_create(sample_rate, distance, samples);
+        return inst->onebit ? ESP_OK : ESP_ERR_NO_MEM;
+    }
+#endif  /* CONFIG_AUDIO_DOA_ENGINE_ONE_BIT */
+#if CONFIG_AUDIO_DOA_ENGINE_ESP_SR
+    if (chain->engine == AUDIO_DOA_ENGINE_ESP_SR) {
+        inst->doa_handle = esp_doa_create(sample_rate, 10, distance, samples);
+        return inst->doa_handle ? ESP_OK : ESP_ERR_NO_MEM;
+    }
+#endif  /* CONFIG_AUDIO_DOA_ENGINE_ESP_SR */
+    ESP_LOGE(TAG, "DOA engine %d is not enabled in this build", chain->engine);
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+static audio_doa_stage_process_t audio_doa_engine_stage(audio_doa_engine_t engine)
+{
+    switch (engine) {
+#if CONFIG_AUDIO_DOA_ENGINE_ESP_SR
+    case AUDIO_DOA_ENGINE_ESP_SR:
+        return audio_doa_stage_esp_sr;
+#endif  /* CONFIG_AUDIO_DOA_ENGINE_ESP_SR */
+#if CONFIG_AUDIO_DOA_ENGINE_SRP_PHAT
+    case AUDIO_DOA_ENGINE_SRP_PHAT:
+        return audio_doa_stage_srp;
+#endif  /* CONFIG_AUDIO_DOA_ENGINE_SRP_PHAT */
+#if CONFIG_AUDIO_DOA_ENGINE_ONE_BIT
+    case AUDIO_DOA_ENGINE_ONE_BIT:
+        return audio_doa_stage_onebit;
+#endif  /* CONFIG_AUDIO_DOA_ENGINE_ONE_BIT */
+    default:
+        return NULL;
     }
 }
 
+static esp_err_t audio_doa_chain_init(audio_doa_t *doa, audio_doa_chain_t *chain, audio_doa_engine_t engine,
+                                      bool decimate, bool adaptive, audio_doa_config_t *config)
+{
+    chain->engine = engine;
+    chain->decimate = decimate;
+    chain->window = AUDIO_DOA_WINDOW_FRAME;
+    chain->samples = decimate ? AUDIO_DOA_FRAME_SAMPLES / DECIM_FACTOR : AUDIO_DOA_FRAME_SAMPLES;
+    chain->sample_rate = decimate ? AUDIO_DOA_SAMPLE_RATE / DECIM_FACTOR : AUDIO_DOA_SAMPLE_RATE;
+    chain->pipeline.timed = config->stage_timing;
+    chain->pipeline.instance_id = doa->stats.instance_id;
+#if CONFIG_AUDIO_DOA_ADAPTIVE_WINDOW
+    chain->stats_lock = &doa->stats_lock;
+#endif  /* CONFIG_AUDIO_DOA_ADAPTIVE_WINDOW */
+#if CONFIG_AUDIO_DOA_SMOOTHING
+    chain->gaussian_weights = s_gaussian_weights;
+#endif  /* CONFIG_AUDIO_DOA_SMOOTHING */
+#if !CONFIG_AUDIO_DOA_DECIMATION
+    if (decimate) {
+        ESP_LOGE(TAG, "Decimation is not enabled in this build");
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+#endif  /* !CONFIG_AUDIO_DOA_DECIMATION */
+#if !CONFIG_AUDIO_DOA_ADAPTIVE_WINDOW
+    if (adaptive) {
+        ESP_LOGE(TAG, "Adaptive analysis window is not enabled in this build");
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+#endif  /* !CONFIG_AUDIO_DOA_ADAPTIVE_WINDOW */
+#if AUDIO_DOA_SPECIALIZE
+    static void (*const deinterleave_fixed[AUDIO_DOA_MAX_MICS + 1])(int16_t *const *, const int16_t *) = {
+        [2] = deinterleave_2ch,
+#if AUDIO_DOA_MAX_MICS >= 3
+        [3] = deinterleave_3ch,
+#endif
+#if AUDIO_DOA_MAX_MICS >= 4
+        [4] = deinterleave_4ch,
+#endif
+    };
+    chain->deinterleave = deinterleave_fixed[doa->mic_num];
+#endif  /* AUDIO_DOA_SPECIALIZE */
+    for (int i = 0; i < doa->mic_num; i++) {
+        chain->mic_data[i] = (int16_t *)calloc(AUDIO_DOA_FRAME_SAMPLES, sizeof(int16_t));
+        if (chain->mic_data[i] == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+        chain->window_data[i] = chain->mic_data[i];
+#if CONFIG_AUDIO_DOA_ADAPTIVE_WINDOW
+        if (adaptive) {
+            chain->history[i] = (int16_t *)calloc(2 * chain->samples, sizeof(int16_t));
+            if (chain->history[i] == NULL) {
+                return ESP_ERR_NO_MEM;
+            }
+        }
+#endif  /* CONFIG_AUDIO_DOA_ADAPTIVE_WINDOW */
+#if CONFIG_AUDIO_DOA_DECIMATION
+        if (chain->decimate) {
+            chain->decim_buf[i] = (int16_t *)calloc(AUDIO_DOA_FRAME_SAMPLES + DECIM_FIR_HISTORY, sizeof(int16_t));
+            if (chain->decim_buf[i] == NULL) {
+                return ESP_ERR_NO_MEM;
+            }
+        }
+#endif  /* CONFIG_AUDIO_DOA_DECIMATION */
+    }
+    esp_err_t ret = audio_doa_chain_create_engine(doa, chain, config, &chain->engines[AUDIO_DOA_WINDOW_FRAME], chain->samples);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    audio_doa_stage_process_t engine_stage = audio_doa_engine_stage(chain->engine);
+#if CONFIG_AUDIO_DOA_ADAPTIVE_WINDOW
+    if (adaptive) {
+        for (int w = 0; w < AUDIO_DOA_WINDOW_NUM; w++) {
+            if (w == AUDIO_DOA_WINDOW_FRAME) {
+                continue;
+            }
+            ret = audio_doa_chain_create_engine(doa, chain, config, &chain->engines[w], WINDOW_SAMPLES(chain->samples, w));
+            if (ret != ESP_OK) {
+                ESP_LOGE(TAG, "Engine does not support a %d sample window", WINDOW_SAMPLES(chain->samples, w));
+                return ret;
+            }
+        }
+        chain->adaptive = true;
+        atomic_init(&chain->requested_window, AUDIO_DOA_WINDOW_FRAME);
+        chain->engine_process = engine_stage;
+        engine_stage = audio_doa_stage_windowed;
+    }
+#endif  /* CONFIG_AUDIO_DOA_ADAPTIVE_WINDOW */
+
+    audio_doa_stage_t stages[] = {
+        {"conditioning", AUDIO_DOA_STAGE_CONDITIONING, audio_doa_stage_condition, chain},
+        {"engine", AUDIO_DOA_STAGE_ENGINE, engine_stage, chain},
+#if CONFIG_AUDIO_DOA_SMOOTHING
+        {"smoothing", AUDIO_DOA_STAGE_SMOOTHING, audio_doa_stage_smooth, chain},
+#endif  /* CONFIG_AUDIO_DOA_SMOOTHING */
+#if CONFIG_AUDIO_DOA_CALIBRATION
+        // The edge correction compensates esp-sr's compression near 0/180 degrees,
+        // the other engines map lags to angles geometrically
+        {"calibration", AUDIO_DOA_STAGE_CALIBRATION, audio_doa_stage_calibrate, NULL},
+#endif  /* CONFIG_AUDIO_DOA_CALIBRATION */
+    };
+    for (size_t i = 0; i < sizeof(stages) / sizeof(stages[0]); i++) {
+        if ((stages[i].kind == AUDIO_DOA_STAGE_SMOOTHING && config->disable_smoothing) ||
+            (stages[i].kind == AUDIO_DOA_STAGE_CALIBRATION && chain->engine != AUDIO_DOA_ENGINE_ESP_SR)) {
+            continue;
+        }
+        audio_doa_pipeline_add(&chain->pipeline, &stages[i]);
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief  Add the gate, shadow tap, custom stages and result sink around the primary chain
+ */
+static esp_err_t audio_doa_build_primary_pipeline(audio_doa_t *doa, audio_doa_config_t *config)
+{
+    audio_doa_pipeline_t *pipeline = &doa->primary.pipeline;
+    doa->gate_rms = config->gate_rms;
+    if (doa->gate_rms > 0.0f) {
+        audio_doa_stage_t gate = {"gate", AUDIO_DOA_STAGE_GATING, audio_doa_stage_gate, doa};
+        audio_doa_pipeline_add(pipeline, &gate);
+    }
+#if CONFIG_AUDIO_DOA_SHADOW
+    if (config->shadow) {
+        audio_doa_stage_t tap = {"shadow_tap", AUDIO_DOA_STAGE_GATING, audio_doa_stage_shadow_tap, doa};
+        audio_doa_pipeline_add(pipeline, &tap);
+    }
+#endif  /* CONFIG_AUDIO_DOA_SHADOW */
+    for (int i = 0; i < config->stage_num; i++) {
+        esp_err_t ret = audio_doa_pipeline_add(pipeline, &config->stages[i]);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to add stage %d", i);
+            return ret;
+        }
+    }
+    audio_doa_stage_t sink = {"sink", AUDIO_DOA_STAGE_SINK, audio_doa_stage_sink, doa};
+    return audio_doa_pipeline_add(pipeline, &sink);
+}
+
+/**
+ * @brief  Make both tasks leave their loops and delete them once they have parked
+ *
+ *         Waits without a timeout: a task still in a frame or batch finishes it first,
+ *         and may hand that frame to the shadow, so the DOA task goes first.
+ */
+static void audio_doa_delete_tasks(audio_doa_t *doa)
+{
+    xEventGroupSetBits(doa->event_group, EXIT_BIT);
+    if (doa->task_handle != NULL) {
+        xTaskNotifyGive(doa->task_handle);  // Cut a batched sleep short
+        xEventGroupWaitBits(doa->event_group, TASK_EXITED_BIT, pdFALSE, pdFALSE, portMAX_DELAY);
+        vTaskDelete(doa->task_handle);
+        doa->task_handle = NULL;
+    }
+#if CONFIG_AUDIO_DOA_SHADOW
+    if (doa->shadow_task_handle != NULL) {
+        xTaskNotifyGive(doa->shadow_task_handle);
+        xEventGroupWaitBits(doa->event_group, SHADOW_EXITED_BIT, pdFALSE, pdFALSE, portMAX_DELAY);
+        vTaskDelete(doa->shadow_task_handle);
+        doa->shadow_task_handle = NULL;
+    }
+#endif  /* CONFIG_AUDIO_DOA_SHADOW */
+}
+
 esp_err_t audio_doa_new(audio_doa_handle_t *doa_handle, audio_doa_config_t *config)
 {
     if (doa_handle == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
+    audio_doa_config_t default_config = {0};
+    if (config == NULL) {
+        config = &default_config;
+    }
+    int mic_num = config->mic_num > 0 ? config->mic_num : AUDIO_DOA_DEFAULT_MICS;
+    if (mic_num < 2 || mic_num > AUDIO_DOA_MAX_MICS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+#if !CONFIG_AUDIO_DOA_SHADOW
+    if (config->shadow) {
+        ESP_LOGE(TAG, "Shadow mode is not enabled in this build");
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+#endif  /* !CONFIG_AUDIO_DOA_SHADOW */
+    if (config->synchronous && config->shadow) {
+        ESP_LOGE(TAG, "Shadow mode needs its own task, not available for synchronous instances");
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    int64_t create_start_us = esp_timer_get_time();
+    size_t heap_before = heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
 
-    audio_doa_t *doa = (audio_doa_t *)malloc(sizeof(audio_doa_t));
+    audio_doa_t *doa = (audio_doa_t *)calloc(1, sizeof(audio_doa_t));
     if (doa == NULL) {
         return ESP_ERR_NO_MEM;
     }
-    memset(doa, 0, sizeof(audio_doa_t));
     doa->state = AUDIO_DOA_STATE_IDLE;
-    doa->cb = NULL;
-    doa->ctx = NULL;
-    doa->doa_handle = NULL;
-    doa->doa_history_index = 0;
+    doa->create_start_us = create_start_us;
+    doa->stats_lock = (portMUX_TYPE)portMUX_INITIALIZER_UNLOCKED;
+    static atomic_uint s_next_instance_id = 1;
+    doa->stats.instance_id = atomic_fetch_add(&s_next_instance_id, 1) & INSTANCE_ID_MASK;
+    doa->gap_policy = config->gap_policy;
+    doa->stats.deadline_us = config->deadline_us ? config->deadline_us : AUDIO_DOA_FRAME_US;
+    doa->deadline_miss_limit = config->deadline_miss_limit ? config->deadline_miss_limit : DEADLINE_DEFAULT_MISS_LIMIT;
+    doa->deadline_window_frames = config->deadline_window_frames ? config->deadline_window_frames : DEADLINE_DEFAULT_WINDOW_FRAMES;
+    doa->mic_num = mic_num;
+    doa->frame_bytes = AUDIO_DOA_FRAME_SAMPLES * mic_num * sizeof(int16_t);
 
     doa->event_group = xEventGroupCreate();
     if (doa->event_group == NULL) {
-        free(doa);
+        audio_doa_free_resources(doa);
         return ESP_ERR_NO_MEM;
     }
-    doa->stream_buffer = xStreamBufferCreate(AUDIO_DOA_DATA_BUS_SIZE * 3, AUDIO_DOA_DATA_BUS_SIZE);
-    if (doa->stream_buffer == NULL) {
-        vEventGroupDelete(doa->event_group);
-        free(doa);
-        ESP_LOGE(TAG, "Failed to create stream buffer");
-        return ESP_ERR_NO_MEM;
+    // The task starts parked, stages can be added right after creation without waiting
+    xEventGroupSetBits(doa->event_group, PARKED_BIT);
+    int buffer_frames = AUDIO_DOA_STREAM_FRAMES;
+    doa->batch_interval_ms = config->batch_interval_ms;
+    if (doa->batch_interval_ms > 0) {
+        // Room for everything captured during one sleep plus the threshold batch
+        int interval_frames = (doa->batch_interval_ms * AUDIO_DOA_SAMPLE_RATE / 1000 + AUDIO_DOA_FRAME_SAMPLES - 1) / AUDIO_DOA_FRAME_SAMPLES;
+        int wanted = (config->batch_frames > interval_frames ? config->batch_frames : interval_frames) + 2;
+        buffer_frames = wanted > buffer_frames ? wanted : buffer_frames;
+        if (config->batch_frames > 0) {
+            doa->batch_notify_bytes = config->batch_frames * doa->frame_bytes;
+        }
     }
-    int samples = AUDIO_DOA_DATA_BUS_SIZE / (sizeof(int16_t) * 2);
-    doa->doa_handle = esp_doa_create(16000, 10, config->distance > 0.0f ? config->distance : 0.046, samples);
-    if (doa->doa_handle == NULL) {
-        vStreamBufferDelete(doa->stream_buffer);
-        vEventGroupDelete(doa->event_group);
-        free(doa);
+    // Every frame in the buffer plus the one being received and the one being written
+    // needs its own bit, or a discarded frame would hide behind a good one
+    doa->bad_frame_slots = BAD_FRAME_WORD_BITS;
+    while (doa->bad_frame_slots < (uint32_t)buffer_frames + 2) {
+        doa->bad_frame_slots <<= 1;
+    }
+    doa->bad_frames = (atomic_uint *)calloc(doa->bad_frame_slots / BAD_FRAME_WORD_BITS, sizeof(atomic_uint));
+    if (doa->bad_frames == NULL) {
+        audio_doa_free_resources(doa);
         return ESP_ERR_NO_MEM;
     }
-    doa->audio_data = (uint8_t *)calloc(AUDIO_DOA_DATA_BUS_SIZE, sizeof(uint8_t));
+    for (uint32_t i = 0; i < doa->bad_frame_slots / BAD_FRAME_WORD_BITS; i++) {
+        atomic_init(&doa->bad_frames[i], 0);
+    }
+    if (!config->synchronous) {
+        doa->stream_buffer = xStreamBufferCreate(doa->frame_bytes * buffer_frames, doa->frame_bytes);
+        if (doa->stream_buffer == NULL) {
+            audio_doa_free_resources(doa);
+            ESP_LOGE(TAG, "Failed to create stream buffer");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    doa->audio_data = (uint8_t *)calloc(doa->frame_bytes, sizeof(uint8_t));
     if (doa->audio_data == NULL) {
-        esp_doa_destroy(doa->doa_handle);
-        vStreamBufferDelete(doa->stream_buffer);
-        vEventGroupDelete(doa->event_group);
-        free(doa);
+        audio_doa_free_resources(doa);
         return ESP_ERR_NO_MEM;
     }
-    doa->audio_data_size = AUDIO_DOA_DATA_BUS_SIZE;
+    doa->audio_data_size = doa->frame_bytes;
 
-    doa->gaussian_weights = (float *)calloc(DOA_WINDOW_SIZE, sizeof(float));
-    if (doa->gaussian_weights == NULL) {
-        free(doa->audio_data);
-        esp_doa_destroy(doa->doa_handle);
-        vStreamBufferDelete(doa->stream_buffer);
-        vEventGroupDelete(doa->event_group);
-        free(doa);
-        return ESP_ERR_NO_MEM;
+    esp_err_t ret = audio_doa_chain_init(doa, &doa->primary, config->engine, config->decimate, config->adaptive_window, config);
+    if (ret != ESP_OK) {
+        audio_doa_free_resources(doa);
+        return ret;
+    }
+    ret = audio_doa_build_primary_pipeline(doa, config);
+    if (ret != ESP_OK) {
+        audio_doa_free_resources(doa);
+        return ret;
     }
-    generate_gaussian_weights(doa->gaussian_weights, DOA_WINDOW_SIZE, GAUSSIAN_SIGMA);
 
-    for (int i = 0; i < MIC_DIRECTION_MAX; i++) {
-        doa->mic_data[i] = (int16_t *)calloc(AUDIO_DOA_DATA_BUS_SIZE / (sizeof(int16_t) * 2), sizeof(int16_t));
-        if (doa->mic_data[i] == NULL) {
-            for (int j = 0; j < i; j++) {
-                free(doa->mic_data[j]);
-            }
-            free(doa->gaussian_weights);
-            free(doa->audio_data);
-            esp_doa_destroy(doa->doa_handle);
-            vStreamBufferDelete(doa->stream_buffer);
-            vEventGroupDelete(doa->event_group);
-            free(doa);
+#if CONFIG_AUDIO_DOA_SHADOW
+    if (config->shadow) {
+        doa->shadow = (audio_doa_chain_t *)calloc(1, sizeof(audio_doa_chain_t));
+        doa->shadow_frame = (uint8_t *)calloc(doa->frame_bytes, sizeof(uint8_t));
+        if (doa->shadow == NULL || doa->shadow_frame == NULL) {
+            audio_doa_free_resources(doa);
             return ESP_ERR_NO_MEM;
         }
+        ret = audio_doa_chain_init(doa, doa->shadow, config->shadow_engine, config->shadow_decimate, false, config);
+        if (ret != ESP_OK) {
+            audio_doa_free_resources(doa);
+            return ret;
+        }
+        doa->shadow->pipeline.instance_id = doa->stats.instance_id | AUDIO_DOA_PROFILING_SHADOW_BIT;
+        audio_doa_stage_t shadow_sink = {"shadow_sink", AUDIO_DOA_STAGE_SINK, audio_doa_stage_shadow_sink, doa};
+        audio_doa_pipeline_add(&doa->shadow->pipeline, &shadow_sink);
+        atomic_init(&doa->shadow_busy, false);
+        for (int i = 0; i < SHADOW_RING_SIZE; i++) {
+            atomic_init(&doa->primary_results[i], 0);
+        }
+        if (xTaskCreate(audio_doa_shadow_thread, "audio_doa_shadow", CONFIG_AUDIO_DOA_TASK_STACK_SIZE, doa,
+                        SHADOW_TASK_PRIORITY, &doa->shadow_task_handle) != pdPASS) {
+            audio_doa_free_resources(doa);
+            ESP_LOGE(TAG, "Failed to create audio DOA shadow thread");
+            return ESP_FAIL;
+        }
     }
+#endif  /* CONFIG_AUDIO_DOA_SHADOW */
 
-    BaseType_t ret = xTaskCreate(audio_doa_thread, "audio_doa_thread", 4096, doa, 10, &doa->task_handle);
-    if (ret != pdPASS) {
-        for (int i = 0; i < MIC_DIRECTION_MAX; i++) {
-            free(doa->mic_data[i]);
+    if (!config->synchronous) {
+        BaseType_t task_ret = xTaskCreate(audio_doa_thread, "audio_doa_thread", CONFIG_AUDIO_DOA_TASK_STACK_SIZE, doa,
+                                          CONFIG_AUDIO_DOA_TASK_PRIORITY, &doa->task_handle);
+        if (task_ret != pdPASS) {
+            audio_doa_delete_tasks(doa);
+            audio_doa_free_resources(doa);
+            ESP_LOGE(TAG, "Failed to create audio DOA thread");
+            return ESP_FAIL;
         }
-        free(doa->gaussian_weights);
-        free(doa->audio_data);
-        esp_doa_destroy(doa->doa_handle);
-        vStreamBufferDelete(doa->stream_buffer);
-        vEventGroupDelete(doa->event_group);
-        free(doa);
-        ESP_LOGE(TAG, "Failed to create audio DOA thread");
-        return ESP_FAIL;
     }
+    // Everything this instance took from the heap: buffers, engine state and task stacks
+    doa->stats.instance_heap_bytes = heap_before - heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+    doa->stats.create_us = (uint32_t)(esp_timer_get_time() - create_start_us);
 
     *doa_handle = (audio_doa_handle_t)doa;
     return ESP_OK;
 }
+
 esp_err_t audio_doa_delete(audio_doa_handle_t doa_handle)
 {
     if (doa_handle == NULL) {
@@ -284,35 +1312,8 @@ esp_err_t audio_doa_delete(audio_doa_handle_t doa_handle)
     audio_doa_t *doa = (audio_doa_t *)doa_handle;
 
     audio_doa_stop(doa_handle);
-
-    vTaskDelay(pdMS_TO_TICKS(100));
-
-    if (doa->task_handle != NULL) {
-        vTaskDelete(doa->task_handle);
-    }
-
-    if (doa->mic_data[MIC_DIRECTION_LEFT]) {
-        free(doa->mic_data[MIC_DIRECTION_LEFT]);
-    }
-    if (doa->mic_data[MIC_DIRECTION_RIGHT]) {
-        free(doa->mic_data[MIC_DIRECTION_RIGHT]);
-    }
-    if (doa->gaussian_weights) {
-        free(doa->gaussian_weights);
-    }
-    if (doa->audio_data) {
-        free(doa->audio_data);
-    }
-    if (doa->doa_handle) {
-        esp_doa_destroy(doa->doa_handle);
-    }
-    if (doa->stream_buffer) {
-        vStreamBufferDelete(doa->stream_buffer);
-    }
-    if (doa->event_group) {
-        vEventGroupDelete(doa->event_group);
-    }
-    free(doa);
+    audio_doa_delete_tasks(doa);
+    audio_doa_free_resources(doa);
     return ESP_OK;
 }
 
@@ -327,13 +1328,41 @@ esp_err_t audio_doa_set_doa_result_callback(audio_doa_handle_t doa_handle, audio
     return ESP_OK;
 }
 
+esp_err_t audio_doa_set_deadline_callback(audio_doa_handle_t doa_handle, audio_doa_deadline_callback_t cb, void *ctx)
+{
+    if (doa_handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    audio_doa_t *doa = (audio_doa_t *)doa_handle;
+    doa->deadline_cb = cb;
+    doa->deadline_ctx = ctx;
+    return ESP_OK;
+}
+
+esp_err_t audio_doa_set_window(audio_doa_handle_t doa_handle, audio_doa_window_t window)
+{
+    if (doa_handle == NULL || (int)window < 0 || window >= AUDIO_DOA_WINDOW_NUM) {
+        return ESP_ERR_INVALID_ARG;
+    }
+#if CONFIG_AUDIO_DOA_ADAPTIVE_WINDOW
+    audio_doa_t *doa = (audio_doa_t *)doa_handle;
+    if (!doa->primary.adaptive) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    atomic_store(&doa->primary.requested_window, (int)window);
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif  /* CONFIG_AUDIO_DOA_ADAPTIVE_WINDOW */
+}
+
 esp_err_t audio_doa_start(audio_doa_handle_t doa_handle)
 {
     if (doa_handle == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
     audio_doa_t *doa = (audio_doa_t *)doa_handle;
-    if (doa->doa_handle == NULL) {
+    if (doa->primary.pipeline.stage_num == 0) {
         return ESP_FAIL;
     }
     doa->state = AUDIO_DOA_STATE_RUNNING;
@@ -352,6 +1381,39 @@ esp_err_t audio_doa_stop(audio_doa_handle_t doa_handle)
     return ESP_OK;
 }
 
+static void audio_doa_advance_tx(audio_doa_t *doa, size_t bytes)
+{
+    doa->tx_fill += bytes;
+    doa->tx_frame_seq += doa->tx_fill / doa->frame_bytes;
+    doa->tx_fill %= doa->frame_bytes;
+}
+
+/**
+ * @brief  Write `bytes` of silence, or nothing at all when the stream buffer has no room for them
+ */
+static esp_err_t audio_doa_write_silence(audio_doa_t *doa, int bytes)
+{
+    static const uint8_t silence[64] = {0};
+    if (xStreamBufferSpacesAvailable(doa->stream_buffer) < (size_t)bytes) {
+        return ESP_FAIL;
+    }
+    while (bytes > 0) {
+        int chunk = bytes < (int)sizeof(silence) ? bytes : (int)sizeof(silence);
+        size_t sent = xStreamBufferSend(doa->stream_buffer, silence, chunk, 0);
+        audio_doa_advance_tx(doa, sent);
+        bytes -= sent;
+    }
+    return ESP_OK;
+}
+
+static inline void audio_doa_batch_notify(audio_doa_t *doa)
+{
+    if (doa->batch_notify_bytes > 0 && doa->task_handle != NULL &&
+        xStreamBufferBytesAvailable(doa->stream_buffer) >= doa->batch_notify_bytes) {
+        xTaskNotifyGive(doa->task_handle);
+    }
+}
+
 esp_err_t audio_doa_data_write(audio_doa_handle_t doa_handle, uint8_t *data, int data_size)
 {
     if (doa_handle == NULL || data == NULL || data_size <= 0) {
@@ -364,6 +1426,8 @@ esp_err_t audio_doa_data_write(audio_doa_handle_t doa_handle, uint8_t *data, int
     }
     
     size_t bytes_sent = xStreamBufferSend(doa->stream_buffer, data, data_size, pdMS_TO_TICKS(10));
+    audio_doa_advance_tx(doa, bytes_sent);
+    audio_doa_batch_notify(doa);
     if (bytes_sent != data_size) {
         return ESP_FAIL;
     }
@@ -371,3 +1435,273 @@ esp_err_t audio_doa_data_write(audio_doa_handle_t doa_handle, uint8_t *data, int
     return ESP_OK;
 }
 
+esp_err_t audio_doa_data_write_with_seq(audio_doa_handle_t doa_handle, uint8_t *data, int data_size, uint64_t sample_index)
+{
+    if (doa_handle == NULL || data == NULL || data_size <= 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    audio_doa_t *doa = (audio_doa_t *)doa_handle;
+    int stride = doa->mic_num * sizeof(int16_t);
+    if (data_size % stride != 0) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (doa->stream_buffer == NULL) {
+        return ESP_FAIL;
+    }
+
+    if (!doa->seq_valid) {
+        doa->seq_valid = true;
+        doa->next_sample_index = sample_index;
+    }
+    if (sample_index < doa->next_sample_index) {
+        uint64_t overlap = doa->next_sample_index - sample_index;
+        bool covered = overlap * stride >= (uint64_t)data_size;
+        portENTER_CRITICAL(&doa->stats_lock);
+        doa->stats.overlap_events++;
+        doa->stats.samples_dropped += covered ? (uint32_t)(data_size / stride) : (uint32_t)overlap;
+        portEXIT_CRITICAL(&doa->stats_lock);
+        if (covered) {
+            return ESP_OK;
+        }
+        data += overlap * stride;
+        data_size -= overlap * stride;
+        sample_index = doa->next_sample_index;
+    } else if (sample_index > doa->next_sample_index) {
+        uint64_t gap = sample_index - doa->next_sample_index;
+        uint32_t discarded = 0;
+        uint32_t zero_filled = 0;
+        if (doa->tx_fill > 0) {
+            int pad_bytes = doa->frame_bytes - doa->tx_fill;
+            if (doa->gap_policy == AUDIO_DOA_GAP_ZERO_FILL && gap * stride < (uint64_t)pad_bytes) {
+                pad_bytes = gap * stride;  // The frame continues after a short run of silence
+            }
+            // Mark the frame before the padding completes it: the DOA task may take it
+            // the moment its last byte is in the stream buffer
+            unsigned int frame_bit;
+            atomic_uint *word = audio_doa_bad_frame_word(doa, doa->tx_frame_seq, &frame_bit);
+            bool discard = doa->gap_policy != AUDIO_DOA_GAP_ZERO_FILL;
+            if (discard) {
+                atomic_fetch_or(word, frame_bit);
+            }
+            if (audio_doa_write_silence(doa, pad_bytes) != ESP_OK) {
+                // Nothing was written: the frame position and next_sample_index still
+                // describe the stream, only the mark is undone. The gap stays pending
+                // and is retried on the next write, this write's audio is lost
+                if (discard) {
+                    atomic_fetch_and(word, ~frame_bit);
+                }
+                portENTER_CRITICAL(&doa->stats_lock);
+                doa->stats.samples_dropped += data_size / stride;
+                portEXIT_CRITICAL(&doa->stats_lock);
+                return ESP_FAIL;
+            }
+            if (discard) {
+                discarded = 1;
+            } else {
+                zero_filled = pad_bytes / stride;
+            }
+        }
+        portENTER_CRITICAL(&doa->stats_lock);
+        doa->stats.gap_events++;
+        doa->stats.frames_discarded += discarded;
+        doa->stats.samples_zero_filled += zero_filled;
+        portEXIT_CRITICAL(&doa->stats_lock);
+        doa->next_sample_index = sample_index;
+    }
+
+    if (xStreamBufferSpacesAvailable(doa->stream_buffer) < (size_t)data_size) {
+        portENTER_CRITICAL(&doa->stats_lock);
+        doa->stats.samples_dropped += data_size / stride;
+        portEXIT_CRITICAL(&doa->stats_lock);
+        return ESP_FAIL;
+    }
+    size_t bytes_sent = xStreamBufferSend(doa->stream_buffer, data, data_size, 0);
+    audio_doa_advance_tx(doa, bytes_sent);
+    audio_doa_batch_notify(doa);
+    doa->next_sample_index += data_size / stride;
+    return ESP_OK;
+}
+
+esp_err_t audio_doa_process(audio_doa_handle_t doa_handle, const int16_t *data, int frames)
+{
+    if (doa_handle == NULL || data == NULL || frames < 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    audio_doa_t *doa = (audio_doa_t *)doa_handle;
+    if (doa->task_handle != NULL || doa->state != AUDIO_DOA_STATE_RUNNING) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    int frame_samples = AUDIO_DOA_FRAME_SAMPLES * doa->mic_num;
+    for (int i = 0; i < frames; i++) {
+        audio_doa_run_frame(doa, data + (size_t)i * frame_samples);
+    }
+    return ESP_OK;
+}
+
+esp_err_t audio_doa_get_stats(audio_doa_handle_t doa_handle, audio_doa_stats_t *stats)
+{
+    if (doa_handle == NULL || stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    audio_doa_t *doa = (audio_doa_t *)doa_handle;
+    const audio_doa_chain_t *chain = &doa->primary;
+    // Copy everything that is derived below in one go, the DOA, shadow and writer tasks keep counting
+    portENTER_CRITICAL(&doa->stats_lock);
+    *stats = doa->stats;
+#if CONFIG_AUDIO_DOA_SHADOW
+#if CONFIG_AUDIO_DOA_STAGE_TIMING
+    int64_t shadow_time_us = doa->shadow_time_us;
+#endif  /* CONFIG_AUDIO_DOA_STAGE_TIMING */
+    float disagreement_sum = doa->disagreement_sum;
+    uint32_t disagreement_count = doa->disagreement_count;
+#endif  /* CONFIG_AUDIO_DOA_SHADOW */
+#if CONFIG_AUDIO_DOA_ADAPTIVE_WINDOW
+    int64_t window_time_us[AUDIO_DOA_WINDOW_NUM];
+    for (int w = 0; w < AUDIO_DOA_WINDOW_NUM; w++) {
+        stats->windows[w].frames = chain->window_frames[w];
+        window_time_us[w] = chain->window_time_us[w];
+    }
+    stats->window_switches = chain->window_switches;
+#endif  /* CONFIG_AUDIO_DOA_ADAPTIVE_WINDOW */
+    portEXIT_CRITICAL(&doa->stats_lock);
+
+    stats->noise_floor_rms = doa->noise_floor_rms;
+    if (doa->stream_buffer != NULL) {
+        stats->queue_frames = (uint32_t)(xStreamBufferBytesAvailable(doa->stream_buffer) / doa->frame_bytes);
+    }
+#if CONFIG_AUDIO_DOA_STAGE_TIMING
+    stats->primary_chain_us = stats->frames_processed ? (uint32_t)(stats->frame_time_sum_us / stats->frames_processed) : 0;
+#endif  /* CONFIG_AUDIO_DOA_STAGE_TIMING */
+#if CONFIG_AUDIO_DOA_SHADOW && CONFIG_AUDIO_DOA_STAGE_TIMING
+    stats->shadow_chain_us = stats->shadow_frames ? (uint32_t)(shadow_time_us / stats->shadow_frames) : 0;
+#endif  /* CONFIG_AUDIO_DOA_SHADOW && CONFIG_AUDIO_DOA_STAGE_TIMING */
+#if CONFIG_AUDIO_DOA_SHADOW
+    stats->shadow_mean_disagreement_deg = disagreement_count ? disagreement_sum / disagreement_count : 0.0f;
+#endif  /* CONFIG_AUDIO_DOA_SHADOW */
+    for (int w = 0; w < AUDIO_DOA_WINDOW_NUM; w++) {
+        audio_doa_window_stats_t *window = &stats->windows[w];
+        bool available = (w == AUDIO_DOA_WINDOW_FRAME);
+#if CONFIG_AUDIO_DOA_ADAPTIVE_WINDOW
+        available |= chain->adaptive;
+        window->engine_us = window->frames ? (uint32_t)(window_time_us[w] / window->frames) : 0;
+#endif  /* CONFIG_AUDIO_DOA_ADAPTIVE_WINDOW */
+        if (available) {
+            // The newest sample is at the end of every window, its centre is half a window old
+            window->samples = WINDOW_SAMPLES(chain->samples, w);
+            window->latency_ms = window->samples * 1000 / 2 / chain->sample_rate;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t audio_doa_set_noise_floor(audio_doa_handle_t doa_handle, float rms)
+{
+    if (doa_handle == NULL || rms < 0.0f) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    audio_doa_t *doa = (audio_doa_t *)doa_handle;
+    doa->noise_floor_rms = rms;
+    return ESP_OK;
+}
+
+/**
+ * @brief  Wait until the DOA task of a stopped instance no longer touches the primary chain
+ *
+ *         Stopping only clears START_BIT, the task may still be finishing a frame.
+ */
+static esp_err_t audio_doa_wait_parked(audio_doa_t *doa)
+{
+    if (xEventGroupGetBits(doa->event_group) & START_BIT) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (doa->task_handle != NULL &&
+        !(xEventGroupWaitBits(doa->event_group, PARKED_BIT, pdFALSE, pdFALSE, pdMS_TO_TICKS(PARK_TIMEOUT_MS)) & PARKED_BIT)) {
+        return ESP_ERR_TIMEOUT;
+    }
+    return ESP_OK;
+}
+
+esp_err_t audio_doa_add_stage(audio_doa_handle_t doa_handle, const audio_doa_stage_t *stage)
+{
+    if (doa_handle == NULL || stage == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    audio_doa_t *doa = (audio_doa_t *)doa_handle;
+    if (doa->state == AUDIO_DOA_STATE_RUNNING) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    // The stage slots are moved in place, the task must not be walking them
+    esp_err_t ret = audio_doa_wait_parked(doa);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    return audio_doa_pipeline_add(&doa->primary.pipeline, stage);
+}
+
+esp_err_t audio_doa_get_stage_stats(audio_doa_handle_t doa_handle, audio_doa_stage_stats_t *stats, int max_count, int *count)
+{
+    if (doa_handle == NULL || stats == NULL || count == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    audio_doa_t *doa = (audio_doa_t *)doa_handle;
+    *count = audio_doa_pipeline_get_stats(&doa->primary.pipeline, stats, max_count);
+    return ESP_OK;
+}
+
+esp_err_t audio_doa_benchmark(audio_doa_handle_t doa_handle, uint32_t frames, audio_doa_benchmark_t *result)
+{
+    if (doa_handle == NULL || result == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    audio_doa_t *doa = (audio_doa_t *)doa_handle;
+    esp_err_t ret = audio_doa_wait_parked(doa);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    memset(result, 0, sizeof(*result));
+    audio_doa_bench_t bench = {
+        .doa = doa,
+        .frames = frames ? frames : BENCH_DEFAULT_FRAMES,
+        .result = result,
+        .done = xSemaphoreCreateBinary(),
+        .frame = (int16_t *)malloc(doa->frame_bytes),
+        .seed = 1,
+    };
+    if (bench.done == NULL || bench.frame == NULL) {
+        if (bench.done != NULL) {
+            vSemaphoreDelete(bench.done);
+        }
+        free(bench.frame);
+        return ESP_ERR_NO_MEM;
+    }
+    // Cycle counters are per core, so keep the benchmark on the caller's core
+    if (xTaskCreatePinnedToCore(audio_doa_bench_thread, "audio_doa_bench", CONFIG_AUDIO_DOA_TASK_STACK_SIZE, &bench,
+                                CONFIG_AUDIO_DOA_TASK_PRIORITY, NULL, xPortGetCoreID()) != pdPASS) {
+        vSemaphoreDelete(bench.done);
+        free(bench.frame);
+        ESP_LOGE(TAG, "Failed to create audio DOA benchmark thread");
+        return ESP_ERR_NO_MEM;
+    }
+    xSemaphoreTake(bench.done, portMAX_DELAY);
+    vSemaphoreDelete(bench.done);
+    free(bench.frame);
+    return ESP_OK;
+}
+
+esp_err_t audio_doa_set_shadow_result_callback(audio_doa_handle_t doa_handle, audio_doa_callback_t cb, void *ctx)
+{
+    if (doa_handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+#if CONFIG_AUDIO_DOA_SHADOW
+    audio_doa_t *doa = (audio_doa_t *)doa_handle;
+    if (doa->shadow == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    doa->shadow_cb = cb;
+    doa->shadow_ctx = ctx;
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif  /* CONFIG_AUDIO_DOA_SHADOW */
+}
@@ -1,10 +1,27 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+#include <stdatomic.h>
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
 #include "esp_heap_caps.h"
 #include "esp_log.h"
 #include "esp_err.h"
+#include "esp_timer.h"
+#include "esp_rom_crc.h"
 #include "audio_doa_app.h"
 #include "audio_doa.h"
+#if CONFIG_AUDIO_DOA_TRACKER
 #include "audio_doa_tracker.h"
+#endif  /* CONFIG_AUDIO_DOA_TRACKER */
+#if CONFIG_AUDIO_DOA_ANGLE_LOG
+#include "audio_doa_log.h"
+#endif  /* CONFIG_AUDIO_DOA_ANGLE_LOG */
 
 #ifdef __cplusplus
 extern "C" {
@@ -12,82 +29,452 @@ extern "C" {
 
 static const char *TAG = "audio_doa_app";
 
+#define SHADOW_TRACKER (CONFIG_AUDIO_DOA_TRACKER && CONFIG_AUDIO_DOA_SHADOW)
+#define SHADOW_TRACKER_AGREE_DEG 10.0f  // Tracker outputs are 20 degree bin centers, so any bin change counts
+
+#define INIT_TASK_PRIORITY 5  // Background creation, below the DOA task
+
+#define ADAPTIVE_TRACKER (CONFIG_AUDIO_DOA_TRACKER && CONFIG_AUDIO_DOA_ADAPTIVE_WINDOW)
+#define WINDOW_DEFAULT_MOVING_DPS 30.0f
+#define WINDOW_DEFAULT_STILL_DPS  10.0f
+
+#define TRACKER_DEFAULT_MAX_AGE_MS          3000
+#define TRACKER_DEFAULT_SILENCE_TIMEOUT_MS  1000  // Longer than VAD dropouts inside one utterance
+#define INPUT_SAMPLES_PER_MS                16    // audio_doa_app_data_write() takes 16 kHz audio
+
+#define STATE_MAGIC          0x57414F44u  // "DOAW"
+#define STATE_VERSION        1
+#define STATE_FLAG_ANGLE     (1 << 0)
+#define STATE_FLAG_FRONT     (1 << 1)
+
+/**
+ * @brief  Warm-start blob, little-endian as stored by the target
+ */
+typedef struct {
+    uint32_t  magic;
+    uint16_t  version;
+    uint16_t  size;             /*!< sizeof(audio_doa_app_state_t) */
+    float     angle;            /*!< Tracker's last stable direction, valid with STATE_FLAG_ANGLE */
+    uint8_t   flags;
+    uint8_t   reserved[3];
+    float     noise_floor_rms;  /*!< Gating stage noise floor (0 = unknown) */
+    uint32_t  crc;              /*!< CRC32 of all preceding bytes */
+} audio_doa_app_state_t;
+
+_Static_assert(sizeof(audio_doa_app_state_t) == AUDIO_DOA_APP_STATE_SIZE, "AUDIO_DOA_APP_STATE_SIZE out of date");
+
 typedef struct {
     audio_doa_handle_t                          doa_handle;
+#if CONFIG_AUDIO_DOA_TRACKER
     audio_doa_tracker_handle_t                  doa_tracker_handle;
+    int                                         mic_num;
+    uint32_t                                    skipped_samples;  /*!< Writer side: dropped per-channel samples below one ms */
+    atomic_uint                                 skipped_ms;  /*!< Audio dropped outside VAD, keeps the tracker's clock running over silence */
+    atomic_uint                                 audio_ms;    /*!< Tracker clock at the newest frame */
+#endif  /* CONFIG_AUDIO_DOA_TRACKER */
+#if SHADOW_TRACKER
+    audio_doa_tracker_handle_t                  shadow_tracker_handle;
+#endif  /* SHADOW_TRACKER */
     audio_doa_monitor_callback_t                audio_doa_monitor_callback;
     void*                                       audio_doa_monitor_callback_ctx;
+    audio_doa_result_callback_t                 audio_doa_result_callback;
+    void*                                       audio_doa_result_callback_ctx;
+#if SHADOW_TRACKER
+    float                                       last_primary_output;
+    bool                                        has_primary_output;
+    uint32_t                                    shadow_tracker_outputs;
+    uint32_t                                    shadow_tracker_disagreements;
+#endif  /* SHADOW_TRACKER */
+#if ADAPTIVE_TRACKER
+    bool                                        adaptive_window;
+    float                                       window_moving_dps;
+    float                                       window_still_dps;
+    audio_doa_window_t                          window;  /*!< Last window requested from the core */
+#endif  /* ADAPTIVE_TRACKER */
+    int64_t                                     create_start_us;
+    uint32_t                                    create_us;
+    uint32_t                                    first_result_us;
+    atomic_bool                                 ready;  /*!< Creation finished, the DOA instance can be used */
+    SemaphoreHandle_t                           init_done;  /*!< Given by the background creation task (async only) */
+    audio_doa_app_config_t                     *init_config;  /*!< Copy of the config for the background creation task */
+    audio_doa_app_ready_callback_t              ready_callback;
+    audio_doa_persist_t                         persist;  /*!< Warm-start storage (all NULL = none) */
+#if CONFIG_AUDIO_DOA_ANGLE_LOG
+    audio_doa_log_handle_t                      angle_log;
+#endif  /* CONFIG_AUDIO_DOA_ANGLE_LOG */
+    void*                                       ready_callback_ctx;
     struct {
         bool vad_detect : 1;
     }flags;
 } audio_doa_app_t;
 
-static void audio_doa_callback(float angle, void *ctx)
+static inline void audio_doa_app_mark_first_result(audio_doa_app_t *app)
+{
+    if (app->first_result_us == 0) {
+        app->first_result_us = (uint32_t)(esp_timer_get_time() - app->create_start_us);
+    }
+}
+
+#if CONFIG_AUDIO_DOA_ANGLE_LOG
+static void audio_doa_monitor_log_callback(float angle, void *ctx)
 {
     audio_doa_app_t *app = (audio_doa_app_t *)ctx;
-    if (app == NULL) {
-        ESP_LOGE(TAG, "audio_doa_callback: app is NULL");
-        return;
+    audio_doa_log_append(app->angle_log, AUDIO_DOA_LOG_MONITOR, (uint32_t)(esp_timer_get_time() / 1000), angle);
+    if (app->audio_doa_monitor_callback != NULL) {
+        app->audio_doa_monitor_callback(angle, app->audio_doa_monitor_callback_ctx);
     }
-    if (app->doa_tracker_handle == NULL) {
-        ESP_LOGE(TAG, "audio_doa_callback: doa_tracker_handle is NULL");
+}
+#endif  /* CONFIG_AUDIO_DOA_ANGLE_LOG */
+
+static void audio_doa_result_callback(float angle, void *ctx)
+{
+    audio_doa_app_t *app = (audio_doa_app_t *)ctx;
+#if CONFIG_AUDIO_DOA_ANGLE_LOG
+    if (app->angle_log != NULL) {
+        audio_doa_log_append(app->angle_log, AUDIO_DOA_LOG_RESULT, (uint32_t)(esp_timer_get_time() / 1000), angle);
+    }
+#endif  /* CONFIG_AUDIO_DOA_ANGLE_LOG */
+#if SHADOW_TRACKER
+    app->last_primary_output = angle;
+    app->has_primary_output = true;
+#endif  /* SHADOW_TRACKER */
+    if (app->audio_doa_result_callback != NULL) {
+        app->audio_doa_result_callback(angle, app->audio_doa_result_callback_ctx);
+    }
+}
+
+#if ADAPTIVE_TRACKER
+/**
+ * @brief  Request the analysis window matching how fast the tracked direction moves
+ *
+ *         Between the two thresholds the frame window is used; while the tracker has
+ *         too few angles for a velocity the current window is kept.
+ */
+static void audio_doa_app_adapt_window(audio_doa_app_t *app)
+{
+    float deg_per_s;
+    if (audio_doa_tracker_get_velocity(app->doa_tracker_handle, &deg_per_s) != ESP_OK) {
         return;
     }
-    audio_doa_tracker_feed(app->doa_tracker_handle, angle);
+    audio_doa_window_t window = AUDIO_DOA_WINDOW_FRAME;
+    if (deg_per_s >= app->window_moving_dps) {
+        window = AUDIO_DOA_WINDOW_SHORT;
+    } else if (deg_per_s <= app->window_still_dps) {
+        window = AUDIO_DOA_WINDOW_LONG;
+    }
+    if (window != app->window && audio_doa_set_window(app->doa_handle, window) == ESP_OK) {
+        ESP_LOGD(TAG, "Analysis window %d at %.1f deg/s", window, deg_per_s);
+        app->window = window;
+    }
+}
+#endif  /* ADAPTIVE_TRACKER */
 
-    // ESP_LOGI(TAG, "audio_doa_callback: angle %.2f", angle);
+#if CONFIG_AUDIO_DOA_TRACKER
+static bool audio_doa_tracker_stage(audio_doa_frame_t *frame, void *ctx)
+{
+    audio_doa_app_t *app = (audio_doa_app_t *)ctx;
+    audio_doa_app_mark_first_result(app);
+    // Audio time at the frame's end: batched and synchronous processing run frames back to
+    // back. Audio dropped outside VAD is added, so the tracker still sees the silence
+    uint32_t audio_ms = (uint32_t)((uint64_t)frame->index * frame->samples * 1000 / frame->sample_rate) +
+                        atomic_load(&app->skipped_ms);
+    atomic_store(&app->audio_ms, audio_ms);
+    audio_doa_tracker_feed_at(app->doa_tracker_handle, frame->angle, audio_ms);
+#if ADAPTIVE_TRACKER
+    if (app->adaptive_window) {
+        audio_doa_app_adapt_window(app);
+    }
+#endif  /* ADAPTIVE_TRACKER */
+    return true;
+}
+#else
+// Without the tracker every frame's angle is also the application result
+static bool audio_doa_tracker_stage(audio_doa_frame_t *frame, void *ctx)
+{
+    audio_doa_app_mark_first_result((audio_doa_app_t *)ctx);
+    audio_doa_result_callback(frame->angle, ctx);
+    return true;
+}
+#endif  /* CONFIG_AUDIO_DOA_TRACKER */
 
-    if (app->audio_doa_monitor_callback != NULL) {
-        app->audio_doa_monitor_callback(angle, app->audio_doa_monitor_callback_ctx);
+#if SHADOW_TRACKER
+static void audio_doa_shadow_callback(float angle, void *ctx)
+{
+    audio_doa_app_t *app = (audio_doa_app_t *)ctx;
+    // The shadow trails the primary by a few frames at most, its clock is close enough
+    audio_doa_tracker_feed_at(app->shadow_tracker_handle, angle, atomic_load(&app->audio_ms));
+}
+
+static void audio_doa_shadow_result_callback(float angle, void *ctx)
+{
+    audio_doa_app_t *app = (audio_doa_app_t *)ctx;
+    app->shadow_tracker_outputs++;
+    if (app->has_primary_output && fabsf(angle - app->last_primary_output) >= SHADOW_TRACKER_AGREE_DEG) {
+        app->shadow_tracker_disagreements++;
     }
 }
+#endif  /* SHADOW_TRACKER */
 
-esp_err_t audio_doa_app_create(audio_doa_app_handle_t *handle, audio_doa_app_config_t *config)
+static esp_err_t audio_doa_app_start_chain(audio_doa_app_t *app);
+
+static void audio_doa_app_fill_state(audio_doa_app_t *app, audio_doa_app_state_t *state)
 {
-    if (handle == NULL || config == NULL) {
-        return ESP_ERR_INVALID_ARG;
+    memset(state, 0, sizeof(*state));
+    state->magic = STATE_MAGIC;
+    state->version = STATE_VERSION;
+    state->size = sizeof(*state);
+#if CONFIG_AUDIO_DOA_TRACKER
+    audio_doa_tracker_prior_t prior;
+    if (audio_doa_tracker_get_prior(app->doa_tracker_handle, &prior) == ESP_OK && prior.valid) {
+        state->angle = prior.angle;
+        state->flags |= STATE_FLAG_ANGLE | (prior.front_facing ? STATE_FLAG_FRONT : 0);
     }
+#endif  /* CONFIG_AUDIO_DOA_TRACKER */
+    audio_doa_stats_t stats;
+    if (audio_doa_get_stats(app->doa_handle, &stats) == ESP_OK) {
+        state->noise_floor_rms = stats.noise_floor_rms;
+    }
+    state->crc = esp_rom_crc32_le(0, (const uint8_t *)state, offsetof(audio_doa_app_state_t, crc));
+}
 
-    *handle = (audio_doa_app_handle_t)calloc(1, sizeof(audio_doa_app_t));
-    if (*handle == NULL) {
-        return ESP_ERR_INVALID_ARG;
+static esp_err_t audio_doa_app_apply_state(audio_doa_app_t *app, const void *blob, size_t size)
+{
+    audio_doa_app_state_t state;
+    if (size != sizeof(state)) {
+        return ESP_ERR_INVALID_SIZE;
     }
-    audio_doa_app_t *app = (audio_doa_app_t *)*handle;
-    app->doa_handle = NULL;
-    app->doa_tracker_handle = NULL;
+    memcpy(&state, blob, sizeof(state));
+    if (state.magic != STATE_MAGIC || state.version != STATE_VERSION || state.size != sizeof(state)) {
+        return ESP_ERR_INVALID_VERSION;
+    }
+    if (state.crc != esp_rom_crc32_le(0, (const uint8_t *)&state, offsetof(audio_doa_app_state_t, crc))) {
+        return ESP_ERR_INVALID_CRC;
+    }
+#if CONFIG_AUDIO_DOA_TRACKER
+    if (state.flags & STATE_FLAG_ANGLE) {
+        audio_doa_tracker_prior_t prior = {
+            .valid = true,
+            .angle = state.angle,
+            .front_facing = (state.flags & STATE_FLAG_FRONT) != 0,
+        };
+        esp_err_t ret = audio_doa_tracker_set_prior(app->doa_tracker_handle, &prior);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+#endif  /* CONFIG_AUDIO_DOA_TRACKER */
+    return audio_doa_set_noise_floor(app->doa_handle, state.noise_floor_rms);
+}
 
+static void audio_doa_app_load_state(audio_doa_app_t *app)
+{
+    uint8_t blob[AUDIO_DOA_APP_STATE_SIZE];
+    size_t size = sizeof(blob);
+    esp_err_t ret = app->persist.load(blob, &size, app->persist.ctx);
+    if (ret == ESP_OK) {
+        ret = audio_doa_app_apply_state(app, blob, size);
+    }
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "Warm-start state restored");
+    } else if (ret != ESP_ERR_NOT_FOUND) {
+        // A bad or missing blob only costs the warm start
+        ESP_LOGW(TAG, "Warm-start state not restored: %s", esp_err_to_name(ret));
+    }
+}
+
+static esp_err_t audio_doa_app_setup(audio_doa_app_t *app, const audio_doa_app_config_t *config)
+{
     esp_err_t ret = ESP_OK;
+#if !ADAPTIVE_TRACKER
+    if (config->adaptive_window) {
+        ESP_LOGE(TAG, "Adaptive analysis window needs the tracker and CONFIG_AUDIO_DOA_ADAPTIVE_WINDOW");
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+#endif  /* !ADAPTIVE_TRACKER */
     audio_doa_config_t doa_cfg = {
         .distance = config->distance,
+        .decimate = config->decimate,
+        .engine = config->engine,
+        .mic_num = config->mic_num,
+        .gap_policy = config->gap_policy,
+        .batch_interval_ms = config->batch_interval_ms,
+        .batch_frames = config->batch_frames,
+        .shadow = config->shadow,
+        .shadow_engine = config->shadow_engine,
+        .shadow_decimate = config->shadow_decimate,
+        .gate_rms = config->gate_rms,
+        .disable_smoothing = config->disable_smoothing,
+        .stage_timing = config->stage_timing,
+        .stages = config->stages,
+        .stage_num = config->stage_num,
+        .deadline_us = config->deadline_us,
+        .deadline_miss_limit = config->deadline_miss_limit,
+        .deadline_window_frames = config->deadline_window_frames,
+        .adaptive_window = config->adaptive_window,
+        .synchronous = config->synchronous,
     };
+    memcpy(doa_cfg.mic_pos, config->mic_pos, sizeof(doa_cfg.mic_pos));
     ret = audio_doa_new(&app->doa_handle, &doa_cfg);
     if (ret != ESP_OK) {
         return ret;
     }
     app->audio_doa_monitor_callback = config->audio_doa_monitor_callback;
     app->audio_doa_monitor_callback_ctx = config->audio_doa_monitor_callback_ctx;
-    audio_doa_set_doa_result_callback(app->doa_handle, audio_doa_callback, (void *)app);
+    // The core sink delivers every frame's angle to the monitor, after the tracker stage
+    audio_doa_set_doa_result_callback(app->doa_handle, app->audio_doa_monitor_callback, app->audio_doa_monitor_callback_ctx);
+#if CONFIG_AUDIO_DOA_ANGLE_LOG
+    if (config->angle_log != NULL) {
+        ret = audio_doa_log_create(config->angle_log, &app->angle_log);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        audio_doa_set_doa_result_callback(app->doa_handle, audio_doa_monitor_log_callback, (void *)app);
+    }
+#endif  /* CONFIG_AUDIO_DOA_ANGLE_LOG */
+
+    app->audio_doa_result_callback = config->audio_doa_result_callback;
+    app->audio_doa_result_callback_ctx = config->audio_doa_result_callback_ctx;
+    audio_doa_set_deadline_callback(app->doa_handle, config->deadline_callback, config->deadline_callback_ctx);
 
+#if CONFIG_AUDIO_DOA_TRACKER
     audio_doa_tracker_cfg_t doa_tracker_cfg = {
-        .result_callback = config->audio_doa_result_callback,
-        .ctx = config->audio_doa_result_callback_ctx,
+        .result_callback = audio_doa_result_callback,
+        .ctx = (void *)app,
         .output_interval_ms = 1000,
+        .max_sample_age_ms = config->tracker_max_age_ms ? config->tracker_max_age_ms : TRACKER_DEFAULT_MAX_AGE_MS,
+        .silence_timeout_ms = config->tracker_silence_timeout_ms ? config->tracker_silence_timeout_ms : TRACKER_DEFAULT_SILENCE_TIMEOUT_MS,
     };
+    app->mic_num = config->mic_num > 0 ? config->mic_num : 2;
+    atomic_init(&app->skipped_ms, 0);
+    atomic_init(&app->audio_ms, 0);
     ret = audio_doa_tracker_init(&doa_tracker_cfg, &app->doa_tracker_handle);
     if (ret != ESP_OK) {
         return ret;
     }
+#endif  /* CONFIG_AUDIO_DOA_TRACKER */
+#if ADAPTIVE_TRACKER
+    app->adaptive_window = config->adaptive_window;
+    app->window_moving_dps = config->window_moving_dps > 0.0f ? config->window_moving_dps : WINDOW_DEFAULT_MOVING_DPS;
+    app->window_still_dps = config->window_still_dps > 0.0f ? config->window_still_dps : WINDOW_DEFAULT_STILL_DPS;
+    app->window = AUDIO_DOA_WINDOW_FRAME;
+#endif  /* ADAPTIVE_TRACKER */
+    audio_doa_stage_t tracker_stage = {"tracker", AUDIO_DOA_STAGE_TRACKER, audio_doa_tracker_stage, (void *)app};
+    ret = audio_doa_add_stage(app->doa_handle, &tracker_stage);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+#if SHADOW_TRACKER
+    if (config->shadow) {
+        // The shadow tracker mirrors the primary one so the comparison covers the whole
+        // pipeline, its outputs are only counted and never reach the user callback
+        doa_tracker_cfg.result_callback = audio_doa_shadow_result_callback;
+        ret = audio_doa_tracker_init(&doa_tracker_cfg, &app->shadow_tracker_handle);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        audio_doa_set_shadow_result_callback(app->doa_handle, audio_doa_shadow_callback, (void *)app);
+    }
+#endif  /* SHADOW_TRACKER */
 
-    ret = audio_doa_app_start(*handle);
+    ret = audio_doa_app_start_chain(app);
     if (ret != ESP_OK) {
         return ret;
     }
+    if (config->persist != NULL) {
+        app->persist = *config->persist;
+    }
+    if (app->persist.load != NULL) {
+        audio_doa_app_load_state(app);
+    }
+    app->create_us = (uint32_t)(esp_timer_get_time() - app->create_start_us);
+    atomic_store(&app->ready, true);
+    return ESP_OK;
+}
 
-    ESP_LOGI(TAG, "audio_doa_app_create success");
+esp_err_t audio_doa_app_create(audio_doa_app_handle_t *handle, audio_doa_app_config_t *config)
+{
+    if (handle == NULL || config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
 
+    int64_t create_start_us = esp_timer_get_time();
+    audio_doa_app_t *app = (audio_doa_app_t *)calloc(1, sizeof(audio_doa_app_t));
+    if (app == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    app->doa_handle = NULL;
+    app->create_start_us = create_start_us;
+    atomic_init(&app->ready, false);
+
+    esp_err_t ret = audio_doa_app_setup(app, config);
+    if (ret != ESP_OK) {
+        // Not ready, so nothing is saved: only what setup created is released
+        audio_doa_app_destroy((audio_doa_app_handle_t)app);
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "audio_doa_app_create success, %" PRIu32 " us", app->create_us);
+    *handle = (audio_doa_app_handle_t)app;
     return ESP_OK;
 }
 
+static void audio_doa_app_init_thread(void *arg)
+{
+    audio_doa_app_t *app = (audio_doa_app_t *)arg;
+    esp_err_t ret = audio_doa_app_setup(app, app->init_config);
+    free(app->init_config);
+    app->init_config = NULL;
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "audio_doa_app_create_async ready, %" PRIu32 " us", app->create_us);
+    } else {
+        ESP_LOGE(TAG, "audio_doa_app_create_async failed: %s", esp_err_to_name(ret));
+    }
+    // Release destroy() before the callback so the callback may destroy a failed instance
+    audio_doa_app_ready_callback_t ready_callback = app->ready_callback;
+    void *ready_callback_ctx = app->ready_callback_ctx;
+    xSemaphoreGive(app->init_done);
+    if (ready_callback != NULL) {
+        ready_callback((audio_doa_app_handle_t)app, ret, ready_callback_ctx);
+    }
+    vTaskDelete(NULL);
+}
+
+esp_err_t audio_doa_app_create_async(audio_doa_app_handle_t *handle, audio_doa_app_config_t *config,
+                                     audio_doa_app_ready_callback_t ready_callback, void *ctx)
+{
+    if (handle == NULL || config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    int64_t create_start_us = esp_timer_get_time();
+    audio_doa_app_t *app = (audio_doa_app_t *)calloc(1, sizeof(audio_doa_app_t));
+    if (app == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    app->create_start_us = create_start_us;
+    atomic_init(&app->ready, false);
+    app->ready_callback = ready_callback;
+    app->ready_callback_ctx = ctx;
+    app->init_config = (audio_doa_app_config_t *)malloc(sizeof(audio_doa_app_config_t));
+    app->init_done = xSemaphoreCreateBinary();
+    if (app->init_config != NULL && app->init_done != NULL) {
+        *app->init_config = *config;
+        if (xTaskCreate(audio_doa_app_init_thread, "audio_doa_init", CONFIG_AUDIO_DOA_TASK_STACK_SIZE, app,
+                        INIT_TASK_PRIORITY, NULL) == pdPASS) {
+            *handle = (audio_doa_app_handle_t)app;
+            return ESP_OK;
+        }
+        ESP_LOGE(TAG, "Failed to create audio DOA init thread");
+    }
+    if (app->init_done != NULL) {
+        vSemaphoreDelete(app->init_done);
+    }
+    free(app->init_config);
+    free(app);
+    return ESP_ERR_NO_MEM;
+}
+
 esp_err_t audio_doa_app_destroy(audio_doa_app_handle_t handle)
 {
     if (handle == NULL) {
@@ -96,15 +483,41 @@ esp_err_t audio_doa_app_destroy(audio_doa_app_handle_t handle)
 
     audio_doa_app_t *app = (audio_doa_app_t *)handle;
 
+    if (app->init_done != NULL) {
+        // Wait for a background creation to finish, it may have failed half way
+        xSemaphoreTake(app->init_done, portMAX_DELAY);
+        vSemaphoreDelete(app->init_done);
+        app->init_done = NULL;
+    }
+    if (atomic_load(&app->ready) && app->persist.save != NULL) {
+        audio_doa_app_save_state(handle);
+    }
+
     esp_err_t ret = ESP_OK;
-    ret = audio_doa_delete(app->doa_handle);
-    if (ret != ESP_OK) {
-        return ret;
+    if (app->doa_handle != NULL) {
+        ret = audio_doa_delete(app->doa_handle);
+        if (ret != ESP_OK) {
+            return ret;
+        }
     }
-    ret = audio_doa_tracker_deinit(app->doa_tracker_handle);
-    if (ret != ESP_OK) {
-        return ret;
+#if CONFIG_AUDIO_DOA_TRACKER
+    if (app->doa_tracker_handle != NULL) {
+        ret = audio_doa_tracker_deinit(app->doa_tracker_handle);
+        if (ret != ESP_OK) {
+            return ret;
+        }
     }
+#endif  /* CONFIG_AUDIO_DOA_TRACKER */
+#if SHADOW_TRACKER
+    if (app->shadow_tracker_handle != NULL) {
+        audio_doa_tracker_deinit(app->shadow_tracker_handle);
+    }
+#endif  /* SHADOW_TRACKER */
+#if CONFIG_AUDIO_DOA_ANGLE_LOG
+    if (app->angle_log != NULL) {
+        audio_doa_log_destroy(app->angle_log);
+    }
+#endif  /* CONFIG_AUDIO_DOA_ANGLE_LOG */
     free(app);
     return ESP_OK;
 }
@@ -116,16 +529,30 @@ esp_err_t audio_doa_app_start(audio_doa_app_handle_t handle)
     }
 
     audio_doa_app_t *app = (audio_doa_app_t *)handle;
+    if (!atomic_load(&app->ready)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return audio_doa_app_start_chain(app);
+}
 
+static esp_err_t audio_doa_app_start_chain(audio_doa_app_t *app)
+{
     esp_err_t ret = ESP_OK;
     ret = audio_doa_start(app->doa_handle);
     if (ret != ESP_OK) {
         return ret;
     }
+#if CONFIG_AUDIO_DOA_TRACKER
     ret = audio_doa_tracker_enable(app->doa_tracker_handle, true);
     if (ret != ESP_OK) {
         return ret;
     }
+#endif  /* CONFIG_AUDIO_DOA_TRACKER */
+#if SHADOW_TRACKER
+    if (app->shadow_tracker_handle != NULL) {
+        audio_doa_tracker_enable(app->shadow_tracker_handle, true);
+    }
+#endif  /* SHADOW_TRACKER */
     return ESP_OK;
 }
 
@@ -136,19 +563,45 @@ esp_err_t audio_doa_app_stop(audio_doa_app_handle_t handle)
     }
 
     audio_doa_app_t *app = (audio_doa_app_t *)handle;
+    if (!atomic_load(&app->ready)) {
+        return ESP_ERR_INVALID_STATE;
+    }
 
     esp_err_t ret = ESP_OK;
     ret = audio_doa_stop(app->doa_handle);
     if (ret != ESP_OK) {
         return ret;
     }
+#if CONFIG_AUDIO_DOA_TRACKER
     ret = audio_doa_tracker_enable(app->doa_tracker_handle, false);
     if (ret != ESP_OK) {
         return ret;
     }
+#endif  /* CONFIG_AUDIO_DOA_TRACKER */
+#if SHADOW_TRACKER
+    if (app->shadow_tracker_handle != NULL) {
+        audio_doa_tracker_enable(app->shadow_tracker_handle, false);
+    }
+#endif  /* SHADOW_TRACKER */
     return ESP_OK;
 }
 
+/**
+ * @brief  Advance the tracker's clock by audio dropped outside VAD
+ */
+static void audio_doa_app_skip_audio(audio_doa_app_t *app, int bytes_size)
+{
+#if CONFIG_AUDIO_DOA_TRACKER
+    if (!atomic_load(&app->ready)) {
+        return;
+    }
+    app->skipped_samples += bytes_size / (app->mic_num * (int)sizeof(int16_t));
+    uint32_t ms = app->skipped_samples / INPUT_SAMPLES_PER_MS;
+    app->skipped_samples -= ms * INPUT_SAMPLES_PER_MS;
+    atomic_fetch_add(&app->skipped_ms, ms);
+#endif  /* CONFIG_AUDIO_DOA_TRACKER */
+}
+
 esp_err_t audio_doa_app_data_write(audio_doa_app_handle_t handle, uint8_t *data, int bytes_size)
 {
     if (handle == NULL || data == NULL || bytes_size <= 0) {
@@ -158,13 +611,187 @@ esp_err_t audio_doa_app_data_write(audio_doa_app_handle_t handle, uint8_t *data,
 
     audio_doa_app_t *app = (audio_doa_app_t *)handle;
 
-    if (app->flags.vad_detect == false) {
+    // Audio written before a background creation is ready is dropped like audio outside VAD
+    if (app->flags.vad_detect == false || !atomic_load(&app->ready)) {
+        audio_doa_app_skip_audio(app, bytes_size);
         return ESP_OK;
     }
 
     return audio_doa_data_write(app->doa_handle, data, bytes_size);
 }
 
+esp_err_t audio_doa_app_data_write_with_seq(audio_doa_app_handle_t handle, uint8_t *data, int bytes_size, uint64_t sample_index)
+{
+    if (handle == NULL || data == NULL || bytes_size <= 0) {
+        ESP_LOGE(TAG, "audio_doa_app_data_write_with_seq: invalid args");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    audio_doa_app_t *app = (audio_doa_app_t *)handle;
+
+    // Audio written before a background creation is ready is dropped like audio outside VAD
+    if (app->flags.vad_detect == false || !atomic_load(&app->ready)) {
+        audio_doa_app_skip_audio(app, bytes_size);
+        return ESP_OK;
+    }
+
+    return audio_doa_data_write_with_seq(app->doa_handle, data, bytes_size, sample_index);
+}
+
+esp_err_t audio_doa_app_process(audio_doa_app_handle_t handle, const int16_t *data, int frames)
+{
+    if (handle == NULL || data == NULL || frames < 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    audio_doa_app_t *app = (audio_doa_app_t *)handle;
+    if (!atomic_load(&app->ready)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return audio_doa_process(app->doa_handle, data, frames);
+}
+
+esp_err_t audio_doa_app_get_stats(audio_doa_app_handle_t handle, audio_doa_stats_t *stats)
+{
+    if (handle == NULL || stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    audio_doa_app_t *app = (audio_doa_app_t *)handle;
+    if (!atomic_load(&app->ready)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    esp_err_t ret = audio_doa_get_stats(app->doa_handle, stats);
+    // Measured from the application's create call, tracker setup and background start included
+    stats->create_us = app->create_us;
+    stats->first_result_us = app->first_result_us;
+#if CONFIG_AUDIO_DOA_TRACKER
+    audio_doa_tracker_stats_t tracker_stats;
+    if (audio_doa_tracker_get_stats(app->doa_tracker_handle, &tracker_stats) == ESP_OK) {
+        stats->tracker_outputs = tracker_stats.outputs;
+        stats->tracker_rejected = tracker_stats.rejected;
+        stats->tracker_held = tracker_stats.held;
+        stats->tracker_resets = tracker_stats.resets;
+    }
+#endif  /* CONFIG_AUDIO_DOA_TRACKER */
+#if SHADOW_TRACKER
+    stats->shadow_tracker_outputs = app->shadow_tracker_outputs;
+    stats->shadow_tracker_disagreements = app->shadow_tracker_disagreements;
+#endif  /* SHADOW_TRACKER */
+    return ret;
+}
+
+esp_err_t audio_doa_app_get_stage_stats(audio_doa_app_handle_t handle, audio_doa_stage_stats_t *stats, int max_count, int *count)
+{
+    if (handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    audio_doa_app_t *app = (audio_doa_app_t *)handle;
+    if (!atomic_load(&app->ready)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return audio_doa_get_stage_stats(app->doa_handle, stats, max_count, count);
+}
+
+esp_err_t audio_doa_app_export_state(audio_doa_app_handle_t handle, void *blob, size_t *size)
+{
+    if (handle == NULL || blob == NULL || size == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (*size < sizeof(audio_doa_app_state_t)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    audio_doa_app_t *app = (audio_doa_app_t *)handle;
+    if (!atomic_load(&app->ready)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    audio_doa_app_state_t state;
+    audio_doa_app_fill_state(app, &state);
+    memcpy(blob, &state, sizeof(state));
+    *size = sizeof(state);
+    return ESP_OK;
+}
+
+esp_err_t audio_doa_app_import_state(audio_doa_app_handle_t handle, const void *blob, size_t size)
+{
+    if (handle == NULL || blob == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    audio_doa_app_t *app = (audio_doa_app_t *)handle;
+    if (!atomic_load(&app->ready)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return audio_doa_app_apply_state(app, blob, size);
+}
+
+esp_err_t audio_doa_app_save_state(audio_doa_app_handle_t handle)
+{
+    if (handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    audio_doa_app_t *app = (audio_doa_app_t *)handle;
+    if (!atomic_load(&app->ready) || app->persist.save == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    audio_doa_app_state_t state;
+    audio_doa_app_fill_state(app, &state);
+    return app->persist.save(&state, sizeof(state), app->persist.ctx);
+}
+
+esp_err_t audio_doa_app_benchmark(const audio_doa_app_config_t *config, uint32_t frames, audio_doa_benchmark_t *result)
+{
+    if (config == NULL || result == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // The real stages without any I/O around them
+    audio_doa_app_config_t bench_cfg = *config;
+    bench_cfg.shadow = false;
+    bench_cfg.batch_interval_ms = 0;
+    bench_cfg.angle_log = NULL;
+    bench_cfg.persist = NULL;
+    bench_cfg.audio_doa_monitor_callback = NULL;
+    bench_cfg.audio_doa_result_callback = NULL;
+    audio_doa_app_handle_t handle = NULL;
+    esp_err_t ret = audio_doa_app_create(&handle, &bench_cfg);
+    if (ret == ESP_OK) {
+        audio_doa_app_t *app = (audio_doa_app_t *)handle;
+        // Park the DOA task; the tracker stays enabled so its stage does its real work
+        audio_doa_stop(app->doa_handle);
+        ret = audio_doa_benchmark(app->doa_handle, frames, result);
+    }
+    if (handle != NULL) {
+        audio_doa_app_destroy(handle);
+    }
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "Benchmark: %" PRIu32 " cycles/frame, RTF %.3f, stack %" PRIu32 " B, heap %" PRIu32 " B",
+                 result->cycles_per_frame, result->real_time_factor, result->peak_stack_bytes, result->peak_heap_bytes);
+    }
+    return ret;
+}
+
+esp_err_t audio_doa_app_get_angle_log(audio_doa_app_handle_t handle, audio_doa_log_handle_t *angle_log)
+{
+    if (handle == NULL || angle_log == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+#if CONFIG_AUDIO_DOA_ANGLE_LOG
+    audio_doa_app_t *app = (audio_doa_app_t *)handle;
+    if (!atomic_load(&app->ready) || app->angle_log == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    *angle_log = app->angle_log;
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif  /* CONFIG_AUDIO_DOA_ANGLE_LOG */
+}
+
 esp_err_t audio_doa_app_set_vad_detect(audio_doa_app_handle_t handle, bool vad_detect)
 {
     if (handle == NULL) {
@@ -0,0 +1,399 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <math.h>
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "audio_doa_fusion.h"
+
+static const char *TAG = "DOA_FUSION";
+
+#define FUSION_DEFAULT_SOURCES       4
+#define FUSION_DEFAULT_TRACKS        4
+#define FUSION_DEFAULT_SYNC_MS       300
+#define FUSION_DEFAULT_TIMEOUT_MS    3000
+#define FUSION_DEFAULT_SIGMA_DEG     10.0f
+#define FUSION_DEFAULT_GATE_M        1.0f
+#define FUSION_DEFAULT_PROCESS_NOISE 0.25f
+#define FUSION_MIN_RANGE_M           0.3f
+#define FUSION_MIN_DETERMINANT       1e-6f
+#define FUSION_PACKET_MAGIC          0xD0
+#define FUSION_PACKET_VERSION        1
+
+/**
+ * @brief  Latest report of one device
+ */
+typedef struct {
+    bool      has_pose;
+    bool      has_bearing;
+    float     x;
+    float     y;
+    float     heading_rad;
+    uint32_t  timestamp_ms;
+    float     dir_x;        /*!< Unit bearing direction in the room frame */
+    float     dir_y;
+} fusion_source_t;
+
+typedef struct {
+    bool                      active;
+    audio_doa_fusion_track_t  state;
+} fusion_track_t;
+
+typedef struct {
+    audio_doa_fusion_cfg_t  cfg;
+    float                   sigma_rad;
+    fusion_source_t        *sources;
+    fusion_track_t         *tracks;
+    uint32_t                next_track_id;
+    SemaphoreHandle_t       lock;
+} audio_doa_fusion_ctx_t;
+
+/**
+ * @brief  Symmetric 2x2 matrix [a b; b c]
+ */
+typedef struct {
+    float a;
+    float b;
+    float c;
+} sym2_t;
+
+static bool sym2_inverse(sym2_t m, sym2_t *out)
+{
+    float det = m.a * m.c - m.b * m.b;
+    if (fabsf(det) < FUSION_MIN_DETERMINANT) {
+        return false;
+    }
+    out->a = m.c / det;
+    out->b = -m.b / det;
+    out->c = m.a / det;
+    return true;
+}
+
+/**
+ * @brief  Least-squares intersection of the bearing lines in the sync window
+ *
+ *         Minimises the weighted sum of squared distances to each line. A first
+ *         unweighted pass gives the ranges, the second pass weights each line by
+ *         1 / (sigma * range)^2 so the inverse normal matrix is the fix covariance.
+ */
+static int fusion_triangulate(audio_doa_fusion_ctx_t *ctx, uint32_t newest_ms, float *px, float *py, sym2_t *cov)
+{
+    float x = 0.0f, y = 0.0f;
+    int used = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        sym2_t m = {0};
+        float bx = 0.0f, by = 0.0f;
+        used = 0;
+        for (int i = 0; i < ctx->cfg.max_sources; i++) {
+            fusion_source_t *src = &ctx->sources[i];
+            if (!src->has_pose || !src->has_bearing ||
+                (int32_t)(newest_ms - src->timestamp_ms) > (int32_t)ctx->cfg.sync_window_ms) {
+                continue;
+            }
+            float w = 1.0f;
+            if (pass == 1) {
+                float range = hypotf(x - src->x, y - src->y);
+                range = range < FUSION_MIN_RANGE_M ? FUSION_MIN_RANGE_M : range;
+                w = 1.0f / (ctx->sigma_rad * ctx->sigma_rad * range * range);
+            }
+            // Projector onto the line normal: I - d d^T
+            float pa = 1.0f - src->dir_x * src->dir_x;
+            float pb = -src->dir_x * src->dir_y;
+            float pc = 1.0f - src->dir_y * src->dir_y;
+            m.a += w * pa;
+            m.b += w * pb;
+            m.c += w * pc;
+            bx += w * (pa * src->x + pb * src->y);
+            by += w * (pb * src->x + pc * src->y);
+            used++;
+        }
+        sym2_t inv;
+        if (used < 2 || !sym2_inverse(m, &inv)) {
+            return 0;
+        }
+        x = inv.a * bx + inv.b * by;
+        y = inv.b * bx + inv.c * by;
+        *cov = inv;
+    }
+
+    // Reject ghost intersections behind any of the arrays
+    for (int i = 0; i < ctx->cfg.max_sources; i++) {
+        fusion_source_t *src = &ctx->sources[i];
+        if (src->has_pose && src->has_bearing &&
+            (int32_t)(newest_ms - src->timestamp_ms) <= (int32_t)ctx->cfg.sync_window_ms &&
+            (x - src->x) * src->dir_x + (y - src->y) * src->dir_y <= 0.0f) {
+            return 0;
+        }
+    }
+    *px = x;
+    *py = y;
+    return used;
+}
+
+/**
+ * @brief  Capture time of the newest bearing, fixes are timed by it so a late report
+ *         from one device never moves a track back in time
+ */
+static uint32_t fusion_newest_bearing(audio_doa_fusion_ctx_t *ctx, uint32_t timestamp_ms)
+{
+    uint32_t newest = timestamp_ms;
+    for (int i = 0; i < ctx->cfg.max_sources; i++) {
+        fusion_source_t *src = &ctx->sources[i];
+        if (src->has_pose && src->has_bearing && (int32_t)(src->timestamp_ms - newest) > 0) {
+            newest = src->timestamp_ms;
+        }
+    }
+    return newest;
+}
+
+static void fusion_expire_tracks(audio_doa_fusion_ctx_t *ctx, uint32_t now_ms)
+{
+    for (int t = 0; t < ctx->cfg.max_tracks; t++) {
+        if (ctx->tracks[t].active &&
+            (int32_t)(now_ms - ctx->tracks[t].state.timestamp_ms) > (int32_t)ctx->cfg.track_timeout_ms) {
+            ctx->tracks[t].active = false;
+        }
+    }
+}
+
+/**
+ * @brief  Associate a fix with the nearest track inside the gate and fuse it
+ */
+static void fusion_update_tracks(audio_doa_fusion_ctx_t *ctx, uint32_t now_ms, float zx, float zy, sym2_t r, int used)
+{
+    fusion_expire_tracks(ctx, now_ms);
+
+    int best = -1;
+    int free_slot = -1;
+    int oldest = 0;
+    float best_dist = ctx->cfg.gate_m;
+    for (int t = 0; t < ctx->cfg.max_tracks; t++) {
+        fusion_track_t *trk = &ctx->tracks[t];
+        if (!trk->active) {
+            free_slot = free_slot < 0 ? t : free_slot;
+            continue;
+        }
+        float dist = hypotf(zx - trk->state.x, zy - trk->state.y);
+        if (dist < best_dist) {
+            best_dist = dist;
+            best = t;
+        }
+        if ((int32_t)(trk->state.timestamp_ms - ctx->tracks[oldest].state.timestamp_ms) < 0) {
+            oldest = t;
+        }
+    }
+
+    if (best < 0) {
+        int slot = free_slot >= 0 ? free_slot : oldest;
+        fusion_track_t *trk = &ctx->tracks[slot];
+        trk->active = true;
+        trk->state.id = ctx->next_track_id++;
+        trk->state.x = zx;
+        trk->state.y = zy;
+        trk->state.var_x = r.a;
+        trk->state.cov_xy = r.b;
+        trk->state.var_y = r.c;
+        trk->state.timestamp_ms = now_ms;
+        trk->state.source_count = (uint8_t)used;
+        ESP_LOGD(TAG, "New track %lu at (%.2f, %.2f)", (unsigned long)trk->state.id, zx, zy);
+        return;
+    }
+
+    // Constant-position Kalman update with 2x2 matrices, a fix older than the track adds no process noise
+    audio_doa_fusion_track_t *st = &ctx->tracks[best].state;
+    bool newer = (int32_t)(now_ms - st->timestamp_ms) > 0;
+    float dt = newer ? (now_ms - st->timestamp_ms) / 1000.0f : 0.0f;
+    sym2_t p = {st->var_x + ctx->cfg.process_noise * dt, st->cov_xy, st->var_y + ctx->cfg.process_noise * dt};
+    sym2_t s = {p.a + r.a, p.b + r.b, p.c + r.c};
+    sym2_t s_inv;
+    if (!sym2_inverse(s, &s_inv)) {
+        return;
+    }
+    // K = P S^-1 (not symmetric in general)
+    float k00 = p.a * s_inv.a + p.b * s_inv.b;
+    float k01 = p.a * s_inv.b + p.b * s_inv.c;
+    float k10 = p.b * s_inv.a + p.c * s_inv.b;
+    float k11 = p.b * s_inv.b + p.c * s_inv.c;
+    float ex = zx - st->x;
+    float ey = zy - st->y;
+    st->x += k00 * ex + k01 * ey;
+    st->y += k10 * ex + k11 * ey;
+    // P = (I - K) P
+    st->var_x = (1.0f - k00) * p.a - k01 * p.b;
+    st->cov_xy = (1.0f - k00) * p.b - k01 * p.c;
+    st->var_y = -k10 * p.b + (1.0f - k11) * p.c;
+    if (newer) {
+        st->timestamp_ms = now_ms;
+    }
+    st->source_count = (uint8_t)used;
+}
+
+esp_err_t audio_doa_fusion_create(const audio_doa_fusion_cfg_t *cfg, audio_doa_fusion_handle_t *out_handle)
+{
+    if (out_handle == NULL) {
+        ESP_LOGE(TAG, "Invalid arguments");
+        return ESP_ERR_INVALID_ARG;
+    }
+    audio_doa_fusion_cfg_t defaults = {0};
+    if (cfg == NULL) {
+        cfg = &defaults;
+    }
+
+    audio_doa_fusion_ctx_t *ctx = (audio_doa_fusion_ctx_t *)calloc(1, sizeof(audio_doa_fusion_ctx_t));
+    if (ctx == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate memory");
+        return ESP_ERR_NO_MEM;
+    }
+    ctx->cfg.max_sources = cfg->max_sources > 0 ? cfg->max_sources : FUSION_DEFAULT_SOURCES;
+    ctx->cfg.max_tracks = cfg->max_tracks > 0 ? cfg->max_tracks : FUSION_DEFAULT_TRACKS;
+    ctx->cfg.sync_window_ms = cfg->sync_window_ms > 0 ? cfg->sync_window_ms : FUSION_DEFAULT_SYNC_MS;
+    ctx->cfg.track_timeout_ms = cfg->track_timeout_ms > 0 ? cfg->track_timeout_ms : FUSION_DEFAULT_TIMEOUT_MS;
+    ctx->cfg.bearing_sigma_deg = cfg->bearing_sigma_deg > 0.0f ? cfg->bearing_sigma_deg : FUSION_DEFAULT_SIGMA_DEG;
+    ctx->cfg.gate_m = cfg->gate_m > 0.0f ? cfg->gate_m : FUSION_DEFAULT_GATE_M;
+    ctx->cfg.process_noise = cfg->process_noise > 0.0f ? cfg->process_noise : FUSION_DEFAULT_PROCESS_NOISE;
+    ctx->sigma_rad = ctx->cfg.bearing_sigma_deg * (float)M_PI / 180.0f;
+
+    ctx->sources = (fusion_source_t *)calloc(ctx->cfg.max_sources, sizeof(fusion_source_t));
+    ctx->tracks = (fusion_track_t *)calloc(ctx->cfg.max_tracks, sizeof(fusion_track_t));
+    ctx->lock = xSemaphoreCreateMutex();
+    if (ctx->sources == NULL || ctx->tracks == NULL || ctx->lock == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate memory");
+        audio_doa_fusion_destroy(ctx);
+        return ESP_ERR_NO_MEM;
+    }
+
+    *out_handle = (audio_doa_fusion_handle_t)ctx;
+    ESP_LOGI(TAG, "DOA fusion initialized (%d sources, %d tracks)", ctx->cfg.max_sources, ctx->cfg.max_tracks);
+    return ESP_OK;
+}
+
+esp_err_t audio_doa_fusion_destroy(audio_doa_fusion_handle_t handle)
+{
+    if (handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    audio_doa_fusion_ctx_t *ctx = (audio_doa_fusion_ctx_t *)handle;
+    if (ctx->lock) {
+        vSemaphoreDelete(ctx->lock);
+    }
+    free(ctx->tracks);
+    free(ctx->sources);
+    free(ctx);
+    return ESP_OK;
+}
+
+esp_err_t audio_doa_fusion_set_pose(audio_doa_fusion_handle_t handle, uint8_t source_id, const audio_doa_fusion_pose_t *pose)
+{
+    audio_doa_fusion_ctx_t *ctx = (audio_doa_fusion_ctx_t *)handle;
+    if (ctx == NULL || pose == NULL || source_id >= ctx->cfg.max_sources) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    xSemaphoreTake(ctx->lock, portMAX_DELAY);
+    fusion_source_t *src = &ctx->sources[source_id];
+    src->x = pose->x;
+    src->y = pose->y;
+    src->heading_rad = pose->heading_deg * (float)M_PI / 180.0f;
+    src->has_pose = true;
+    src->has_bearing = false;
+    xSemaphoreGive(ctx->lock);
+    return ESP_OK;
+}
+
+esp_err_t audio_doa_fusion_submit(audio_doa_fusion_handle_t handle, uint8_t source_id, uint32_t timestamp_ms, float bearing_deg)
+{
+    audio_doa_fusion_ctx_t *ctx = (audio_doa_fusion_ctx_t *)handle;
+    if (ctx == NULL || source_id >= ctx->cfg.max_sources || bearing_deg < 0.0f || bearing_deg > 180.0f) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    xSemaphoreTake(ctx->lock, portMAX_DELAY);
+    fusion_source_t *src = &ctx->sources[source_id];
+    if (!src->has_pose) {
+        xSemaphoreGive(ctx->lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    // A reordered report older than the source's current bearing carries no new information
+    if (src->has_bearing && (int32_t)(timestamp_ms - src->timestamp_ms) < 0) {
+        xSemaphoreGive(ctx->lock);
+        ESP_LOGD(TAG, "Dropped late bearing of source %u", source_id);
+        return ESP_OK;
+    }
+    // Device-local 90 degrees is the heading, 0 degrees is 90 degrees counter-clockwise of it
+    float world = src->heading_rad + (90.0f - bearing_deg) * (float)M_PI / 180.0f;
+    src->dir_x = cosf(world);
+    src->dir_y = sinf(world);
+    src->timestamp_ms = timestamp_ms;
+    src->has_bearing = true;
+
+    float x, y;
+    sym2_t cov;
+    uint32_t fix_ms = fusion_newest_bearing(ctx, timestamp_ms);
+    int used = fusion_triangulate(ctx, fix_ms, &x, &y, &cov);
+    if (used >= 2) {
+        fusion_update_tracks(ctx, fix_ms, x, y, cov, used);
+    }
+    xSemaphoreGive(ctx->lock);
+    return ESP_OK;
+}
+
+esp_err_t audio_doa_fusion_pack_bearing(uint8_t source_id, uint32_t timestamp_ms, float bearing_deg, uint8_t *buf)
+{
+    if (buf == NULL || bearing_deg < 0.0f || bearing_deg > 180.0f) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    uint16_t centi_deg = (uint16_t)(bearing_deg * 100.0f + 0.5f);
+    memset(buf, 0, AUDIO_DOA_FUSION_PACKET_SIZE);
+    buf[0] = FUSION_PACKET_MAGIC;
+    buf[1] = FUSION_PACKET_VERSION;
+    buf[2] = source_id;
+    buf[4] = (uint8_t)(timestamp_ms);
+    buf[5] = (uint8_t)(timestamp_ms >> 8);
+    buf[6] = (uint8_t)(timestamp_ms >> 16);
+    buf[7] = (uint8_t)(timestamp_ms >> 24);
+    buf[8] = (uint8_t)(centi_deg);
+    buf[9] = (uint8_t)(centi_deg >> 8);
+    return ESP_OK;
+}
+
+esp_err_t audio_doa_fusion_submit_packet(audio_doa_fusion_handle_t handle, const uint8_t *buf, size_t len)
+{
+    if (handle == NULL || buf == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (len != AUDIO_DOA_FUSION_PACKET_SIZE) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (buf[0] != FUSION_PACKET_MAGIC || buf[1] != FUSION_PACKET_VERSION) {
+        return ESP_ERR_INVALID_VERSION;
+    }
+    uint32_t timestamp_ms = (uint32_t)buf[4] | ((uint32_t)buf[5] << 8) | ((uint32_t)buf[6] << 16) | ((uint32_t)buf[7] << 24);
+    uint16_t centi_deg = (uint16_t)(buf[8] | (buf[9] << 8));
+    return audio_doa_fusion_submit(handle, buf[2], timestamp_ms, centi_deg / 100.0f);
+}
+
+esp_err_t audio_doa_fusion_get_tracks(audio_doa_fusion_handle_t handle, uint32_t now_ms,
+                                      audio_doa_fusion_track_t *tracks, int max_count, int *count)
+{
+    audio_doa_fusion_ctx_t *ctx = (audio_doa_fusion_ctx_t *)handle;
+    if (ctx == NULL || tracks == NULL || count == NULL || max_count < 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    xSemaphoreTake(ctx->lock, portMAX_DELAY);
+    fusion_expire_tracks(ctx, now_ms);
+    int n = 0;
+    for (int t = 0; t < ctx->cfg.max_tracks && n < max_count; t++) {
+        if (ctx->tracks[t].active) {
+            tracks[n++] = ctx->tracks[t].state;
+        }
+    }
+    xSemaphoreGive(ctx->lock);
+    *count = n;
+    return ESP_OK;
+}
@@ -0,0 +1,267 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "audio_doa_log.h"
+
+static const char *TAG = "DOA_LOG";
+
+#define LOG_DEFAULT_BLOCK_SIZE   256
+#define LOG_DEFAULT_BLOCK_NUM    16
+#define LOG_DEFAULT_RESOLUTION   50
+#define LOG_MIN_BLOCK_SIZE       32
+#define LOG_MAX_BLOCK_SIZE       4096
+#define LOG_MAX_ENTRY_BYTES      8  // 3-byte angle varint + 5-byte time varint
+
+/**
+ * @brief  Block being filled for one stream
+ */
+typedef struct {
+    uint8_t   *buf;
+    uint16_t   used;          /*!< Bytes used, header included (0 = no open block) */
+    uint16_t   count;
+    uint32_t   last_ms;
+    int32_t    last_q;
+    uint32_t   last_dt;
+} audio_doa_log_open_t;
+
+/**
+ * @brief  Angle log context
+ */
+typedef struct {
+    uint16_t               block_size;
+    uint16_t               block_num;
+    uint16_t               resolution_cdeg;
+    uint8_t               *ring;        /*!< block_num sealed blocks */
+    uint16_t              *ring_len;    /*!< Bytes used in each sealed block */
+    uint16_t               head;        /*!< Oldest sealed block */
+    uint16_t               queued;
+    audio_doa_log_open_t   open[AUDIO_DOA_LOG_STREAM_MAX];
+    audio_doa_log_stats_t  stats;
+    SemaphoreHandle_t      lock;
+} audio_doa_log_ctx_t;
+
+static inline void put_le16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void put_le32(uint8_t *p, uint32_t v)
+{
+    put_le16(p, (uint16_t)v);
+    put_le16(p + 2, (uint16_t)(v >> 16));
+}
+
+static inline int put_varint(uint8_t *p, uint32_t v)
+{
+    int n = 0;
+    while (v >= 0x80) {
+        p[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+static int32_t quantize(const audio_doa_log_ctx_t *ctx, float angle)
+{
+    int32_t q = (int32_t)lroundf(angle * 100.0f / ctx->resolution_cdeg);
+    return q < INT16_MIN ? INT16_MIN : (q > INT16_MAX ? INT16_MAX : q);
+}
+
+static void seal_block(audio_doa_log_ctx_t *ctx, audio_doa_log_stream_t stream)
+{
+    audio_doa_log_open_t *open = &ctx->open[stream];
+    if (open->used == 0) {
+        return;
+    }
+    put_le16(open->buf + 4, open->used - AUDIO_DOA_LOG_HEADER_SIZE);
+    put_le16(open->buf + 6, open->count);
+
+    if (ctx->queued == ctx->block_num) {
+        // Ring full: keep the newest history
+        ctx->head = (ctx->head + 1) % ctx->block_num;
+        ctx->queued--;
+        ctx->stats.blocks_overwritten++;
+    }
+    uint16_t slot = (ctx->head + ctx->queued) % ctx->block_num;
+    memcpy(ctx->ring + (size_t)slot * ctx->block_size, open->buf, open->used);
+    ctx->ring_len[slot] = open->used;
+    ctx->queued++;
+    ctx->stats.blocks_sealed++;
+    open->used = 0;
+}
+
+static void start_block(audio_doa_log_ctx_t *ctx, audio_doa_log_stream_t stream, uint32_t timestamp_ms, int32_t q)
+{
+    audio_doa_log_open_t *open = &ctx->open[stream];
+    uint8_t *p = open->buf;
+    put_le16(p, AUDIO_DOA_LOG_MAGIC);
+    p[2] = AUDIO_DOA_LOG_VERSION;
+    p[3] = (uint8_t)stream;
+    put_le32(p + 8, timestamp_ms);
+    put_le16(p + 12, (uint16_t)(int16_t)q);
+    put_le16(p + 14, ctx->resolution_cdeg);
+    open->used = AUDIO_DOA_LOG_HEADER_SIZE;
+    open->count = 1;
+    open->last_ms = timestamp_ms;
+    open->last_q = q;
+    open->last_dt = 0;
+}
+
+esp_err_t audio_doa_log_create(const audio_doa_log_cfg_t *cfg, audio_doa_log_handle_t *out_handle)
+{
+    if (out_handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    audio_doa_log_cfg_t defaults = {0};
+    if (cfg == NULL) {
+        cfg = &defaults;
+    }
+    uint16_t block_size = cfg->block_size ? cfg->block_size : LOG_DEFAULT_BLOCK_SIZE;
+    if (block_size < LOG_MIN_BLOCK_SIZE || block_size > LOG_MAX_BLOCK_SIZE) {
+        ESP_LOGE(TAG, "Block size %u out of range", block_size);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    audio_doa_log_ctx_t *ctx = (audio_doa_log_ctx_t *)calloc(1, sizeof(audio_doa_log_ctx_t));
+    if (ctx == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    ctx->block_size = block_size;
+    ctx->block_num = cfg->block_num ? cfg->block_num : LOG_DEFAULT_BLOCK_NUM;
+    ctx->resolution_cdeg = cfg->resolution_cdeg ? cfg->resolution_cdeg : LOG_DEFAULT_RESOLUTION;
+    ctx->ring = (uint8_t *)calloc(ctx->block_num, ctx->block_size);
+    ctx->ring_len = (uint16_t *)calloc(ctx->block_num, sizeof(uint16_t));
+    ctx->lock = xSemaphoreCreateMutex();
+    bool ok = ctx->ring != NULL && ctx->ring_len != NULL && ctx->lock != NULL;
+    for (int i = 0; i < AUDIO_DOA_LOG_STREAM_MAX && ok; i++) {
+        ctx->open[i].buf = (uint8_t *)calloc(1, ctx->block_size);
+        ok = ctx->open[i].buf != NULL;
+    }
+    if (!ok) {
+        audio_doa_log_destroy(ctx);
+        return ESP_ERR_NO_MEM;
+    }
+    *out_handle = (audio_doa_log_handle_t)ctx;
+    return ESP_OK;
+}
+
+esp_err_t audio_doa_log_append(audio_doa_log_handle_t handle, audio_doa_log_stream_t stream, uint32_t timestamp_ms, float angle)
+{
+    if (handle == NULL || stream >= AUDIO_DOA_LOG_STREAM_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    audio_doa_log_ctx_t *ctx = (audio_doa_log_ctx_t *)handle;
+    audio_doa_log_open_t *open = &ctx->open[stream];
+    int32_t q = quantize(ctx, angle);
+
+    xSemaphoreTake(ctx->lock, portMAX_DELAY);
+    ctx->stats.entries++;
+    if (open->used + LOG_MAX_ENTRY_BYTES > ctx->block_size || open->count == UINT16_MAX) {
+        seal_block(ctx, stream);
+    }
+    if (open->used == 0) {
+        start_block(ctx, stream, timestamp_ms, q);
+        xSemaphoreGive(ctx->lock);
+        return ESP_OK;
+    }
+
+    uint32_t dt = timestamp_ms >= open->last_ms ? timestamp_ms - open->last_ms : 0;
+    int32_t dq = q - open->last_q;
+    uint32_t zigzag = ((uint32_t)dq << 1) ^ (uint32_t)(dq >> 31);
+    bool new_dt = dt != open->last_dt;
+    uint8_t *p = open->buf + open->used;
+    int n = put_varint(p, (zigzag << 1) | (new_dt ? 1 : 0));
+    if (new_dt) {
+        n += put_varint(p + n, dt);
+    }
+    open->used += n;
+    open->count++;
+    open->last_ms += dt;
+    open->last_q = q;
+    open->last_dt = dt;
+    xSemaphoreGive(ctx->lock);
+    return ESP_OK;
+}
+
+esp_err_t audio_doa_log_flush(audio_doa_log_handle_t handle)
+{
+    if (handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    audio_doa_log_ctx_t *ctx = (audio_doa_log_ctx_t *)handle;
+    xSemaphoreTake(ctx->lock, portMAX_DELAY);
+    for (int i = 0; i < AUDIO_DOA_LOG_STREAM_MAX; i++) {
+        seal_block(ctx, (audio_doa_log_stream_t)i);
+    }
+    xSemaphoreGive(ctx->lock);
+    return ESP_OK;
+}
+
+esp_err_t audio_doa_log_read(audio_doa_log_handle_t handle, uint8_t *block, size_t size, size_t *len)
+{
+    if (handle == NULL || block == NULL || len == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    audio_doa_log_ctx_t *ctx = (audio_doa_log_ctx_t *)handle;
+    if (size < ctx->block_size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    xSemaphoreTake(ctx->lock, portMAX_DELAY);
+    if (ctx->queued == 0) {
+        xSemaphoreGive(ctx->lock);
+        return ESP_ERR_NOT_FOUND;
+    }
+    *len = ctx->ring_len[ctx->head];
+    memcpy(block, ctx->ring + (size_t)ctx->head * ctx->block_size, *len);
+    ctx->head = (ctx->head + 1) % ctx->block_num;
+    ctx->queued--;
+    xSemaphoreGive(ctx->lock);
+    return ESP_OK;
+}
+
+esp_err_t audio_doa_log_get_stats(audio_doa_log_handle_t handle, audio_doa_log_stats_t *stats)
+{
+    if (handle == NULL || stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    audio_doa_log_ctx_t *ctx = (audio_doa_log_ctx_t *)handle;
+    xSemaphoreTake(ctx->lock, portMAX_DELAY);
+    *stats = ctx->stats;
+    stats->blocks_queued = ctx->queued;
+    xSemaphoreGive(ctx->lock);
+    return ESP_OK;
+}
+
+esp_err_t audio_doa_log_destroy(audio_doa_log_handle_t handle)
+{
+    if (handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    audio_doa_log_ctx_t *ctx = (audio_doa_log_ctx_t *)handle;
+    for (int i = 0; i < AUDIO_DOA_LOG_STREAM_MAX; i++) {
+        free(ctx->open[i].buf);
+    }
+    if (ctx->lock != NULL) {
+        vSemaphoreDelete(ctx->lock);
+    }
+    free(ctx->ring_len);
+    free(ctx->ring);
+    free(ctx);
+    return ESP_OK;
+}
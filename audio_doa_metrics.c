@@ -0,0 +1,479 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "sdkconfig.h"
+#if CONFIG_IDF_TARGET_LINUX
+#include <sys/un.h>
+#endif  /* CONFIG_IDF_TARGET_LINUX */
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "audio_doa_metrics.h"
+
+static const char *TAG = "audio_doa_metrics";
+
+#define METRICS_DEFAULT_PORT      9464
+#define METRICS_DEFAULT_PRIORITY  2
+#define METRICS_TASK_STACK_SIZE   4096
+#define METRICS_REQUEST_MAX       512
+#define METRICS_RECV_TIMEOUT_S    2
+
+typedef struct {
+    audio_doa_app_handle_t   app;
+    char                     name[AUDIO_DOA_METRICS_NAME_LEN];
+    audio_doa_stats_t        stats;   /*!< Snapshot of the current scrape */
+    audio_doa_stage_stats_t  stages[AUDIO_DOA_MAX_STAGES];
+    int                      stage_num;
+} audio_doa_metrics_entry_t;
+
+typedef struct {
+    int                        listen_fd;
+    char                      *unix_path;
+    atomic_bool                stopping;
+    SemaphoreHandle_t          lock;     /*!< Registry and snapshots, never taken by the DOA tasks */
+    SemaphoreHandle_t          stopped;
+    audio_doa_metrics_entry_t  entries[AUDIO_DOA_METRICS_MAX_INSTANCES];
+    int                        entry_num;
+} audio_doa_metrics_t;
+
+typedef struct {
+    char    *buf;
+    size_t   size;
+    size_t   len;
+} audio_doa_metrics_out_t;
+
+/**
+ * @brief  uint32_t counters of audio_doa_stats_t exported one to one
+ */
+typedef struct {
+    const char  *name;
+    const char  *type;
+    const char  *help;
+    size_t       offset;
+} audio_doa_metric_t;
+
+static const audio_doa_metric_t s_stat_metrics[] = {
+    {"audio_doa_frames_processed_total", "counter", "Frames that reached the DOA engine", offsetof(audio_doa_stats_t, frames_processed)},
+    {"audio_doa_frames_gated_total", "counter", "Frames stopped by a gating stage", offsetof(audio_doa_stats_t, frames_gated)},
+    {"audio_doa_frames_discarded_total", "counter", "Frames skipped because a capture gap broke them", offsetof(audio_doa_stats_t, frames_discarded)},
+    {"audio_doa_samples_dropped_total", "counter", "Per-channel samples dropped as overlap or on buffer overflow", offsetof(audio_doa_stats_t, samples_dropped)},
+    {"audio_doa_samples_zero_filled_total", "counter", "Per-channel samples of silence inserted for gaps", offsetof(audio_doa_stats_t, samples_zero_filled)},
+    {"audio_doa_wakeups_total", "counter", "Times the processing task woke up to look for audio", offsetof(audio_doa_stats_t, wakeups)},
+    {"audio_doa_queue_frames", "gauge", "Frames waiting in the stream buffer", offsetof(audio_doa_stats_t, queue_frames)},
+    {"audio_doa_deadline_misses_total", "counter", "Frames processed slower than the deadline", offsetof(audio_doa_stats_t, deadline_misses)},
+    {"audio_doa_deadline_worst_overrun_microseconds", "gauge", "Largest time past the deadline of a single frame", offsetof(audio_doa_stats_t, deadline_worst_overrun_us)},
+    {"audio_doa_window_switches_total", "counter", "Frames analysed with a different window than the previous one", offsetof(audio_doa_stats_t, window_switches)},
+};
+
+static const char *const s_window_names[AUDIO_DOA_WINDOW_NUM] = {"short", "frame", "long"};
+
+static const struct {
+    const char  *decision;
+    size_t       offset;
+} s_tracker_decisions[] = {
+    {"output", offsetof(audio_doa_stats_t, tracker_outputs)},
+    {"rejected", offsetof(audio_doa_stats_t, tracker_rejected)},
+    {"held", offsetof(audio_doa_stats_t, tracker_held)},
+    {"reset", offsetof(audio_doa_stats_t, tracker_resets)},
+};
+
+static void audio_doa_metrics_printf(audio_doa_metrics_out_t *out, const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    bool room = out->len < out->size;
+    int n = vsnprintf(room ? out->buf + out->len : NULL, room ? out->size - out->len : 0, fmt, ap);
+    va_end(ap);
+    if (n > 0) {
+        out->len += n;
+    }
+}
+
+/**
+ * @brief  Print a label value with the escapes of the exposition format
+ */
+static void audio_doa_metrics_label(audio_doa_metrics_out_t *out, const char *value)
+{
+    for (const char *c = value ? value : ""; *c; c++) {
+        if (*c == '\\' || *c == '"') {
+            audio_doa_metrics_printf(out, "\\%c", *c);
+        } else if (*c == '\n') {
+            audio_doa_metrics_printf(out, "\\n");
+        } else {
+            audio_doa_metrics_printf(out, "%c", *c);
+        }
+    }
+}
+
+static void audio_doa_metrics_header(audio_doa_metrics_out_t *out, const char *name, const char *type, const char *help)
+{
+    audio_doa_metrics_printf(out, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+static void audio_doa_metrics_sample_start(audio_doa_metrics_out_t *out, const char *name, const audio_doa_metrics_entry_t *entry)
+{
+    audio_doa_metrics_printf(out, "%s{instance=\"", name);
+    audio_doa_metrics_label(out, entry->name);
+    audio_doa_metrics_printf(out, "\"");
+}
+
+static inline uint32_t audio_doa_metrics_field(const audio_doa_stats_t *stats, size_t offset)
+{
+    return *(const uint32_t *)((const uint8_t *)stats + offset);
+}
+
+static void audio_doa_metrics_collect(audio_doa_metrics_t *metrics)
+{
+    for (int i = 0; i < metrics->entry_num; i++) {
+        audio_doa_metrics_entry_t *entry = &metrics->entries[i];
+        if (audio_doa_app_get_stats(entry->app, &entry->stats) != ESP_OK) {
+            memset(&entry->stats, 0, sizeof(entry->stats));
+        }
+        if (audio_doa_app_get_stage_stats(entry->app, entry->stages, AUDIO_DOA_MAX_STAGES, &entry->stage_num) != ESP_OK) {
+            entry->stage_num = 0;
+        }
+    }
+}
+
+static void audio_doa_metrics_format(audio_doa_metrics_t *metrics, audio_doa_metrics_out_t *out)
+{
+    audio_doa_metrics_entry_t *entries = metrics->entries;
+    for (size_t m = 0; m < sizeof(s_stat_metrics) / sizeof(s_stat_metrics[0]); m++) {
+        const audio_doa_metric_t *metric = &s_stat_metrics[m];
+        audio_doa_metrics_header(out, metric->name, metric->type, metric->help);
+        for (int i = 0; i < metrics->entry_num; i++) {
+            audio_doa_metrics_sample_start(out, metric->name, &entries[i]);
+            audio_doa_metrics_printf(out, "} %lu\n", (unsigned long)audio_doa_metrics_field(&entries[i].stats, metric->offset));
+        }
+    }
+
+    audio_doa_metrics_header(out, "audio_doa_tracker_decisions_total", "counter", "Tracker decisions by outcome");
+    for (int i = 0; i < metrics->entry_num; i++) {
+        for (size_t d = 0; d < sizeof(s_tracker_decisions) / sizeof(s_tracker_decisions[0]); d++) {
+            audio_doa_metrics_sample_start(out, "audio_doa_tracker_decisions_total", &entries[i]);
+            audio_doa_metrics_printf(out, ",decision=\"%s\"} %lu\n", s_tracker_decisions[d].decision,
+                                     (unsigned long)audio_doa_metrics_field(&entries[i].stats, s_tracker_decisions[d].offset));
+        }
+    }
+
+    audio_doa_metrics_header(out, "audio_doa_window_frames_total", "counter", "Estimates made per analysis window");
+    for (int i = 0; i < metrics->entry_num; i++) {
+        for (int w = 0; w < AUDIO_DOA_WINDOW_NUM; w++) {
+            audio_doa_metrics_sample_start(out, "audio_doa_window_frames_total", &entries[i]);
+            audio_doa_metrics_printf(out, ",window=\"%s\"} %lu\n", s_window_names[w], (unsigned long)entries[i].stats.windows[w].frames);
+        }
+    }
+
+    // Buckets are stored per range, the format wants them cumulative
+    audio_doa_metrics_header(out, "audio_doa_frame_processing_seconds", "histogram", "Primary chain time per frame");
+    for (int i = 0; i < metrics->entry_num; i++) {
+        const audio_doa_stats_t *stats = &entries[i].stats;
+        uint64_t count = 0;
+        for (int b = 0; b < AUDIO_DOA_FRAME_TIME_BUCKETS; b++) {
+            count += stats->frame_time_hist[b];
+            audio_doa_metrics_sample_start(out, "audio_doa_frame_processing_seconds_bucket", &entries[i]);
+            if (b < AUDIO_DOA_FRAME_TIME_BUCKETS - 1) {
+                audio_doa_metrics_printf(out, ",le=\"%g\"} %llu\n", AUDIO_DOA_FRAME_TIME_BUCKET_US(b) / 1e6, (unsigned long long)count);
+            } else {
+                audio_doa_metrics_printf(out, ",le=\"+Inf\"} %llu\n", (unsigned long long)count);
+            }
+        }
+        audio_doa_metrics_sample_start(out, "audio_doa_frame_processing_seconds_sum", &entries[i]);
+        audio_doa_metrics_printf(out, "} %g\n", (double)stats->frame_time_sum_us / 1e6);
+        audio_doa_metrics_sample_start(out, "audio_doa_frame_processing_seconds_count", &entries[i]);
+        audio_doa_metrics_printf(out, "} %llu\n", (unsigned long long)count);
+    }
+
+    static const char *stage_metrics[][3] = {
+        {"audio_doa_stage_calls_total", "counter", "Frames that reached the stage"},
+        {"audio_doa_stage_avg_seconds", "gauge", "Average time per call of the stage"},
+        {"audio_doa_stage_max_seconds", "gauge", "Longest call of the stage"},
+    };
+    for (int m = 0; m < 3; m++) {
+        audio_doa_metrics_header(out, stage_metrics[m][0], stage_metrics[m][1], stage_metrics[m][2]);
+        for (int i = 0; i < metrics->entry_num; i++) {
+            for (int s = 0; s < entries[i].stage_num; s++) {
+                const audio_doa_stage_stats_t *stage = &entries[i].stages[s];
+                audio_doa_metrics_sample_start(out, stage_metrics[m][0], &entries[i]);
+                audio_doa_metrics_printf(out, ",stage=\"");
+                audio_doa_metrics_label(out, stage->name);
+                if (m == 0) {
+                    audio_doa_metrics_printf(out, "\"} %lu\n", (unsigned long)stage->calls);
+                } else {
+                    audio_doa_metrics_printf(out, "\"} %g\n", (m == 1 ? stage->avg_us : stage->max_us) / 1e6);
+                }
+            }
+        }
+    }
+}
+
+static bool audio_doa_metrics_send_all(int fd, const char *data, size_t len)
+{
+    while (len > 0) {
+        ssize_t sent = send(fd, data, len, 0);
+        if (sent <= 0) {
+            return false;
+        }
+        data += sent;
+        len -= sent;
+    }
+    return true;
+}
+
+static void audio_doa_metrics_serve(audio_doa_metrics_t *metrics, int fd)
+{
+    struct timeval timeout = {.tv_sec = METRICS_RECV_TIMEOUT_S};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    char request[METRICS_REQUEST_MAX + 1];
+    size_t got = 0;
+    // Only the request line matters, stop at the end of the headers or a full buffer
+    while (got < METRICS_REQUEST_MAX) {
+        ssize_t n = recv(fd, request + got, METRICS_REQUEST_MAX - got, 0);
+        if (n <= 0) {
+            break;
+        }
+        got += n;
+        request[got] = '\0';
+        if (strstr(request, "\r\n\r\n") != NULL || strstr(request, "\n\n") != NULL) {
+            break;
+        }
+    }
+    request[got] = '\0';
+    if (strncmp(request, "GET /metrics", 12) != 0 || (request[12] != ' ' && request[12] != '?')) {
+        static const char not_found[] = "HTTP/1.0 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+        audio_doa_metrics_send_all(fd, not_found, sizeof(not_found) - 1);
+        return;
+    }
+
+    xSemaphoreTake(metrics->lock, portMAX_DELAY);
+    audio_doa_metrics_collect(metrics);
+    audio_doa_metrics_out_t out = {0};
+    audio_doa_metrics_format(metrics, &out);
+    out.size = out.len + 1;
+    out.len = 0;
+    out.buf = (char *)malloc(out.size);
+    if (out.buf != NULL) {
+        audio_doa_metrics_format(metrics, &out);
+    }
+    xSemaphoreGive(metrics->lock);
+
+    if (out.buf == NULL) {
+        static const char unavailable[] = "HTTP/1.0 503 Service Unavailable\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+        audio_doa_metrics_send_all(fd, unavailable, sizeof(unavailable) - 1);
+        return;
+    }
+    char header[128];
+    int header_len = snprintf(header, sizeof(header),
+                              "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"
+                              "Content-Length: %u\r\nConnection: close\r\n\r\n", (unsigned)out.len);
+    if (audio_doa_metrics_send_all(fd, header, header_len)) {
+        audio_doa_metrics_send_all(fd, out.buf, out.len);
+    }
+    free(out.buf);
+}
+
+static void audio_doa_metrics_thread(void *arg)
+{
+    audio_doa_metrics_t *metrics = (audio_doa_metrics_t *)arg;
+    while (!atomic_load(&metrics->stopping)) {
+        int fd = accept(metrics->listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (!atomic_load(&metrics->stopping)) {
+                vTaskDelay(pdMS_TO_TICKS(100));
+            }
+            continue;
+        }
+        audio_doa_metrics_serve(metrics, fd);
+        close(fd);
+    }
+    xSemaphoreGive(metrics->stopped);
+    vTaskDelete(NULL);
+}
+
+static esp_err_t audio_doa_metrics_listen(audio_doa_metrics_t *metrics, const audio_doa_metrics_cfg_t *cfg)
+{
+    int fd = -1;
+    int ret = -1;
+    if (cfg->unix_path != NULL) {
+#if CONFIG_IDF_TARGET_LINUX
+        struct sockaddr_un addr = {.sun_family = AF_UNIX};
+        if (strlen(cfg->unix_path) >= sizeof(addr.sun_path)) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        strcpy(addr.sun_path, cfg->unix_path);
+        metrics->unix_path = strdup(cfg->unix_path);
+        if (metrics->unix_path == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+        unlink(cfg->unix_path);  // A stale socket file from an earlier run blocks bind()
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd >= 0) {
+            ret = bind(fd, (struct sockaddr *)&addr, sizeof(addr));
+        }
+#else
+        return ESP_ERR_NOT_SUPPORTED;
+#endif  /* CONFIG_IDF_TARGET_LINUX */
+    } else {
+        struct sockaddr_in addr = {
+            .sin_family = AF_INET,
+            .sin_port = htons(cfg->port ? cfg->port : METRICS_DEFAULT_PORT),
+            .sin_addr.s_addr = htonl(cfg->bind_any ? INADDR_ANY : INADDR_LOOPBACK),
+        };
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd >= 0) {
+            int reuse = 1;
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+            ret = bind(fd, (struct sockaddr *)&addr, sizeof(addr));
+        }
+    }
+    if (ret == 0) {
+        ret = listen(fd, 2);
+    }
+    if (ret != 0) {
+        ESP_LOGE(TAG, "Failed to open the metrics socket");
+        if (fd >= 0) {
+            close(fd);
+        }
+        return ESP_FAIL;
+    }
+    metrics->listen_fd = fd;
+    return ESP_OK;
+}
+
+static void audio_doa_metrics_free(audio_doa_metrics_t *metrics)
+{
+    if (metrics->lock != NULL) {
+        vSemaphoreDelete(metrics->lock);
+    }
+    if (metrics->stopped != NULL) {
+        vSemaphoreDelete(metrics->stopped);
+    }
+    if (metrics->unix_path != NULL) {
+        unlink(metrics->unix_path);
+        free(metrics->unix_path);
+    }
+    free(metrics);
+}
+
+esp_err_t audio_doa_metrics_start(const audio_doa_metrics_cfg_t *cfg, audio_doa_metrics_handle_t *out_handle)
+{
+    if (out_handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    audio_doa_metrics_cfg_t default_cfg = {0};
+    if (cfg == NULL) {
+        cfg = &default_cfg;
+    }
+
+    audio_doa_metrics_t *metrics = (audio_doa_metrics_t *)calloc(1, sizeof(audio_doa_metrics_t));
+    if (metrics == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    metrics->listen_fd = -1;
+    atomic_init(&metrics->stopping, false);
+    metrics->lock = xSemaphoreCreateMutex();
+    metrics->stopped = xSemaphoreCreateBinary();
+    if (metrics->lock == NULL || metrics->stopped == NULL) {
+        audio_doa_metrics_free(metrics);
+        return ESP_ERR_NO_MEM;
+    }
+    esp_err_t ret = audio_doa_metrics_listen(metrics, cfg);
+    if (ret != ESP_OK) {
+        audio_doa_metrics_free(metrics);
+        return ret;
+    }
+    if (xTaskCreate(audio_doa_metrics_thread, "audio_doa_metrics", METRICS_TASK_STACK_SIZE, metrics,
+                    cfg->task_priority ? cfg->task_priority : METRICS_DEFAULT_PRIORITY, NULL) != pdPASS) {
+        close(metrics->listen_fd);
+        audio_doa_metrics_free(metrics);
+        ESP_LOGE(TAG, "Failed to create metrics thread");
+        return ESP_ERR_NO_MEM;
+    }
+    *out_handle = (audio_doa_metrics_handle_t)metrics;
+    return ESP_OK;
+}
+
+esp_err_t audio_doa_metrics_add(audio_doa_metrics_handle_t handle, audio_doa_app_handle_t app, const char *name)
+{
+    if (handle == NULL || app == NULL || name == NULL || strlen(name) >= AUDIO_DOA_METRICS_NAME_LEN) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    audio_doa_metrics_t *metrics = (audio_doa_metrics_t *)handle;
+    esp_err_t ret = ESP_ERR_NO_MEM;
+    xSemaphoreTake(metrics->lock, portMAX_DELAY);
+    if (metrics->entry_num < AUDIO_DOA_METRICS_MAX_INSTANCES) {
+        audio_doa_metrics_entry_t *entry = &metrics->entries[metrics->entry_num++];
+        memset(entry, 0, sizeof(*entry));
+        entry->app = app;
+        strcpy(entry->name, name);
+        ret = ESP_OK;
+    }
+    xSemaphoreGive(metrics->lock);
+    return ret;
+}
+
+esp_err_t audio_doa_metrics_remove(audio_doa_metrics_handle_t handle, audio_doa_app_handle_t app)
+{
+    if (handle == NULL || app == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    audio_doa_metrics_t *metrics = (audio_doa_metrics_t *)handle;
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    xSemaphoreTake(metrics->lock, portMAX_DELAY);
+    for (int i = 0; i < metrics->entry_num; i++) {
+        if (metrics->entries[i].app == app) {
+            metrics->entries[i] = metrics->entries[--metrics->entry_num];
+            ret = ESP_OK;
+            break;
+        }
+    }
+    xSemaphoreGive(metrics->lock);
+    return ret;
+}
+
+esp_err_t audio_doa_metrics_render(audio_doa_metrics_handle_t handle, char *buf, size_t size, size_t *len)
+{
+    if (handle == NULL || (buf == NULL && size > 0) || len == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    audio_doa_metrics_t *metrics = (audio_doa_metrics_t *)handle;
+    audio_doa_metrics_out_t out = {.buf = buf, .size = size};
+    xSemaphoreTake(metrics->lock, portMAX_DELAY);
+    audio_doa_metrics_collect(metrics);
+    audio_doa_metrics_format(metrics, &out);
+    xSemaphoreGive(metrics->lock);
+    *len = out.len;
+    return out.len < size ? ESP_OK : ESP_ERR_INVALID_SIZE;
+}
+
+esp_err_t audio_doa_metrics_stop(audio_doa_metrics_handle_t handle)
+{
+    if (handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    audio_doa_metrics_t *metrics = (audio_doa_metrics_t *)handle;
+    atomic_store(&metrics->stopping, true);
+    // Wakes the server task out of accept()
+    shutdown(metrics->listen_fd, SHUT_RDWR);
+    close(metrics->listen_fd);
+    xSemaphoreTake(metrics->stopped, portMAX_DELAY);
+    audio_doa_metrics_free(metrics);
+    return ESP_OK;
+}
@@ -0,0 +1,144 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "audio_doa_onebit.h"
+
+#include "esp_log.h"
+
+#define TAG "AUDIO_DOA_1BIT"
+
+#define ONEBIT_SPEED_OF_SOUND 343.0f
+#define ONEBIT_WORD_BITS      32
+#define ONEBIT_MAX_LAG        (ONEBIT_WORD_BITS - 1)
+
+struct audio_doa_onebit {
+    int        frame_samples;
+    int        words;
+    int        max_lag;
+    float      lag_to_cos;   /*!< c / (fs * d): converts a lag in samples to cos(angle) */
+    uint32_t  *bits[2];      /*!< Packed sign bits, LSB first = earliest sample */
+    int32_t   *score;        /*!< 2 * max_lag + 1 sign correlation values */
+};
+
+static void onebit_pack(const int16_t *x, int samples, uint32_t *out)
+{
+    for (int w = 0; w < samples / ONEBIT_WORD_BITS; w++) {
+        uint32_t word = 0;
+        const int16_t *p = &x[w * ONEBIT_WORD_BITS];
+        for (int b = 0; b < ONEBIT_WORD_BITS; b++) {
+            word |= (uint32_t)(p[b] >= 0) << b;
+        }
+        out[w] = word;
+    }
+}
+
+/**
+ * @brief  Count sign disagreements between a[n] and b[n + shift] for 0 <= n < samples - shift
+ */
+static int onebit_mismatch(const uint32_t *a, const uint32_t *b, int words, int shift)
+{
+    int count = 0;
+    for (int w = 0; w < words - 1; w++) {
+        uint32_t shifted = shift ? (b[w] >> shift) | (b[w + 1] << (ONEBIT_WORD_BITS - shift)) : b[w];
+        count += __builtin_popcount(a[w] ^ shifted);
+    }
+    // The last word only has ONEBIT_WORD_BITS - shift valid pairs
+    uint32_t mask = shift ? (0xFFFFFFFFu >> shift) : 0xFFFFFFFFu;
+    count += __builtin_popcount((a[words - 1] ^ (b[words - 1] >> shift)) & mask);
+    return count;
+}
+
+float audio_doa_onebit_process(audio_doa_onebit_t *engine, const int16_t *left, const int16_t *right)
+{
+    onebit_pack(left, engine->frame_samples, engine->bits[0]);
+    onebit_pack(right, engine->frame_samples, engine->bits[1]);
+
+    // score(lag) = agreements - disagreements of left[n] and right[n + lag]
+    int best = 0;
+    for (int lag = -engine->max_lag; lag <= engine->max_lag; lag++) {
+        int shift = lag >= 0 ? lag : -lag;
+        int pairs = engine->frame_samples - shift;
+        int mismatch = lag >= 0 ? onebit_mismatch(engine->bits[0], engine->bits[1], engine->words, shift)
+                                : onebit_mismatch(engine->bits[1], engine->bits[0], engine->words, shift);
+        // Normalise to the full frame so shorter overlaps at large lags are not penalised
+        engine->score[lag + engine->max_lag] = (pairs - 2 * mismatch) * engine->frame_samples / pairs;
+        if (engine->score[lag + engine->max_lag] > engine->score[best]) {
+            best = lag + engine->max_lag;
+        }
+    }
+
+    // Sub-sample lag of the peak. The sign correlation of Gaussian signals is
+    // (2 / pi) asin(rho) (Van Vleck), whose cusp at the peak pulls a parabola fitted to
+    // it towards integer lags: undo it first, then fit y(k) = A cos(w (k - d)), which is
+    // exact for a narrowband peak and much closer than a parabola for a broadband one.
+    float offset = 0.0f;
+    if (best > 0 && best < 2 * engine->max_lag) {
+        float scale = (float)M_PI / 2.0f / engine->frame_samples;
+        float ym = sinf(engine->score[best - 1] * scale);
+        float y0 = sinf(engine->score[best] * scale);
+        float yp = sinf(engine->score[best + 1] * scale);
+        float c = y0 > 0.0f ? (ym + yp) / (2.0f * y0) : 1.0f;
+        if (c < 1.0f) {
+            float w = acosf(c < -1.0f ? -1.0f : c);
+            offset = atanf((yp - ym) / (2.0f * y0 * sinf(w))) / w;
+        }
+    }
+    float lag = best - engine->max_lag + offset;
+
+    // Left leads for sources on the 0 degree side, which is a positive lag
+    float cos_angle = lag * engine->lag_to_cos;
+    if (cos_angle > 1.0f) {
+        cos_angle = 1.0f;
+    } else if (cos_angle < -1.0f) {
+        cos_angle = -1.0f;
+    }
+    return acosf(cos_angle) * 180.0f / (float)M_PI;
+}
+
+audio_doa_onebit_t *audio_doa_onebit_create(int sample_rate, float distance, int frame_samples)
+{
+    if (sample_rate <= 0 || distance <= 0.0f || frame_samples < ONEBIT_WORD_BITS ||
+        frame_samples % ONEBIT_WORD_BITS != 0) {
+        ESP_LOGE(TAG, "Invalid 1-bit engine configuration");
+        return NULL;
+    }
+    audio_doa_onebit_t *engine = (audio_doa_onebit_t *)calloc(1, sizeof(audio_doa_onebit_t));
+    if (engine == NULL) {
+        return NULL;
+    }
+    engine->frame_samples = frame_samples;
+    engine->words = frame_samples / ONEBIT_WORD_BITS;
+    engine->lag_to_cos = ONEBIT_SPEED_OF_SOUND / (sample_rate * distance);
+    // One extra lag on each side so the peak can be interpolated at end-fire
+    engine->max_lag = (int)ceilf(distance * sample_rate / ONEBIT_SPEED_OF_SOUND) + 1;
+    if (engine->max_lag > ONEBIT_MAX_LAG) {
+        ESP_LOGW(TAG, "Lag range %d clamped to %d", engine->max_lag, ONEBIT_MAX_LAG);
+        engine->max_lag = ONEBIT_MAX_LAG;
+    }
+    engine->bits[0] = (uint32_t *)calloc(engine->words, sizeof(uint32_t));
+    engine->bits[1] = (uint32_t *)calloc(engine->words, sizeof(uint32_t));
+    engine->score = (int32_t *)calloc(2 * engine->max_lag + 1, sizeof(int32_t));
+    if (engine->bits[0] == NULL || engine->bits[1] == NULL || engine->score == NULL) {
+        audio_doa_onebit_destroy(engine);
+        return NULL;
+    }
+    return engine;
+}
+
+void audio_doa_onebit_destroy(audio_doa_onebit_t *engine)
+{
+    if (engine == NULL) {
+        return;
+    }
+    free(engine->score);
+    free(engine->bits[1]);
+    free(engine->bits[0]);
+    free(engine);
+}
@@ -0,0 +1,85 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdio.h>
+#include <errno.h>
+#include "esp_log.h"
+#include "nvs.h"
+#include "audio_doa_persist.h"
+
+static const char *TAG = "DOA_PERSIST";
+
+esp_err_t audio_doa_persist_nvs_save(const void *blob, size_t size, void *ctx)
+{
+    if (blob == NULL || ctx == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    nvs_handle_t nvs;
+    esp_err_t ret = nvs_open(AUDIO_DOA_PERSIST_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open NVS: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    ret = nvs_set_blob(nvs, (const char *)ctx, blob, size);
+    if (ret == ESP_OK) {
+        ret = nvs_commit(nvs);
+    }
+    nvs_close(nvs);
+    return ret;
+}
+
+esp_err_t audio_doa_persist_nvs_load(void *blob, size_t *size, void *ctx)
+{
+    if (blob == NULL || size == NULL || ctx == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    nvs_handle_t nvs;
+    esp_err_t ret = nvs_open(AUDIO_DOA_PERSIST_NVS_NAMESPACE, NVS_READONLY, &nvs);
+    if (ret == ESP_ERR_NVS_NOT_FOUND) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    ret = nvs_get_blob(nvs, (const char *)ctx, blob, size);
+    nvs_close(nvs);
+    return ret == ESP_ERR_NVS_NOT_FOUND ? ESP_ERR_NOT_FOUND : ret;
+}
+
+esp_err_t audio_doa_persist_file_save(const void *blob, size_t size, void *ctx)
+{
+    if (blob == NULL || ctx == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    FILE *fp = fopen((const char *)ctx, "wb");
+    if (fp == NULL) {
+        ESP_LOGE(TAG, "Failed to open %s", (const char *)ctx);
+        return ESP_FAIL;
+    }
+    size_t written = fwrite(blob, 1, size, fp);
+    if (fclose(fp) != 0 || written != size) {
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t audio_doa_persist_file_load(void *blob, size_t *size, void *ctx)
+{
+    if (blob == NULL || size == NULL || ctx == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    FILE *fp = fopen((const char *)ctx, "rb");
+    if (fp == NULL) {
+        return errno == ENOENT ? ESP_ERR_NOT_FOUND : ESP_FAIL;
+    }
+    *size = fread(blob, 1, *size, fp);
+    fclose(fp);
+    return ESP_OK;
+}
@@ -0,0 +1,148 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include <stdatomic.h>
+#include "sdkconfig.h"
+#include "esp_cpu.h"
+#include "esp_timer.h"
+#include "audio_doa_pipeline.h"
+#include "audio_doa_profiling.h"
+
+esp_err_t audio_doa_pipeline_add(audio_doa_pipeline_t *pipeline, const audio_doa_stage_t *stage)
+{
+    if (pipeline == NULL || stage == NULL || stage->process == NULL ||
+        stage->kind < AUDIO_DOA_STAGE_SOURCE || stage->kind >= AUDIO_DOA_STAGE_KIND_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (pipeline->stage_num >= AUDIO_DOA_MAX_STAGES) {
+        return ESP_ERR_NO_MEM;
+    }
+    int pos = pipeline->stage_num;
+    while (pos > 0 && pipeline->slots[pos - 1].stage.kind > stage->kind) {
+        pos--;
+    }
+    memmove(&pipeline->slots[pos + 1], &pipeline->slots[pos], (pipeline->stage_num - pos) * sizeof(audio_doa_stage_slot_t));
+    memset(&pipeline->slots[pos], 0, sizeof(audio_doa_stage_slot_t));
+    pipeline->slots[pos].stage = *stage;
+    pipeline->stage_num++;
+    return ESP_OK;
+}
+
+#if CONFIG_AUDIO_DOA_STAGE_TIMING
+static inline void audio_doa_slot_record(audio_doa_stage_slot_t *slot, uint32_t elapsed_us)
+{
+    slot->total_us += elapsed_us;
+    slot->calls++;
+    if (elapsed_us > slot->max_us) {
+        slot->max_us = elapsed_us;
+    }
+}
+#endif  /* CONFIG_AUDIO_DOA_STAGE_TIMING */
+
+#if CONFIG_AUDIO_DOA_PROFILING_HOOKS
+static const audio_doa_profiling_hooks_t *_Atomic s_profiling_hooks;
+
+esp_err_t audio_doa_set_profiling_hooks(const audio_doa_profiling_hooks_t *hooks)
+{
+    atomic_store(&s_profiling_hooks, hooks);
+    return ESP_OK;
+}
+
+static bool audio_doa_pipeline_run_profiled(audio_doa_pipeline_t *pipeline, audio_doa_frame_t *frame,
+                                            const audio_doa_profiling_hooks_t *hooks)
+{
+    audio_doa_stage_slot_t *end = pipeline->slots + pipeline->stage_num;
+    for (audio_doa_stage_slot_t *slot = pipeline->slots; slot < end; slot++) {
+        if (hooks->begin) {
+            hooks->begin(pipeline->instance_id, frame->index, &slot->stage, hooks->ctx);
+        }
+#if CONFIG_AUDIO_DOA_STAGE_TIMING
+        int64_t start_us = pipeline->timed ? esp_timer_get_time() : 0;
+        bool keep = slot->stage.process(frame, slot->stage.ctx);
+        if (pipeline->timed) {
+            audio_doa_slot_record(slot, (uint32_t)(esp_timer_get_time() - start_us));
+        }
+#else
+        bool keep = slot->stage.process(frame, slot->stage.ctx);
+#endif  /* CONFIG_AUDIO_DOA_STAGE_TIMING */
+        if (hooks->end) {
+            hooks->end(pipeline->instance_id, frame->index, &slot->stage, hooks->ctx);
+        }
+        if (!keep) {
+            return false;
+        }
+    }
+    return true;
+}
+#else
+esp_err_t audio_doa_set_profiling_hooks(const audio_doa_profiling_hooks_t *hooks)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+#endif  /* CONFIG_AUDIO_DOA_PROFILING_HOOKS */
+
+bool audio_doa_pipeline_run(audio_doa_pipeline_t *pipeline, audio_doa_frame_t *frame)
+{
+    audio_doa_stage_slot_t *slot = pipeline->slots;
+    audio_doa_stage_slot_t *end = slot + pipeline->stage_num;
+#if CONFIG_AUDIO_DOA_PROFILING_HOOKS
+    const audio_doa_profiling_hooks_t *hooks = atomic_load(&s_profiling_hooks);
+    if (hooks != NULL) {
+        return audio_doa_pipeline_run_profiled(pipeline, frame, hooks);
+    }
+#endif  /* CONFIG_AUDIO_DOA_PROFILING_HOOKS */
+#if CONFIG_AUDIO_DOA_STAGE_TIMING
+    if (!pipeline->timed) {
+#endif  /* CONFIG_AUDIO_DOA_STAGE_TIMING */
+        for (; slot < end; slot++) {
+            if (!slot->stage.process(frame, slot->stage.ctx)) {
+                return false;
+            }
+        }
+        return true;
+#if CONFIG_AUDIO_DOA_STAGE_TIMING
+    }
+    for (; slot < end; slot++) {
+        int64_t start_us = esp_timer_get_time();
+        bool keep = slot->stage.process(frame, slot->stage.ctx);
+        audio_doa_slot_record(slot, (uint32_t)(esp_timer_get_time() - start_us));
+        if (!keep) {
+            return false;
+        }
+    }
+    return true;
+#endif  /* CONFIG_AUDIO_DOA_STAGE_TIMING */
+}
+
+bool audio_doa_pipeline_run_counted(audio_doa_pipeline_t *pipeline, audio_doa_frame_t *frame, uint64_t *cycles, uint32_t *calls)
+{
+    for (int i = 0; i < pipeline->stage_num; i++) {
+        audio_doa_stage_slot_t *slot = &pipeline->slots[i];
+        esp_cpu_cycle_count_t start = esp_cpu_get_cycle_count();
+        bool keep = slot->stage.process(frame, slot->stage.ctx);
+        cycles[i] += (uint32_t)(esp_cpu_get_cycle_count() - start);
+        calls[i]++;
+        if (!keep) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int audio_doa_pipeline_get_stats(const audio_doa_pipeline_t *pipeline, audio_doa_stage_stats_t *stats, int max_count)
+{
+    int count = pipeline->stage_num < max_count ? pipeline->stage_num : max_count;
+    for (int i = 0; i < count; i++) {
+        const audio_doa_stage_slot_t *slot = &pipeline->slots[i];
+        stats[i].name = slot->stage.name;
+        stats[i].kind = slot->stage.kind;
+        stats[i].calls = slot->calls;
+        stats[i].avg_us = slot->calls ? (uint32_t)(slot->total_us / slot->calls) : 0;
+        stats[i].max_us = slot->max_us;
+    }
+    return count;
+}
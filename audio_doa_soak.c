@@ -0,0 +1,397 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <stdatomic.h>
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "audio_doa_soak.h"
+
+static const char *TAG = "audio_doa_soak";
+
+#define SOAK_SAMPLE_RATE          16000  // Capture rate the component expects
+#define SOAK_DEFAULT_DURATION_S   3600
+#define SOAK_DEFAULT_REPORT_S     60
+#define SOAK_DEFAULT_DRIFT_MS     20
+#define SOAK_DEFAULT_LEAK_BYTES   4096
+#define SOAK_DEFAULT_STALL_MS     2000
+#define SOAK_LATENCY_BINS         500  // 1 ms bins, the last one collects everything above
+#define SOAK_RING_SIZE            64   // Frames in flight stay far below this
+#define SOAK_SOURCE_RING          8    // Power of two above AUDIO_DOA_MAX_MICS - 1
+#define SOAK_MAX_CHUNK_FRAMES     2
+#define SOAK_STOP_MAX_MS          200
+
+// Odds per chunk out of 10000; chunks average one frame (32 ms), so about every 3 s, 16 s and 1 min
+#define SOAK_ODDS_VAD       100
+#define SOAK_ODDS_RESTART   20
+#define SOAK_ODDS_RECONFIG  5
+
+typedef struct {
+    audio_doa_app_handle_t   app;
+    audio_doa_app_config_t   config;        /*!< Current configuration, varied on reconfigure */
+    audio_doa_soak_cfg_t     cfg;
+    uint32_t                 rand;
+    bool                     vad;
+    int                      frame_bytes;
+    int                      sample_bytes;  /*!< One sample of every channel */
+    int16_t                 *chunk;
+    int16_t                  source[SOAK_SOURCE_RING];
+    uint32_t                 source_pos;
+    int                      frame_fill;    /*!< Bytes of the current frame written */
+    int64_t                  pace_start_us;
+    uint64_t                 pace_samples;
+    int64_t                  frame_time_us[SOAK_RING_SIZE];  /*!< Write time of each frame in flight */
+    atomic_uint              frames_written;
+    atomic_uint              results;
+    atomic_uint              tracker_results;
+    atomic_uint              latency_max_ms;
+    uint32_t                *latency_hist;  /*!< Whole run, only written by the DOA task */
+    uint32_t                *latency_prev;  /*!< Copy of `latency_hist` at the last report */
+    uint32_t                 first_p95_ms;
+    bool                     has_first_p95;
+    size_t                   heap_baseline;
+    uint32_t                 dropped_done;    /*!< samples_dropped of destroyed instances */
+    uint32_t                 discarded_done;  /*!< frames_discarded of destroyed instances */
+    audio_doa_soak_report_t  report;
+} audio_doa_soak_t;
+
+static inline uint32_t audio_doa_soak_rand(audio_doa_soak_t *soak)
+{
+    soak->rand = soak->rand * 1664525u + 1013904223u;
+    return soak->rand >> 8;
+}
+
+static void audio_doa_soak_monitor_callback(float angle, void *ctx)
+{
+    audio_doa_soak_t *soak = (audio_doa_soak_t *)ctx;
+    uint32_t n = atomic_load(&soak->results);
+    if (n >= atomic_load(&soak->frames_written)) {
+        return;
+    }
+    uint32_t latency_ms = (uint32_t)((esp_timer_get_time() - soak->frame_time_us[n % SOAK_RING_SIZE]) / 1000);
+    soak->latency_hist[latency_ms < SOAK_LATENCY_BINS ? latency_ms : SOAK_LATENCY_BINS - 1]++;
+    if (latency_ms > atomic_load(&soak->latency_max_ms)) {
+        atomic_store(&soak->latency_max_ms, latency_ms);
+    }
+    atomic_store(&soak->results, n + 1);
+}
+
+static void audio_doa_soak_result_callback(float angle, void *ctx)
+{
+    audio_doa_soak_t *soak = (audio_doa_soak_t *)ctx;
+    atomic_fetch_add(&soak->tracker_results, 1);
+}
+
+static uint32_t audio_doa_soak_count(const uint32_t *hist, const uint32_t *base)
+{
+    uint32_t count = 0;
+    for (int i = 0; i < SOAK_LATENCY_BINS; i++) {
+        count += hist[i] - (base ? base[i] : 0);
+    }
+    return count;
+}
+
+static uint32_t audio_doa_soak_percentile(const uint32_t *hist, const uint32_t *base, int pct)
+{
+    uint32_t target = (uint32_t)(((uint64_t)audio_doa_soak_count(hist, base) * pct + 99) / 100);
+    uint32_t seen = 0;
+    for (int i = 0; i < SOAK_LATENCY_BINS; i++) {
+        seen += hist[i] - (base ? base[i] : 0);
+        if (seen >= target) {
+            return i;
+        }
+    }
+    return SOAK_LATENCY_BINS - 1;
+}
+
+static void audio_doa_soak_fail(audio_doa_soak_t *soak, uint32_t flag, const char *what)
+{
+    if (!(soak->report.failures & flag)) {
+        ESP_LOGE(TAG, "Soak failure at %" PRIu32 " s: %s", soak->report.elapsed_s, what);
+    }
+    soak->report.failures |= flag;
+}
+
+static void audio_doa_soak_check(audio_doa_soak_t *soak, esp_err_t ret)
+{
+    if (ret != ESP_OK) {
+        audio_doa_soak_fail(soak, AUDIO_DOA_SOAK_FAIL_ERROR, esp_err_to_name(ret));
+    }
+}
+
+/**
+ * @brief  Wait until every written frame has its result
+ */
+static void audio_doa_soak_drain(audio_doa_soak_t *soak)
+{
+    int64_t deadline_us = esp_timer_get_time() + (int64_t)soak->cfg.stall_ms * 1000;
+    while (atomic_load(&soak->results) < atomic_load(&soak->frames_written)) {
+        if (esp_timer_get_time() > deadline_us) {
+            audio_doa_soak_fail(soak, AUDIO_DOA_SOAK_FAIL_STALL, "frames without result");
+            // Resynchronize so one stall is not reported again for every later frame
+            atomic_store(&soak->results, atomic_load(&soak->frames_written));
+            return;
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
+
+static void audio_doa_soak_reset_pace(audio_doa_soak_t *soak)
+{
+    soak->pace_start_us = esp_timer_get_time();
+    soak->pace_samples = 0;
+}
+
+static void audio_doa_soak_fill(audio_doa_soak_t *soak, int samples)
+{
+    int mic_num = soak->sample_bytes / (int)sizeof(int16_t);
+    for (int i = 0; i < samples; i++) {
+        uint32_t pos = soak->source_pos++;
+        soak->source[pos % SOAK_SOURCE_RING] = (int16_t)((int32_t)(audio_doa_soak_rand(soak) & 0xffff) - 32768) / 8;
+        for (int m = 0; m < mic_num; m++) {
+            soak->chunk[i * mic_num + m] = soak->source[(pos - m) % SOAK_SOURCE_RING];
+        }
+    }
+}
+
+static void audio_doa_soak_write_chunk(audio_doa_soak_t *soak)
+{
+    int samples = 1 + audio_doa_soak_rand(soak) % (SOAK_MAX_CHUNK_FRAMES * CONFIG_AUDIO_DOA_FRAME_SAMPLES);
+    int bytes = samples * soak->sample_bytes;
+    audio_doa_soak_fill(soak, samples);
+    if (soak->vad) {
+        // Stamp the frames this chunk completes before writing, the DOA task may finish them before the write returns
+        uint32_t base = atomic_load(&soak->frames_written);
+        int complete = (soak->frame_fill + bytes) / soak->frame_bytes;
+        int64_t now_us = esp_timer_get_time();
+        for (int i = 0; i < complete; i++) {
+            soak->frame_time_us[(base + i) % SOAK_RING_SIZE] = now_us;
+        }
+        soak->frame_fill = (soak->frame_fill + bytes) % soak->frame_bytes;
+        atomic_store(&soak->frames_written, base + complete);
+    }
+    audio_doa_soak_check(soak, audio_doa_app_data_write(soak->app, (uint8_t *)soak->chunk, bytes));
+    soak->report.bytes_written += bytes;
+
+    soak->pace_samples += samples;
+    int64_t ahead_us = soak->pace_start_us + (int64_t)(soak->pace_samples * 1000000 / SOAK_SAMPLE_RATE) - esp_timer_get_time();
+    if (ahead_us >= (int64_t)portTICK_PERIOD_MS * 1000) {
+        vTaskDelay(pdMS_TO_TICKS(ahead_us / 1000));
+    }
+}
+
+static esp_err_t audio_doa_soak_create(audio_doa_soak_t *soak)
+{
+    esp_err_t ret = audio_doa_app_create(&soak->app, &soak->config);
+    if (ret != ESP_OK) {
+        if (soak->app != NULL) {
+            audio_doa_app_destroy(soak->app);
+            soak->app = NULL;
+        }
+        return ret;
+    }
+    soak->frame_fill = 0;
+    audio_doa_soak_check(soak, audio_doa_app_set_vad_detect(soak->app, soak->vad));
+    audio_doa_soak_reset_pace(soak);
+    return ESP_OK;
+}
+
+static void audio_doa_soak_destroy(audio_doa_soak_t *soak)
+{
+    audio_doa_soak_drain(soak);
+    audio_doa_stats_t stats;
+    if (audio_doa_app_get_stats(soak->app, &stats) == ESP_OK) {
+        soak->dropped_done += stats.samples_dropped;
+        soak->discarded_done += stats.frames_discarded;
+    }
+    audio_doa_soak_check(soak, audio_doa_app_destroy(soak->app));
+    soak->app = NULL;
+    // Nothing of ours is alive here, so the free heap must be back at the baseline
+    int32_t growth = (int32_t)(soak->heap_baseline - heap_caps_get_free_size(MALLOC_CAP_DEFAULT));
+    if (growth > soak->report.heap_growth_bytes) {
+        soak->report.heap_growth_bytes = growth;
+    }
+    if (growth > (int32_t)soak->cfg.leak_bytes) {
+        audio_doa_soak_fail(soak, AUDIO_DOA_SOAK_FAIL_LEAK, "heap not returned after destroy");
+    }
+}
+
+static esp_err_t audio_doa_soak_reconfigure(audio_doa_soak_t *soak)
+{
+    audio_doa_soak_destroy(soak);
+    uint32_t r = audio_doa_soak_rand(soak);
+    soak->config.disable_smoothing = r & 1;
+    soak->config.stage_timing = (r >> 1) & 1;
+#if CONFIG_AUDIO_DOA_DECIMATION
+    soak->config.decimate = (r >> 2) & 1;
+#endif  /* CONFIG_AUDIO_DOA_DECIMATION */
+    soak->report.reconfigures++;
+    return audio_doa_soak_create(soak);
+}
+
+static void audio_doa_soak_restart(audio_doa_soak_t *soak)
+{
+    audio_doa_soak_drain(soak);
+    audio_doa_soak_check(soak, audio_doa_app_stop(soak->app));
+    vTaskDelay(pdMS_TO_TICKS(audio_doa_soak_rand(soak) % SOAK_STOP_MAX_MS + 1));
+    audio_doa_soak_check(soak, audio_doa_app_start(soak->app));
+    audio_doa_soak_reset_pace(soak);
+    soak->report.restarts++;
+}
+
+static void audio_doa_soak_check_stall(audio_doa_soak_t *soak)
+{
+    uint32_t n = atomic_load(&soak->results);
+    if (n < atomic_load(&soak->frames_written) &&
+        esp_timer_get_time() - soak->frame_time_us[n % SOAK_RING_SIZE] > (int64_t)soak->cfg.stall_ms * 1000) {
+        audio_doa_soak_fail(soak, AUDIO_DOA_SOAK_FAIL_STALL, "frame without result");
+        atomic_store(&soak->results, atomic_load(&soak->frames_written));
+    }
+}
+
+static void audio_doa_soak_update_report(audio_doa_soak_t *soak, int64_t start_us)
+{
+    audio_doa_soak_report_t *report = &soak->report;
+    report->elapsed_s = (uint32_t)((esp_timer_get_time() - start_us) / 1000000);
+    report->frames_written = atomic_load(&soak->frames_written);
+    report->results = atomic_load(&soak->results);
+    report->tracker_results = atomic_load(&soak->tracker_results);
+    report->frames_per_s = report->elapsed_s ? (float)report->results / report->elapsed_s : 0.0f;
+    // An interval without results (e.g. VAD off throughout) keeps the previous percentiles
+    bool interval_results = audio_doa_soak_count(soak->latency_hist, soak->latency_prev) > 0;
+    if (interval_results) {
+        report->latency_p50_ms = audio_doa_soak_percentile(soak->latency_hist, soak->latency_prev, 50);
+        report->latency_p95_ms = audio_doa_soak_percentile(soak->latency_hist, soak->latency_prev, 95);
+        report->latency_p99_ms = audio_doa_soak_percentile(soak->latency_hist, soak->latency_prev, 99);
+    }
+    report->latency_total_p99_ms = audio_doa_soak_percentile(soak->latency_hist, NULL, 99);
+    report->latency_max_ms = atomic_load(&soak->latency_max_ms);
+    memcpy(soak->latency_prev, soak->latency_hist, SOAK_LATENCY_BINS * sizeof(uint32_t));
+
+    report->samples_dropped = soak->dropped_done;
+    report->frames_discarded = soak->discarded_done;
+    audio_doa_stats_t stats;
+    if (soak->app != NULL && audio_doa_app_get_stats(soak->app, &stats) == ESP_OK) {
+        report->samples_dropped += stats.samples_dropped;
+        report->frames_discarded += stats.frames_discarded;
+    }
+    if (report->samples_dropped > 0 || report->frames_discarded > 0) {
+        audio_doa_soak_fail(soak, AUDIO_DOA_SOAK_FAIL_DROPPED, "audio dropped at real-time pace");
+    }
+
+    if (interval_results && !soak->has_first_p95) {
+        soak->first_p95_ms = report->latency_p95_ms;
+        soak->has_first_p95 = true;
+    } else if (interval_results && report->latency_p95_ms > soak->first_p95_ms + soak->cfg.drift_ms) {
+        audio_doa_soak_fail(soak, AUDIO_DOA_SOAK_FAIL_LATENCY_DRIFT, "p95 latency drifted");
+    }
+
+    ESP_LOGI(TAG, "%" PRIu32 " s: %" PRIu32 "/%" PRIu32 " frames, %.1f fps, latency p50/p95/p99 %" PRIu32 "/%" PRIu32 "/%" PRIu32
+             " ms, max %" PRIu32 " ms, dropped %" PRIu32 ", heap growth %" PRId32 ", failures 0x%" PRIx32,
+             report->elapsed_s, report->results, report->frames_written, report->frames_per_s, report->latency_p50_ms,
+             report->latency_p95_ms, report->latency_p99_ms, report->latency_max_ms, report->samples_dropped,
+             report->heap_growth_bytes, report->failures);
+    if (soak->cfg.progress != NULL) {
+        soak->cfg.progress(report, soak->cfg.ctx);
+    }
+}
+
+esp_err_t audio_doa_soak_run(const audio_doa_app_config_t *config, const audio_doa_soak_cfg_t *cfg,
+                             audio_doa_soak_report_t *report)
+{
+    if (config == NULL || report == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    audio_doa_soak_t *soak = (audio_doa_soak_t *)calloc(1, sizeof(audio_doa_soak_t));
+    if (soak == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (cfg != NULL) {
+        soak->cfg = *cfg;
+    }
+    soak->cfg.duration_s = soak->cfg.duration_s ? soak->cfg.duration_s : SOAK_DEFAULT_DURATION_S;
+    soak->cfg.report_s = soak->cfg.report_s ? soak->cfg.report_s : SOAK_DEFAULT_REPORT_S;
+    soak->cfg.drift_ms = soak->cfg.drift_ms ? soak->cfg.drift_ms : SOAK_DEFAULT_DRIFT_MS;
+    soak->cfg.leak_bytes = soak->cfg.leak_bytes ? soak->cfg.leak_bytes : SOAK_DEFAULT_LEAK_BYTES;
+    soak->cfg.stall_ms = soak->cfg.stall_ms ? soak->cfg.stall_ms : SOAK_DEFAULT_STALL_MS;
+    soak->rand = soak->cfg.seed ? soak->cfg.seed : 1;
+    atomic_init(&soak->frames_written, 0);
+    atomic_init(&soak->results, 0);
+    atomic_init(&soak->tracker_results, 0);
+    atomic_init(&soak->latency_max_ms, 0);
+
+    // Every written frame must come back as a result, so no gating and only our callbacks
+    soak->config = *config;
+    soak->config.gate_rms = 0.0f;
+    soak->config.angle_log = NULL;
+    soak->config.persist = NULL;
+    soak->config.synchronous = false;
+    soak->config.audio_doa_monitor_callback = audio_doa_soak_monitor_callback;
+    soak->config.audio_doa_monitor_callback_ctx = soak;
+    soak->config.audio_doa_result_callback = audio_doa_soak_result_callback;
+    soak->config.audio_doa_result_callback_ctx = soak;
+    int mic_num = config->mic_num ? config->mic_num : 2;
+    soak->sample_bytes = mic_num * sizeof(int16_t);
+    soak->frame_bytes = CONFIG_AUDIO_DOA_FRAME_SAMPLES * soak->sample_bytes;
+    soak->vad = true;
+
+    soak->chunk = (int16_t *)malloc(SOAK_MAX_CHUNK_FRAMES * soak->frame_bytes);
+    soak->latency_hist = (uint32_t *)calloc(SOAK_LATENCY_BINS, sizeof(uint32_t));
+    soak->latency_prev = (uint32_t *)calloc(SOAK_LATENCY_BINS, sizeof(uint32_t));
+    esp_err_t ret = ESP_ERR_NO_MEM;
+    if (soak->chunk != NULL && soak->latency_hist != NULL && soak->latency_prev != NULL) {
+        // Baseline with the soak's own buffers taken, before the first instance
+        soak->heap_baseline = heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+        ret = audio_doa_soak_create(soak);
+    }
+    if (ret == ESP_OK) {
+        int64_t start_us = esp_timer_get_time();
+        int64_t end_us = start_us + (int64_t)soak->cfg.duration_s * 1000000;
+        int64_t next_report_us = start_us + (int64_t)soak->cfg.report_s * 1000000;
+        while (ret == ESP_OK && esp_timer_get_time() < end_us) {
+            uint32_t event = audio_doa_soak_rand(soak) % 10000;
+            if (event < SOAK_ODDS_RECONFIG) {
+                ret = audio_doa_soak_reconfigure(soak);
+                continue;
+            } else if (event < SOAK_ODDS_RECONFIG + SOAK_ODDS_RESTART) {
+                audio_doa_soak_restart(soak);
+            } else if (event < SOAK_ODDS_RECONFIG + SOAK_ODDS_RESTART + SOAK_ODDS_VAD) {
+                soak->vad = !soak->vad;
+                audio_doa_soak_check(soak, audio_doa_app_set_vad_detect(soak->app, soak->vad));
+                soak->report.vad_toggles++;
+            }
+            audio_doa_soak_write_chunk(soak);
+            audio_doa_soak_check_stall(soak);
+            if (esp_timer_get_time() >= next_report_us) {
+                audio_doa_soak_update_report(soak, start_us);
+                next_report_us += (int64_t)soak->cfg.report_s * 1000000;
+            }
+        }
+        if (soak->app != NULL) {
+            audio_doa_soak_destroy(soak);
+        }
+        audio_doa_soak_update_report(soak, start_us);
+        *report = soak->report;
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Soak aborted: %s", esp_err_to_name(ret));
+    }
+    free(soak->chunk);
+    free(soak->latency_hist);
+    free(soak->latency_prev);
+    free(soak);
+    if (ret == ESP_OK && report->failures != 0) {
+        return ESP_FAIL;
+    }
+    return ret;
+}
@@ -0,0 +1,378 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "audio_doa_srp.h"
+
+#include "esp_log.h"
+
+#define TAG "AUDIO_DOA_SRP"
+
+#define SRP_SPEED_OF_SOUND   343.0f
+#define SRP_ANGLE_RANGE      180.0f
+#define SRP_DEFAULT_COARSE   10.0f
+#define SRP_DEFAULT_FINE     1.0f
+#define SRP_PHAT_EPSILON     1e-9f
+#define SRP_LAG_OVERSAMPLE   4
+#define SRP_MIN_FREQ_HZ      100.0f
+#define SRP_MAX_PAIRS        (AUDIO_DOA_MAX_MICS * (AUDIO_DOA_MAX_MICS - 1) / 2)
+
+/**
+ * @brief  Steering entry of one microphone pair at one angle
+ *
+ *         `index` and `frac` locate the expected lag inside the pair's oversampled lag
+ *         window. The correlation is interpolated with a cubic through `index - 1` to
+ *         `index + 2`: a linear interpolation is piecewise linear in the lag, so its maximum
+ *         always sits on an oversampled lag and the estimate snaps to the angles of that grid.
+ */
+typedef struct {
+    uint16_t index;
+    float    frac;
+} srp_steer_t;
+
+struct audio_doa_srp {
+    int          fft_size;
+    int          mic_num;
+    int          pair_num;
+    uint8_t      pair[SRP_MAX_PAIRS][2];
+    int          lag_center;                 /*!< Oversampled index of lag 0 */
+    int          lag_window;
+    int          bin_lo;
+    int          bin_hi;
+    int          angle_num;
+    int          coarse_ratio;
+    float        fine_step_deg;
+    float       *twiddle;                    /*!< fft_size / 2 complex e^{-j2πk/N} */
+    uint16_t    *bitrev;                     /*!< Bit reversal permutation */
+    float       *work;                       /*!< fft_size complex scratch */
+    float       *lag_phasor;                 /*!< Start and step phasor of each non-negative lag */
+    float       *spectrum[AUDIO_DOA_MAX_MICS]; /*!< fft_size / 2 + 1 complex bins per microphone */
+    float       *gcc[SRP_MAX_PAIRS];         /*!< Oversampled lag window of the GCC-PHAT of each pair */
+    srp_steer_t *steer;                      /*!< angle_num x pair_num steering table */
+};
+
+static void srp_fft(const audio_doa_srp_t *srp, float *buf)
+{
+    int n = srp->fft_size;
+    for (int i = 0; i < n; i++) {
+        int j = srp->bitrev[i];
+        if (j > i) {
+            float re = buf[2 * i];
+            float im = buf[2 * i + 1];
+            buf[2 * i] = buf[2 * j];
+            buf[2 * i + 1] = buf[2 * j + 1];
+            buf[2 * j] = re;
+            buf[2 * j + 1] = im;
+        }
+    }
+    for (int len = 2; len <= n; len <<= 1) {
+        int half = len >> 1;
+        int step = n / len;
+        for (int i = 0; i < n; i += len) {
+            for (int k = 0; k < half; k++) {
+                float wr = srp->twiddle[2 * k * step];
+                float wi = srp->twiddle[2 * k * step + 1];
+                float *a = &buf[2 * (i + k)];
+                float *b = &buf[2 * (i + k + half)];
+                float tr = b[0] * wr - b[1] * wi;
+                float ti = b[0] * wi + b[1] * wr;
+                b[0] = a[0] - tr;
+                b[1] = a[1] - ti;
+                a[0] += tr;
+                a[1] += ti;
+            }
+        }
+    }
+}
+
+/**
+ * @brief  Transform two real channels with one complex FFT and split the result
+ */
+static void srp_spectrum_pair(audio_doa_srp_t *srp, int16_t *a, int16_t *b, float *spec_a, float *spec_b)
+{
+    int n = srp->fft_size;
+    float *z = srp->work;
+    for (int i = 0; i < n; i++) {
+        z[2 * i] = (float)a[i];
+        z[2 * i + 1] = b ? (float)b[i] : 0.0f;
+    }
+    srp_fft(srp, z);
+    for (int k = 0; k <= n / 2; k++) {
+        int nk = (n - k) & (n - 1);
+        float zr = z[2 * k], zi = z[2 * k + 1];
+        float cr = z[2 * nk], ci = -z[2 * nk + 1];
+        spec_a[2 * k] = 0.5f * (zr + cr);
+        spec_a[2 * k + 1] = 0.5f * (zi + ci);
+        if (spec_b) {
+            spec_b[2 * k] = 0.5f * (zi - ci);
+            spec_b[2 * k + 1] = -0.5f * (zr - cr);
+        }
+    }
+}
+
+/**
+ * @brief  PHAT weighted cross spectrum X_i conj(X_j) / |X_i conj(X_j)| of one bin
+ */
+static inline void srp_phat_bin(const float *xi, const float *xj, float *re, float *im)
+{
+    float r = xi[0] * xj[0] + xi[1] * xj[1];
+    float m = xi[1] * xj[0] - xi[0] * xj[1];
+    float inv = 1.0f / (sqrtf(r * r + m * m) + SRP_PHAT_EPSILON);
+    *re = r * inv;
+    *im = m * inv;
+}
+
+/**
+ * @brief  GCC-PHAT of one pair on the oversampled lag grid
+ *
+ *         The lag window is tiny compared with the frame, so the correlation is
+ *         evaluated directly from the cross spectrum at each fractional lag instead
+ *         of through a zero-padded inverse FFT. r(t) and r(-t) share one phasor
+ *         recurrence per lag.
+ */
+static void srp_gcc_pair(audio_doa_srp_t *srp, int p)
+{
+    float *g = srp->work;
+    const float *xi = srp->spectrum[srp->pair[p][0]];
+    const float *xj = srp->spectrum[srp->pair[p][1]];
+    int bins = srp->bin_hi - srp->bin_lo + 1;
+    for (int b = 0; b < bins; b++) {
+        srp_phat_bin(&xi[2 * (srp->bin_lo + b)], &xj[2 * (srp->bin_lo + b)], &g[2 * b], &g[2 * b + 1]);
+    }
+
+    int center = srp->lag_center;
+    float *out = srp->gcc[p];
+    for (int q = 0; q <= center; q++) {
+        const float *ph = &srp->lag_phasor[4 * q];
+        float wr = ph[0], wi = ph[1];
+        float sr = ph[2], si = ph[3];
+        float acc_cos = 0.0f, acc_sin = 0.0f;
+        for (int b = 0; b < bins; b++) {
+            acc_cos += g[2 * b] * wr;
+            acc_sin += g[2 * b + 1] * wi;
+            float t = wr * sr - wi * si;
+            wi = wr * si + wi * sr;
+            wr = t;
+        }
+        out[center + q] = acc_cos - acc_sin;
+        out[center - q] = acc_cos + acc_sin;
+    }
+}
+
+static inline float srp_power(const audio_doa_srp_t *srp, int angle_index)
+{
+    const srp_steer_t *st = &srp->steer[angle_index * srp->pair_num];
+    float power = 0.0f;
+    for (int p = 0; p < srp->pair_num; p++) {
+        // Catmull-Rom through g[-1] .. g[2]
+        const float *g = &srp->gcc[p][st[p].index];
+        float t = st[p].frac;
+        float c1 = 0.5f * (g[1] - g[-1]);
+        float c2 = g[-1] - 2.5f * g[0] + 2.0f * g[1] - 0.5f * g[2];
+        float c3 = 0.5f * (g[2] - g[-1]) + 1.5f * (g[0] - g[1]);
+        power += g[0] + t * (c1 + t * (c2 + t * c3));
+    }
+    return power;
+}
+
+float audio_doa_srp_process(audio_doa_srp_t *srp, int16_t *const *mic_data)
+{
+    for (int m = 0; m < srp->mic_num; m += 2) {
+        bool has_b = (m + 1) < srp->mic_num;
+        srp_spectrum_pair(srp, mic_data[m], has_b ? mic_data[m + 1] : NULL,
+                          srp->spectrum[m], has_b ? srp->spectrum[m + 1] : NULL);
+    }
+    for (int p = 0; p < srp->pair_num; p++) {
+        srp_gcc_pair(srp, p);
+    }
+
+    // Coarse grid, then refine around the best coarse angle
+    int best = 0;
+    float best_power = -INFINITY;
+    for (int a = 0; a < srp->angle_num; a += srp->coarse_ratio) {
+        float power = srp_power(srp, a);
+        if (power > best_power) {
+            best_power = power;
+            best = a;
+        }
+    }
+    int lo = best - srp->coarse_ratio + 1;
+    int hi = best + srp->coarse_ratio - 1;
+    lo = lo < 0 ? 0 : lo;
+    hi = hi >= srp->angle_num ? srp->angle_num - 1 : hi;
+    for (int a = lo; a <= hi; a++) {
+        float power = srp_power(srp, a);
+        if (power > best_power) {
+            best_power = power;
+            best = a;
+        }
+    }
+    // Parabolic peak over the neighbouring fine angles for a sub-step estimate
+    float offset = 0.0f;
+    if (best > 0 && best < srp->angle_num - 1) {
+        float pm = srp_power(srp, best - 1);
+        float pp = srp_power(srp, best + 1);
+        float denom = pm - 2.0f * best_power + pp;
+        if (denom < 0.0f) {
+            offset = 0.5f * (pm - pp) / denom;
+            offset = offset > 0.5f ? 0.5f : offset < -0.5f ? -0.5f : offset;
+        }
+    }
+    return (best + offset) * srp->fine_step_deg;
+}
+
+static void srp_build_tables(audio_doa_srp_t *srp, const audio_doa_srp_cfg_t *cfg)
+{
+    int n = srp->fft_size;
+    int bits = 0;
+    while ((1 << bits) < n) {
+        bits++;
+    }
+    for (int i = 0; i < n; i++) {
+        int r = 0;
+        for (int b = 0; b < bits; b++) {
+            r |= ((i >> b) & 1) << (bits - 1 - b);
+        }
+        srp->bitrev[i] = (uint16_t)r;
+    }
+    for (int k = 0; k < n / 2; k++) {
+        srp->twiddle[2 * k] = cosf(2.0f * (float)M_PI * k / n);
+        srp->twiddle[2 * k + 1] = -sinf(2.0f * (float)M_PI * k / n);
+    }
+
+    for (int q = 0; q <= srp->lag_center; q++) {
+        float tau = (float)q / SRP_LAG_OVERSAMPLE;
+        float start = 2.0f * (float)M_PI * srp->bin_lo * tau / n;
+        float step = 2.0f * (float)M_PI * tau / n;
+        srp->lag_phasor[4 * q] = cosf(start);
+        srp->lag_phasor[4 * q + 1] = sinf(start);
+        srp->lag_phasor[4 * q + 2] = cosf(step);
+        srp->lag_phasor[4 * q + 3] = sinf(step);
+    }
+
+    // Expected lag of pair (i, j) is (p_j - p_i) . u(theta) * fs / c with u = (-cos, sin)
+    for (int a = 0; a < srp->angle_num; a++) {
+        float theta = a * srp->fine_step_deg * (float)M_PI / 180.0f;
+        float ux = -cosf(theta);
+        float uy = sinf(theta);
+        for (int p = 0; p < srp->pair_num; p++) {
+            const audio_doa_mic_pos_t *pi = &cfg->mic_pos[srp->pair[p][0]];
+            const audio_doa_mic_pos_t *pj = &cfg->mic_pos[srp->pair[p][1]];
+            float lag = ((pj->x - pi->x) * ux + (pj->y - pi->y) * uy) * cfg->sample_rate / SRP_SPEED_OF_SOUND;
+            float pos = lag * SRP_LAG_OVERSAMPLE + srp->lag_center;
+            int index = (int)floorf(pos);
+            if (index < 1) {
+                index = 1;
+            } else if (index > srp->lag_window - 3) {
+                index = srp->lag_window - 3;
+            }
+            srp->steer[a * srp->pair_num + p].index = (uint16_t)index;
+            srp->steer[a * srp->pair_num + p].frac = pos - index;
+        }
+    }
+}
+
+audio_doa_srp_t *audio_doa_srp_create(const audio_doa_srp_cfg_t *cfg)
+{
+    if (cfg == NULL || cfg->mic_pos == NULL || cfg->mic_num < 2 || cfg->mic_num > AUDIO_DOA_MAX_MICS ||
+        cfg->frame_samples < 16 || (cfg->frame_samples & (cfg->frame_samples - 1)) != 0 || cfg->sample_rate <= 0) {
+        ESP_LOGE(TAG, "Invalid SRP-PHAT configuration");
+        return NULL;
+    }
+    audio_doa_srp_t *srp = (audio_doa_srp_t *)calloc(1, sizeof(audio_doa_srp_t));
+    if (srp == NULL) {
+        return NULL;
+    }
+    srp->fft_size = cfg->frame_samples;
+    srp->mic_num = cfg->mic_num;
+    srp->fine_step_deg = cfg->fine_step_deg > 0.0f ? cfg->fine_step_deg : SRP_DEFAULT_FINE;
+    float coarse = cfg->coarse_step_deg > 0.0f ? cfg->coarse_step_deg : SRP_DEFAULT_COARSE;
+    srp->coarse_ratio = (int)(coarse / srp->fine_step_deg + 0.5f);
+    if (srp->coarse_ratio < 1) {
+        srp->coarse_ratio = 1;
+    }
+    srp->angle_num = (int)(SRP_ANGLE_RANGE / srp->fine_step_deg + 0.5f) + 1;
+
+    float max_dist = 0.0f;
+    for (int i = 0; i < cfg->mic_num; i++) {
+        for (int j = i + 1; j < cfg->mic_num; j++) {
+            srp->pair[srp->pair_num][0] = (uint8_t)i;
+            srp->pair[srp->pair_num][1] = (uint8_t)j;
+            srp->pair_num++;
+            float dx = cfg->mic_pos[j].x - cfg->mic_pos[i].x;
+            float dy = cfg->mic_pos[j].y - cfg->mic_pos[i].y;
+            float dist = sqrtf(dx * dx + dy * dy);
+            max_dist = dist > max_dist ? dist : max_dist;
+        }
+    }
+    int max_lag = (int)ceilf(max_dist * cfg->sample_rate / SRP_SPEED_OF_SOUND) + 1;
+    if (2 * max_lag >= srp->fft_size) {
+        ESP_LOGE(TAG, "Array aperture %.3f m too large for %d-sample frames", max_dist, srp->fft_size);
+        free(srp);
+        return NULL;
+    }
+    srp->lag_center = max_lag * SRP_LAG_OVERSAMPLE;
+    srp->lag_window = 2 * srp->lag_center + 1;
+    srp->bin_lo = (int)ceilf(SRP_MIN_FREQ_HZ * srp->fft_size / cfg->sample_rate);
+    srp->bin_lo = srp->bin_lo < 1 ? 1 : srp->bin_lo;
+    srp->bin_hi = srp->fft_size / 2 - 1;
+    if (cfg->max_freq_hz > 0.0f && cfg->max_freq_hz * srp->fft_size / cfg->sample_rate < srp->bin_hi) {
+        srp->bin_hi = (int)(cfg->max_freq_hz * srp->fft_size / cfg->sample_rate);
+    }
+    if (srp->bin_hi < srp->bin_lo) {
+        ESP_LOGE(TAG, "Empty analysis band");
+        free(srp);
+        return NULL;
+    }
+
+    bool ok = true;
+    srp->twiddle = (float *)calloc(srp->fft_size, sizeof(float));
+    srp->bitrev = (uint16_t *)calloc(srp->fft_size, sizeof(uint16_t));
+    srp->work = (float *)calloc(2 * srp->fft_size, sizeof(float));
+    srp->lag_phasor = (float *)calloc(4 * (srp->lag_center + 1), sizeof(float));
+    srp->steer = (srp_steer_t *)calloc(srp->angle_num * srp->pair_num, sizeof(srp_steer_t));
+    ok = srp->twiddle && srp->bitrev && srp->work && srp->lag_phasor && srp->steer;
+    for (int m = 0; ok && m < srp->mic_num; m++) {
+        srp->spectrum[m] = (float *)calloc(2 * (srp->fft_size / 2 + 1), sizeof(float));
+        ok = srp->spectrum[m] != NULL;
+    }
+    for (int p = 0; ok && p < srp->pair_num; p++) {
+        srp->gcc[p] = (float *)calloc(srp->lag_window, sizeof(float));
+        ok = srp->gcc[p] != NULL;
+    }
+    if (!ok) {
+        audio_doa_srp_destroy(srp);
+        return NULL;
+    }
+    srp_build_tables(srp, cfg);
+    ESP_LOGI(TAG, "SRP-PHAT: %d mics, %d pairs, max lag %d, %d angles (coarse x%d)",
+             srp->mic_num, srp->pair_num, max_lag, srp->angle_num, srp->coarse_ratio);
+    return srp;
+}
+
+void audio_doa_srp_destroy(audio_doa_srp_t *srp)
+{
+    if (srp == NULL) {
+        return;
+    }
+    for (int m = 0; m < AUDIO_DOA_MAX_MICS; m++) {
+        free(srp->spectrum[m]);
+    }
+    for (int p = 0; p < SRP_MAX_PAIRS; p++) {
+        free(srp->gcc[p]);
+    }
+    free(srp->steer);
+    free(srp->lag_phasor);
+    free(srp->work);
+    free(srp->bitrev);
+    free(srp->twiddle);
+    free(srp);
+}
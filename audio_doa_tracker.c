@@ -8,15 +8,26 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <math.h>
+#include "sdkconfig.h"
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
 #include "audio_doa_tracker.h"
 
 static const char *TAG = "DOA_TRACKER";
 
-#define DOA_TRACKER_BUFFER_SIZE 6
+/* Window length is a compile-time constant so the per-feed loops over it unroll */
+#ifndef AUDIO_DOA_TRACKER_WINDOW
+#ifdef CONFIG_AUDIO_DOA_TRACKER_WINDOW
+#define AUDIO_DOA_TRACKER_WINDOW CONFIG_AUDIO_DOA_TRACKER_WINDOW
+#else
+#define AUDIO_DOA_TRACKER_WINDOW 6
+#endif  /* CONFIG_AUDIO_DOA_TRACKER_WINDOW */
+#endif  /* AUDIO_DOA_TRACKER_WINDOW */
+#define DOA_TRACKER_BUFFER_SIZE AUDIO_DOA_TRACKER_WINDOW
 #define RECENT_WEIGHT_FACTOR 3.0f
 #define REASONABLE_CHANGE_THRESHOLD 40.0f
 #define SILENT_ANGLE 90.0f
@@ -29,6 +40,8 @@ static const char *TAG = "DOA_TRACKER";
 #define MAJOR_ANGLE_CHANGE_THRESHOLD 30.0f
 #define CONTINUOUS_90_DURATION_MS 1000
 #define BUFFER_90_RATIO_THRESHOLD (2.0f / 3.0f)  // 2/3 of buffer must be near 90
+#define WARM_START_SAMPLES 2  // Samples needed for the first output when they agree with the prior
+#define VELOCITY_MIN_SAMPLES 3  // Fewer entries give no usable slope
 
 /**
  * @brief  DOA tracker context structure
@@ -38,6 +51,7 @@ typedef struct {
     float                                buffer[DOA_TRACKER_BUFFER_SIZE];
     float                                original_buffer[DOA_TRACKER_BUFFER_SIZE];
     bool                                 valid_mask[DOA_TRACKER_BUFFER_SIZE];
+    uint32_t                             sample_ms[DOA_TRACKER_BUFFER_SIZE];  /*!< Audio time of each entry */
     int                                  write_index;
     int                                  valid_count;
     bool                                 is_front_facing_mode;
@@ -47,11 +61,19 @@ typedef struct {
     bool                                 has_last_valid_angle;
     float                                last_output_angle;
     bool                                 has_output_angle;
-    TickType_t                           first_near_90_tick;
+    uint32_t                             first_near_90_ms;
     bool                                 has_near_90_start;
     uint32_t                             output_interval_ms;
-    TickType_t                           last_output_tick;
+    uint32_t                             last_output_ms;
     float                                min_angle_change_threshold; /*!< Minimum angle change to trigger output */
+    uint32_t                             max_sample_age_ms;   /*!< Entries older than this are evicted (0 = never) */
+    uint32_t                             silence_timeout_ms;  /*!< Feed gap that resets the state (0 = never) */
+    uint32_t                             last_feed_ms;        /*!< Audio time of the last feed, the tracker's clock */
+    bool                                 has_last_feed;
+    audio_doa_tracker_prior_t            prior;  /*!< Seeds the state on enable */
+    bool                                 warm;   /*!< Seeded from the prior, no output yet */
+    audio_doa_tracker_stats_t            stats;
+    SemaphoreHandle_t                    lock;   /*!< Feeds run in the DOA task, the prior and enable come from the application */
     audio_doa_tracker_result_callback_t  result_callback;
     void                                *ctx;
 } audio_doa_tracker_ctx_t;
@@ -104,7 +126,7 @@ static bool buffer_mostly_90(audio_doa_tracker_ctx_t *ctx)
 static void reset_90_tracking(audio_doa_tracker_ctx_t *ctx)
 {
     ctx->has_near_90_start = false;
-    ctx->first_near_90_tick = 0;
+    ctx->first_near_90_ms = 0;
 }
 
 /**
@@ -113,7 +135,7 @@ static void reset_90_tracking(audio_doa_tracker_ctx_t *ctx)
 static void start_90_tracking(audio_doa_tracker_ctx_t *ctx)
 {
     if (!ctx->has_near_90_start) {
-        ctx->first_near_90_tick = xTaskGetTickCount();
+        ctx->first_near_90_ms = ctx->last_feed_ms;
         ctx->has_near_90_start = true;
     }
 }
@@ -127,10 +149,7 @@ static bool check_continuous_90_duration(audio_doa_tracker_ctx_t *ctx)
         return false;
     }
     
-    TickType_t current_tick = xTaskGetTickCount();
-    TickType_t duration_ticks = pdMS_TO_TICKS(CONTINUOUS_90_DURATION_MS);
-    
-    if ((current_tick - ctx->first_near_90_tick) >= duration_ticks) {
+    if ((ctx->last_feed_ms - ctx->first_near_90_ms) >= CONTINUOUS_90_DURATION_MS) {
         ctx->is_front_facing_mode = true;
         ESP_LOGI(TAG, "Front-facing speech detected (continuous 90 degrees for %d ms)", CONTINUOUS_90_DURATION_MS);
         return true;
@@ -349,7 +368,7 @@ static float calculate_average_angle(audio_doa_tracker_ctx_t *ctx)
     float min_angle = 180.0f;
     float max_angle = 0.0f;
     
-    int latest_idx = (ctx->write_index - 1 + DOA_TRACKER_BUFFER_SIZE) % DOA_TRACKER_BUFFER_SIZE;
+    int latest_idx = (ctx->write_index == 0) ? DOA_TRACKER_BUFFER_SIZE - 1 : ctx->write_index - 1;
     
     for (int i = 0; i < DOA_TRACKER_BUFFER_SIZE; i++) {
         if (ctx->valid_mask[i]) {
@@ -373,7 +392,7 @@ static float calculate_average_angle(audio_doa_tracker_ctx_t *ctx)
 /**
  * @brief  Check if 90-degree output should be allowed
  */
-static bool should_allow_90_output(audio_doa_tracker_ctx_t *ctx, TickType_t current_tick)
+static bool should_allow_90_output(audio_doa_tracker_ctx_t *ctx, uint32_t now_ms)
 {
     // Check if buffer has mostly real 90-degree values
     int near_90_count = count_near_90_in_buffer(ctx);
@@ -391,7 +410,7 @@ static bool should_allow_90_output(audio_doa_tracker_ctx_t *ctx, TickType_t curr
     
     // Check continuous duration
     if (!ctx->has_near_90_start ||
-        (current_tick - ctx->first_near_90_tick) < pdMS_TO_TICKS(CONTINUOUS_90_DURATION_MS)) {
+        (now_ms - ctx->first_near_90_ms) < CONTINUOUS_90_DURATION_MS) {
         ESP_LOGD(TAG, "Average is 90 but not continuous %d ms", CONTINUOUS_90_DURATION_MS);
         return false;
     }
@@ -414,10 +433,62 @@ static void reset_tracker_state(audio_doa_tracker_ctx_t *ctx)
     ctx->last_output_angle = 0.0f;
     ctx->has_output_angle = false;
     reset_90_tracking(ctx);
-    ctx->last_output_tick = 0;
+    ctx->last_output_ms = 0;
+    ctx->warm = false;
     memset(ctx->buffer, 0, sizeof(ctx->buffer));
     memset(ctx->original_buffer, 0, sizeof(ctx->original_buffer));
     memset(ctx->valid_mask, 0, sizeof(ctx->valid_mask));
+    memset(ctx->sample_ms, 0, sizeof(ctx->sample_ms));
+}
+
+/**
+ * @brief  Seed a freshly reset state from the prior
+ */
+static void apply_prior(audio_doa_tracker_ctx_t *ctx)
+{
+    if (!ctx->prior.valid) {
+        return;
+    }
+    ctx->last_output_angle = ctx->prior.angle;
+    if (ctx->prior.front_facing) {
+        ctx->is_front_facing_mode = true;
+        ctx->initial_samples_count = INITIAL_SAMPLES_TO_CHECK;
+    }
+    ctx->warm = true;
+}
+
+/**
+ * @brief  The current stable direction, or the prior if nothing has been output since
+ */
+static void current_prior(const audio_doa_tracker_ctx_t *ctx, audio_doa_tracker_prior_t *prior)
+{
+    *prior = ctx->prior;
+    if (ctx->has_output_angle) {
+        prior->valid = true;
+        prior->angle = ctx->last_output_angle;
+        prior->front_facing = ctx->is_front_facing_mode;
+    }
+}
+
+/**
+ * @brief  Keep the current stable direction as the prior for the next enable
+ */
+static void capture_prior(audio_doa_tracker_ctx_t *ctx)
+{
+    current_prior(ctx, &ctx->prior);
+}
+
+/**
+ * @brief  Drop entries measured more than max_sample_age_ms of audio ago
+ */
+static void evict_old_samples(audio_doa_tracker_ctx_t *ctx, uint32_t now_ms)
+{
+    for (int i = 0; i < DOA_TRACKER_BUFFER_SIZE; i++) {
+        if (ctx->valid_mask[i] && (now_ms - ctx->sample_ms[i]) > ctx->max_sample_age_ms) {
+            ctx->valid_mask[i] = false;
+            ctx->valid_count--;
+        }
+    }
 }
 
 esp_err_t audio_doa_tracker_init(audio_doa_tracker_cfg_t *cfg, audio_doa_tracker_handle_t *out_handle)
@@ -436,8 +507,16 @@ esp_err_t audio_doa_tracker_init(audio_doa_tracker_cfg_t *cfg, audio_doa_tracker
     ctx->enabled = false;
     ctx->output_interval_ms = (cfg->output_interval_ms > 0) ? cfg->output_interval_ms : 0;
     ctx->min_angle_change_threshold = (cfg->min_angle_change_threshold > 0.0f) ? cfg->min_angle_change_threshold : 15.0f;
+    ctx->max_sample_age_ms = cfg->max_sample_age_ms;
+    ctx->silence_timeout_ms = cfg->silence_timeout_ms;
     ctx->result_callback = cfg->result_callback;
     ctx->ctx = cfg->ctx;
+    ctx->lock = xSemaphoreCreateMutex();
+    if (ctx->lock == NULL) {
+        ESP_LOGE(TAG, "Failed to create lock");
+        free(ctx);
+        return ESP_ERR_NO_MEM;
+    }
     reset_tracker_state(ctx);
     
     *out_handle = (audio_doa_tracker_handle_t)ctx;
@@ -447,21 +526,43 @@ esp_err_t audio_doa_tracker_init(audio_doa_tracker_cfg_t *cfg, audio_doa_tracker
 
 esp_err_t audio_doa_tracker_feed(audio_doa_tracker_handle_t handle, float angle)
 {
-    if (handle == NULL) {
-        return ESP_ERR_INVALID_ARG;
+    return audio_doa_tracker_feed_at(handle, angle, (uint32_t)(xTaskGetTickCount() * portTICK_PERIOD_MS));
+}
+
+/**
+ * @brief  Add one angle to the state, called with the lock held
+ *
+ * @return  true when `output` holds a new result for the callback
+ */
+static bool tracker_update(audio_doa_tracker_ctx_t *ctx, float angle, uint32_t audio_ms, float *output)
+{
+    if (!ctx->enabled) {
+        return false;
     }
     
-    audio_doa_tracker_ctx_t *ctx = (audio_doa_tracker_handle_t)handle;
-    if (!ctx->enabled) {
-        return ESP_OK;
+    // Nothing is fed while VAD is off, so a long gap means the previous utterance ended:
+    // start over from "unknown" (plus the prior) instead of averaging with its angles.
+    // Gaps are measured in audio time, a burst of queued frames is not a silence
+    uint32_t silence_ms = audio_ms - ctx->last_feed_ms;
+    if (ctx->silence_timeout_ms > 0 && ctx->has_last_feed && silence_ms >= ctx->silence_timeout_ms) {
+        capture_prior(ctx);
+        reset_tracker_state(ctx);
+        apply_prior(ctx);
+        ctx->stats.resets++;
+        ESP_LOGD(TAG, "Silence for %" PRIu32 " ms, state reset", silence_ms);
+    } else if (ctx->max_sample_age_ms > 0) {
+        evict_old_samples(ctx, audio_ms);
     }
+    ctx->last_feed_ms = audio_ms;
+    ctx->has_last_feed = true;
     
     // Validate angle before quantization
     float current_avg = calculate_average_angle(ctx);
     bool has_valid_samples = (ctx->valid_count > 0);
     
     if (!is_angle_valid(angle, ctx, current_avg, has_valid_samples)) {
-        return ESP_OK;  // Invalid angle, skip
+        ctx->stats.rejected++;
+        return false;  // Invalid angle, skip
     }
     
     // Quantize angle
@@ -471,6 +572,7 @@ esp_err_t audio_doa_tracker_feed(audio_doa_tracker_handle_t handle, float angle)
     if (has_valid_samples && ctx->valid_count >= DOA_TRACKER_BUFFER_SIZE) {
         if (fabsf(angle - current_avg) > MAJOR_ANGLE_CHANGE_THRESHOLD) {
             reset_tracker_state(ctx);
+            ctx->stats.resets++;
             ESP_LOGD(TAG, "Major angle change detected, resetting buffer");
         }
     }
@@ -483,7 +585,8 @@ esp_err_t audio_doa_tracker_feed(audio_doa_tracker_handle_t handle, float angle)
     ctx->buffer[ctx->write_index] = quantized_angle;
     ctx->original_buffer[ctx->write_index] = angle;
     ctx->valid_mask[ctx->write_index] = true;
-    ctx->write_index = (ctx->write_index + 1) % DOA_TRACKER_BUFFER_SIZE;
+    ctx->sample_ms[ctx->write_index] = audio_ms;
+    ctx->write_index = (ctx->write_index + 1 == DOA_TRACKER_BUFFER_SIZE) ? 0 : ctx->write_index + 1;
     
     ctx->last_valid_angle = quantized_angle;
     ctx->has_last_valid_angle = true;
@@ -491,11 +594,25 @@ esp_err_t audio_doa_tracker_feed(audio_doa_tracker_handle_t handle, float angle)
     check_initial_samples(ctx);
     
     // Output logic
-    TickType_t current_tick = xTaskGetTickCount();
     bool should_output = false;
+    bool output_due = false;  // An output was considered, for the held counter
     float avg_angle = 0.0f;
     
-    if (!ctx->has_output_angle) {
+    if (!ctx->has_output_angle && ctx->warm) {
+        // Warm start: a couple of samples agreeing with the prior are enough
+        if (ctx->valid_count >= WARM_START_SAMPLES) {
+            avg_angle = calculate_average_angle(ctx);
+            if (fabsf(avg_angle - ctx->prior.angle) > REASONABLE_CHANGE_THRESHOLD) {
+                ctx->warm = false;  // Talker moved, fall back to a full buffer
+                ESP_LOGD(TAG, "Warm start rejected (prior %.1f, now %.1f)", ctx->prior.angle, avg_angle);
+            } else if (fabsf(avg_angle - SILENT_ANGLE) < 5.0f) {
+                output_due = true;
+                should_output = should_allow_90_output(ctx, audio_ms);
+            } else {
+                should_output = true;
+            }
+        }
+    } else if (!ctx->has_output_angle) {
         // First output: wait for buffer to fill
         if (ctx->valid_count >= DOA_TRACKER_BUFFER_SIZE) {
             avg_angle = calculate_first_output_angle(ctx);
@@ -506,12 +623,13 @@ esp_err_t audio_doa_tracker_feed(audio_doa_tracker_handle_t handle, float angle)
         if (ctx->valid_count >= DOA_TRACKER_BUFFER_SIZE) {
             // Check timing
             if (ctx->output_interval_ms == 0 ||
-                (current_tick - ctx->last_output_tick) >= pdMS_TO_TICKS(ctx->output_interval_ms)) {
+                (audio_ms - ctx->last_output_ms) >= ctx->output_interval_ms) {
                 avg_angle = calculate_average_angle(ctx);
+                output_due = true;
                 
                 // Special check for 90-degree output
                 if (fabsf(avg_angle - SILENT_ANGLE) < 5.0f) {
-                    should_output = should_allow_90_output(ctx, current_tick);
+                    should_output = should_allow_90_output(ctx, audio_ms);
                 } else {
                     should_output = true;
                 }
@@ -538,16 +656,35 @@ esp_err_t audio_doa_tracker_feed(audio_doa_tracker_handle_t handle, float angle)
         }
     }
     
+    if (output_due && !should_output) {
+        ctx->stats.held++;
+    }
     if (should_output) {
         ctx->last_output_angle = avg_angle;
         ctx->has_output_angle = true;
-        ctx->last_output_tick = current_tick;
-        
-        if (ctx->result_callback) {
-            ctx->result_callback(avg_angle, ctx->ctx);
-        }
+        ctx->last_output_ms = audio_ms;
+        ctx->stats.outputs++;
+        *output = avg_angle;
     }
     
+    return should_output;
+}
+
+esp_err_t audio_doa_tracker_feed_at(audio_doa_tracker_handle_t handle, float angle, uint32_t audio_ms)
+{
+    if (handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    audio_doa_tracker_ctx_t *ctx = (audio_doa_tracker_handle_t)handle;
+    float output = 0.0f;
+    xSemaphoreTake(ctx->lock, portMAX_DELAY);
+    bool has_output = tracker_update(ctx, angle, audio_ms, &output);
+    xSemaphoreGive(ctx->lock);
+    // Outside the lock, the callback may read the tracker back
+    if (has_output && ctx->result_callback) {
+        ctx->result_callback(output, ctx->ctx);
+    }
     return ESP_OK;
 }
 
@@ -558,25 +695,106 @@ esp_err_t audio_doa_tracker_enable(audio_doa_tracker_handle_t handle, bool enabl
     }
     
     audio_doa_tracker_ctx_t *ctx = (audio_doa_tracker_handle_t)handle;
+    xSemaphoreTake(ctx->lock, portMAX_DELAY);
     ctx->enabled = enable;
-    
+    capture_prior(ctx);
+    ctx->has_last_feed = false;
+    reset_tracker_state(ctx);
     if (enable) {
-        reset_tracker_state(ctx);
-        ESP_LOGI(TAG, "DOA tracker enabled");
-    } else {
-        reset_tracker_state(ctx);
-        ESP_LOGI(TAG, "DOA tracker disabled");
+        apply_prior(ctx);
     }
+    xSemaphoreGive(ctx->lock);
+    ESP_LOGI(TAG, "DOA tracker %s", enable ? "enabled" : "disabled");
     
     return ESP_OK;
 }
 
+esp_err_t audio_doa_tracker_get_prior(audio_doa_tracker_handle_t handle, audio_doa_tracker_prior_t *prior)
+{
+    if (handle == NULL || prior == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    audio_doa_tracker_ctx_t *ctx = (audio_doa_tracker_ctx_t *)handle;
+    xSemaphoreTake(ctx->lock, portMAX_DELAY);
+    current_prior(ctx, prior);
+    xSemaphoreGive(ctx->lock);
+    return ESP_OK;
+}
+
+esp_err_t audio_doa_tracker_set_prior(audio_doa_tracker_handle_t handle, const audio_doa_tracker_prior_t *prior)
+{
+    if (handle == NULL || prior == NULL || (prior->valid && (prior->angle < ANGLE_MIN || prior->angle > ANGLE_MAX))) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    audio_doa_tracker_ctx_t *ctx = (audio_doa_tracker_ctx_t *)handle;
+    xSemaphoreTake(ctx->lock, portMAX_DELAY);
+    ctx->prior = *prior;
+    if (ctx->enabled && !ctx->has_output_angle) {
+        reset_tracker_state(ctx);
+        apply_prior(ctx);
+    }
+    xSemaphoreGive(ctx->lock);
+    return ESP_OK;
+}
+
+esp_err_t audio_doa_tracker_get_stats(audio_doa_tracker_handle_t handle, audio_doa_tracker_stats_t *stats)
+{
+    if (handle == NULL || stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    audio_doa_tracker_ctx_t *ctx = (audio_doa_tracker_ctx_t *)handle;
+    xSemaphoreTake(ctx->lock, portMAX_DELAY);
+    *stats = ctx->stats;
+    xSemaphoreGive(ctx->lock);
+    return ESP_OK;
+}
+
+esp_err_t audio_doa_tracker_get_velocity(audio_doa_tracker_handle_t handle, float *deg_per_s)
+{
+    if (handle == NULL || deg_per_s == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    audio_doa_tracker_ctx_t *ctx = (audio_doa_tracker_ctx_t *)handle;
+    // Least-squares slope of the unquantized angles over their audio times, relative to
+    // the last feed so wrap-around cancels out
+    float sum_t = 0.0f, sum_a = 0.0f, sum_tt = 0.0f, sum_ta = 0.0f;
+    int n = 0;
+    xSemaphoreTake(ctx->lock, portMAX_DELAY);
+    uint32_t ref = ctx->last_feed_ms;
+    for (int i = 0; i < DOA_TRACKER_BUFFER_SIZE; i++) {
+        if (!ctx->valid_mask[i]) {
+            continue;
+        }
+        float t = -(float)(ref - ctx->sample_ms[i]);
+        float a = ctx->original_buffer[i];
+        sum_t += t;
+        sum_a += a;
+        sum_tt += t * t;
+        sum_ta += t * a;
+        n++;
+    }
+    xSemaphoreGive(ctx->lock);
+    float denom = n * sum_tt - sum_t * sum_t;
+    if (n < VELOCITY_MIN_SAMPLES || denom <= 0.0f) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    float deg_per_ms = (n * sum_ta - sum_t * sum_a) / denom;
+    *deg_per_s = fabsf(deg_per_ms) * 1000.0f;
+    return ESP_OK;
+}
+
 esp_err_t audio_doa_tracker_deinit(audio_doa_tracker_handle_t handle)
 {
     if (handle == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    free((audio_doa_tracker_ctx_t *)handle);
+    audio_doa_tracker_ctx_t *ctx = (audio_doa_tracker_ctx_t *)handle;
+    vSemaphoreDelete(ctx->lock);
+    free(ctx);
     return ESP_OK;
 }
@@ -3,6 +3,9 @@
 #include "esp_err.h"
 #include <stdbool.h>
 #include <stdint.h>
+#include "audio_doa_types.h"
+#include "audio_doa_persist.h"
+#include "audio_doa_log.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -10,6 +13,11 @@ extern "C" {
 
 #define AUDIO_DOA_APP_BUFFER_MAX_SIZE_EACH_CHANNEL (1024)
 
+/**
+ * @brief  Size of the warm-start blob written by audio_doa_app_export_state()
+ */
+#define AUDIO_DOA_APP_STATE_SIZE (24)
+
 // Forward declarations for opaque handles
 typedef void *audio_doa_handle_t;
 typedef void *audio_doa_tracker_handle_t;
@@ -19,6 +27,34 @@ typedef void (*audio_doa_monitor_callback_t)(float angle, void *ctx);
 
 typedef struct {
     float                                       distance;
+    bool                                        decimate;  /*!< Run the DOA engine on a 2:1 decimated (0-4 kHz) signal to roughly halve its cost */
+    audio_doa_engine_t                          engine;    /*!< DOA backend, AUDIO_DOA_ENGINE_SRP_PHAT for arrays with more than two mics */
+    int                                         mic_num;   /*!< Number of interleaved microphone channels (0 = 2) */
+    audio_doa_mic_pos_t                         mic_pos[AUDIO_DOA_MAX_MICS];  /*!< SRP-PHAT array geometry, all zero = linear array spaced by distance */
+    audio_doa_gap_policy_t                      gap_policy;  /*!< Handling of frames broken by capture gaps */
+    uint32_t                                    batch_interval_ms;  /*!< Batched low-power mode: process queued frames in one burst every N ms (0 = off) */
+    int                                         batch_frames;  /*!< Batched mode: wake early once this many frames are queued (0 = interval only) */
+    bool                                        shadow;  /*!< Shadow mode: run a second chain and tracker on the same audio, only the primary reaches the callbacks */
+    audio_doa_engine_t                          shadow_engine;  /*!< Shadow chain DOA backend */
+    bool                                        shadow_decimate;  /*!< Shadow chain 2:1 decimation */
+    float                                       gate_rms;  /*!< Gating stage: skip frames below this RMS or 6 dB above the learned noise floor, whichever is higher (0 = no gating stage) */
+    bool                                        disable_smoothing;  /*!< Leave the Gaussian smoothing stage out */
+    bool                                        stage_timing;  /*!< Time each pipeline stage, see audio_doa_app_get_stage_stats() */
+    const audio_doa_stage_t                    *stages;  /*!< Custom stages, each runs at its kind's position (can be NULL) */
+    int                                         stage_num;  /*!< Number of entries in `stages` */
+    uint32_t                                    tracker_max_age_ms;  /*!< Tracker drops angles older than this (0 = 3000 ms) */
+    uint32_t                                    tracker_silence_timeout_ms;  /*!< Tracker restarts from unknown after this long without audio (0 = 1000 ms) */
+    const audio_doa_log_cfg_t                  *angle_log;  /*!< Encode the monitor and result angles into a RAM ring, see audio_doa_app_get_angle_log() (NULL = off) */
+    const audio_doa_persist_t                  *persist;  /*!< Warm-start storage: loaded at create, written by audio_doa_app_save_state() (can be NULL) */
+    uint32_t                                    deadline_us;  /*!< Processing deadline per frame (0 = one frame of audio, 32 ms at 512 samples) */
+    uint32_t                                    deadline_miss_limit;  /*!< Misses within a window that fire `deadline_callback` (0 = 3) */
+    uint32_t                                    deadline_window_frames;  /*!< Frames per deadline window (0 = 32, about one second) */
+    audio_doa_deadline_callback_t               deadline_callback;  /*!< Called from the DOA task when a window reaches `deadline_miss_limit` misses (can be NULL) */
+    void*                                       deadline_callback_ctx;
+    bool                                        adaptive_window;  /*!< Pick the engine's analysis window from the tracked angular velocity: half a frame while the talker moves, two frames while still. Needs CONFIG_AUDIO_DOA_TRACKER */
+    float                                       window_moving_dps;  /*!< Angular velocity at or above which the short window is used (0 = 30 deg/s) */
+    float                                       window_still_dps;  /*!< Angular velocity at or below which the long window is used (0 = 10 deg/s) */
+    bool                                        synchronous;  /*!< No DOA task: audio is processed by audio_doa_app_process() in the caller's context, e.g. offline on the host. Not with `shadow` */
     audio_doa_monitor_callback_t                audio_doa_monitor_callback;
     void*                                       audio_doa_monitor_callback_ctx;
     audio_doa_result_callback_t                 audio_doa_result_callback;
@@ -27,15 +63,51 @@ typedef struct {
 
 typedef void *audio_doa_app_handle_t;
 
+/**
+ * @brief  Called once a background creation has finished
+ *
+ * @param[in]  app     The handle returned by audio_doa_app_create_async()
+ * @param[in]  result  ESP_OK when the instance is running, otherwise the creation error
+ *                     (the handle must still be destroyed)
+ * @param[in]  ctx     User context
+ */
+typedef void (*audio_doa_app_ready_callback_t)(audio_doa_app_handle_t app, esp_err_t result, void *ctx);
+
 /**
  * @brief  Create a new audio DOA app instance
- * 
- * @param app 
- * @param config 
- * @return esp_err_t 
+ *
+ *         On failure everything created so far is released and `*app` is left untouched.
+ *
+ * @param[out]  app     Pointer to the audio DOA app handle, written on success only
+ * @param[in]   config  Configuration
+ * @return
+ *       - ESP_OK               Success
+ *       - ESP_ERR_INVALID_ARG  Invalid arguments
+ *       - ESP_ERR_NO_MEM       Memory allocation failed
+ *       - Other                Error code of the DOA instance or tracker setup
  */
 esp_err_t audio_doa_app_create(audio_doa_app_handle_t *app, audio_doa_app_config_t *config);
 
+/**
+ * @brief  Create a new audio DOA app instance in the background
+ *
+ *         Returns as soon as the handle exists; engine setup, buffer allocation and task start
+ *         run in a separate task, after which `ready_callback` is called. Until then audio
+ *         writes are dropped and start/stop/stats calls return ESP_ERR_INVALID_STATE.
+ *         Destroying the handle waits for the background creation to finish.
+ *
+ * @param[out]  app             Pointer to the audio DOA app handle
+ * @param[in]   config          Configuration, copied (`stages` must stay valid until ready)
+ * @param[in]   ready_callback  Called from the background task when creation finished (can be NULL)
+ * @param[in]   ctx             User context for `ready_callback`
+ * @return
+ *       - ESP_OK               Background creation started
+ *       - ESP_ERR_INVALID_ARG  Invalid arguments
+ *       - ESP_ERR_NO_MEM       Failed to allocate the handle or start the task
+ */
+esp_err_t audio_doa_app_create_async(audio_doa_app_handle_t *app, audio_doa_app_config_t *config,
+                                     audio_doa_app_ready_callback_t ready_callback, void *ctx);
+
 /**
  * @brief  Start the audio DOA app
  * 
@@ -70,6 +142,143 @@ esp_err_t audio_doa_app_destroy(audio_doa_app_handle_t app);
  */
 esp_err_t audio_doa_app_data_write(audio_doa_app_handle_t app, uint8_t *data, int bytes_size);
 
+/**
+ * @brief  Write audio data tagged with the index of its first sample
+ *
+ *         Gaps and overlaps against the previous write are detected, the broken
+ *         frame is discarded or zero-filled according to `gap_policy` and the stream
+ *         resynchronizes. Writes skipped while VAD is off therefore show up as a gap
+ *         instead of being joined to the next utterance.
+ * 
+ * @param app 
+ * @param data          Interleaved 16-bit samples, a whole number of sample frames
+ * @param bytes_size 
+ * @param sample_index  Index of the first per-channel sample in `data`
+ * @return esp_err_t
+ */
+esp_err_t audio_doa_app_data_write_with_seq(audio_doa_app_handle_t app, uint8_t *data, int bytes_size, uint64_t sample_index);
+
+/**
+ * @brief  Process whole frames of audio in the caller's context
+ *
+ *         For instances created with `synchronous`. The samples are read in place and the
+ *         monitor and result callbacks are called from this function before it returns.
+ *         The VAD flag is not checked, pass only the audio to be analysed.
+ *
+ * @param[in]  app     Audio DOA app handle
+ * @param[in]  data    Interleaved 16-bit samples, `frames` x CONFIG_AUDIO_DOA_FRAME_SAMPLES sample frames
+ * @param[in]  frames  Number of frames in `data`
+ * @return
+ *       - ESP_OK                 Success
+ *       - ESP_ERR_INVALID_ARG    Invalid arguments
+ *       - ESP_ERR_INVALID_STATE  Not created with `synchronous`, stopped, or not ready
+ */
+esp_err_t audio_doa_app_process(audio_doa_app_handle_t app, const int16_t *data, int frames);
+
+/**
+ * @brief  Get the runtime counters of the audio DOA app
+ * 
+ * @param app 
+ * @param stats 
+ * @return esp_err_t
+ */
+esp_err_t audio_doa_app_get_stats(audio_doa_app_handle_t app, audio_doa_stats_t *stats);
+
+/**
+ * @brief  Get the per-stage timing of the processing pipeline
+ * 
+ * @param app 
+ * @param stats      Output array, AUDIO_DOA_MAX_STAGES entries are always enough
+ * @param max_count  Capacity of stats
+ * @param count      Number of entries written
+ * @return esp_err_t
+ */
+esp_err_t audio_doa_app_get_stage_stats(audio_doa_app_handle_t app, audio_doa_stage_stats_t *stats, int max_count, int *count);
+
+/**
+ * @brief  Export the warm-start state
+ *
+ *         The blob holds the tracker's last stable direction and front-facing mode and the
+ *         gating stage's noise floor, with a magic, version and CRC. Restoring it lets the
+ *         first output after boot come within a couple of frames instead of a full tracker
+ *         buffer.
+ *
+ * @param[in]      app   Audio DOA app handle
+ * @param[out]     blob  Destination buffer
+ * @param[in,out]  size  Capacity in (at least AUDIO_DOA_APP_STATE_SIZE), bytes written out
+ * @return
+ *       - ESP_OK                 Success
+ *       - ESP_ERR_INVALID_ARG    Invalid arguments
+ *       - ESP_ERR_INVALID_SIZE   Buffer too small
+ *       - ESP_ERR_INVALID_STATE  A background creation is still running
+ */
+esp_err_t audio_doa_app_export_state(audio_doa_app_handle_t app, void *blob, size_t *size);
+
+/**
+ * @brief  Import a warm-start state exported earlier
+ *
+ * @param[in]  app   Audio DOA app handle
+ * @param[in]  blob  Blob from audio_doa_app_export_state()
+ * @param[in]  size  Blob size in bytes
+ * @return
+ *       - ESP_OK                   Success
+ *       - ESP_ERR_INVALID_ARG      Invalid arguments
+ *       - ESP_ERR_INVALID_SIZE     Wrong blob size
+ *       - ESP_ERR_INVALID_VERSION  Not a DOA state blob or from an incompatible version
+ *       - ESP_ERR_INVALID_CRC      Blob is corrupted
+ *       - ESP_ERR_INVALID_STATE    A background creation is still running
+ */
+esp_err_t audio_doa_app_import_state(audio_doa_app_handle_t app, const void *blob, size_t size);
+
+/**
+ * @brief  Export the warm-start state and store it through the configured `persist` backend
+ *
+ *         Call it now and then (e.g. after each utterance); it is also called by destroy.
+ *
+ * @param[in]  app  Audio DOA app handle
+ * @return
+ *       - ESP_OK                 Success
+ *       - ESP_ERR_INVALID_ARG    Invalid arguments
+ *       - ESP_ERR_INVALID_STATE  No `persist` backend configured, or not ready
+ *       - Others                 Error from the save callback
+ */
+esp_err_t audio_doa_app_save_state(audio_doa_app_handle_t app);
+
+/**
+ * @brief  Measure whether DOA processing fits on this board and clock configuration
+ *
+ *         Creates a temporary instance from `config` and runs a built-in synthetic
+ *         signal through its real pipeline stages, tracker included, for `frames` frames.
+ *         No audio is written and no callback is called; the shadow chain, batching,
+ *         angle log and warm-start storage are left out. Takes about
+ *         `frames` x (frame processing time) plus create and destroy time.
+ *
+ * @param[in]   config  Configuration to measure
+ * @param[in]   frames  Frames to run (0 = 100)
+ * @param[out]  result  Cycles per frame for each stage, peak stack and heap, real-time factor
+ * @return
+ *       - ESP_OK               Success
+ *       - ESP_ERR_INVALID_ARG  Invalid arguments
+ *       - Other                The instance could not be created
+ */
+esp_err_t audio_doa_app_benchmark(const audio_doa_app_config_t *config, uint32_t frames, audio_doa_benchmark_t *result);
+
+/**
+ * @brief  Get the angle log fed with the monitor and result angles
+ *
+ *         Use audio_doa_log_read() to drain sealed blocks for upload and
+ *         audio_doa_log_flush() to seal the open ones first. Timestamps are ms since boot.
+ *
+ * @param[in]   app        Audio DOA app handle
+ * @param[out]  angle_log  Angle log handle, owned by the app
+ * @return
+ *       - ESP_OK                 Success
+ *       - ESP_ERR_INVALID_ARG    Invalid arguments
+ *       - ESP_ERR_INVALID_STATE  `angle_log` was not configured, or not ready
+ *       - ESP_ERR_NOT_SUPPORTED  CONFIG_AUDIO_DOA_ANGLE_LOG is disabled
+ */
+esp_err_t audio_doa_app_get_angle_log(audio_doa_app_handle_t app, audio_doa_log_handle_t *angle_log);
+
 /**
  * @brief  Set the VAD detect flag
  * 
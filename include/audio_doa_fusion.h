@@ -0,0 +1,184 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif  /* __cplusplus */
+
+/**
+ * @brief  Size in bytes of one packed bearing report, see audio_doa_fusion_pack_bearing()
+ */
+#define AUDIO_DOA_FUSION_PACKET_SIZE (12)
+
+/**
+ * @brief  Handle type for the multi-array fusion service
+ */
+typedef void *audio_doa_fusion_handle_t;
+
+/**
+ * @brief  Configuration structure for the fusion service
+ *
+ *         All storage is allocated once at create time from `max_sources` and
+ *         `max_tracks`, each update costs O(sources + tracks).
+ */
+typedef struct {
+    uint8_t   max_sources;        /*!< Maximum number of reporting devices (0 = 4) */
+    uint8_t   max_tracks;         /*!< Maximum number of talker tracks (0 = 4) */
+    uint32_t  sync_window_ms;     /*!< Bearings closer than this in time are fused together (0 = 300) */
+    uint32_t  track_timeout_ms;   /*!< Tracks without an update for this long are dropped (0 = 3000) */
+    float     bearing_sigma_deg;  /*!< Bearing standard deviation of one device (0 = 10) */
+    float     gate_m;             /*!< Association gate between a fix and a track (0 = 1.0) */
+    float     process_noise;      /*!< Talker motion noise in m^2/s (0 = 0.25) */
+} audio_doa_fusion_cfg_t;
+
+/**
+ * @brief  Pose of one device in the room frame
+ *
+ *         `heading_deg` is the room direction (counter-clockwise from +x) the
+ *         device's 90 degree axis points to, its 0 degree side is at heading + 90.
+ */
+typedef struct {
+    float  x;            /*!< Position in meters */
+    float  y;            /*!< Position in meters */
+    float  heading_deg;  /*!< Orientation in degrees */
+} audio_doa_fusion_pose_t;
+
+/**
+ * @brief  Fused talker position
+ */
+typedef struct {
+    uint32_t  id;            /*!< Track identifier, stable while the track lives */
+    float     x;             /*!< Position in meters */
+    float     y;             /*!< Position in meters */
+    float     var_x;         /*!< Position covariance, m^2 */
+    float     var_y;
+    float     cov_xy;
+    uint32_t  timestamp_ms;  /*!< Time of the last fix */
+    uint8_t   source_count;  /*!< Devices that contributed to the last fix */
+} audio_doa_fusion_track_t;
+
+/**
+ * @brief  Create the fusion service
+ *
+ * @param[in]   cfg         Configuration (can be NULL for defaults)
+ * @param[out]  out_handle  Created handle
+ *
+ * @return
+ *       - ESP_OK               Success
+ *       - ESP_ERR_INVALID_ARG  Invalid argument
+ *       - ESP_ERR_NO_MEM       Memory allocation failed
+ */
+esp_err_t audio_doa_fusion_create(const audio_doa_fusion_cfg_t *cfg, audio_doa_fusion_handle_t *out_handle);
+
+/**
+ * @brief  Destroy the fusion service
+ *
+ * @param[in]  handle  Fusion handle
+ *
+ * @return
+ *       - ESP_OK               Success
+ *       - ESP_ERR_INVALID_ARG  Invalid argument
+ */
+esp_err_t audio_doa_fusion_destroy(audio_doa_fusion_handle_t handle);
+
+/**
+ * @brief  Set or update the pose of a device
+ *
+ * @param[in]  handle     Fusion handle
+ * @param[in]  source_id  Device index, 0 to max_sources - 1
+ * @param[in]  pose       Device pose
+ *
+ * @return
+ *       - ESP_OK               Success
+ *       - ESP_ERR_INVALID_ARG  Invalid argument or source_id out of range
+ */
+esp_err_t audio_doa_fusion_set_pose(audio_doa_fusion_handle_t handle, uint8_t source_id, const audio_doa_fusion_pose_t *pose);
+
+/**
+ * @brief  Submit a bearing reported by one device
+ *
+ *         Typically called from the device's audio_doa_app result callback (in process)
+ *         or after receiving a packet from another device. Every submit re-triangulates
+ *         the latest bearings inside the sync window and updates the track table.
+ *
+ *         Transports may reorder reports: a bearing older than the source's current one
+ *         is dropped, and fixes are timed by the newest bearing in the table, so track
+ *         timestamps never move backwards.
+ *
+ * @param[in]  handle        Fusion handle
+ * @param[in]  source_id     Device index
+ * @param[in]  timestamp_ms  Capture time of the bearing on a clock shared by all devices
+ * @param[in]  bearing_deg   Device-local DOA angle (0-180)
+ *
+ * @return
+ *       - ESP_OK                 Success, or a late bearing was dropped
+ *       - ESP_ERR_INVALID_ARG    Invalid argument
+ *       - ESP_ERR_INVALID_STATE  No pose has been set for this source
+ */
+esp_err_t audio_doa_fusion_submit(audio_doa_fusion_handle_t handle, uint8_t source_id, uint32_t timestamp_ms, float bearing_deg);
+
+/**
+ * @brief  Pack a bearing report for a UDP or IPC transport
+ *
+ *         The format is fixed-size little endian: magic, version, source id, pad,
+ *         timestamp_ms (u32), bearing in centi-degrees (u16), pad.
+ *
+ * @param[in]   source_id     Device index
+ * @param[in]   timestamp_ms  Capture time of the bearing
+ * @param[in]   bearing_deg   Device-local DOA angle (0-180)
+ * @param[out]  buf           Output buffer of AUDIO_DOA_FUSION_PACKET_SIZE bytes
+ *
+ * @return
+ *       - ESP_OK               Success
+ *       - ESP_ERR_INVALID_ARG  Invalid argument
+ */
+esp_err_t audio_doa_fusion_pack_bearing(uint8_t source_id, uint32_t timestamp_ms, float bearing_deg, uint8_t *buf);
+
+/**
+ * @brief  Submit a packed bearing report received from a transport
+ *
+ *         Transports only move bytes: a UDP socket task, a local IPC channel or a
+ *         loopback that hands audio_doa_fusion_pack_bearing() output straight back in.
+ *
+ * @param[in]  handle  Fusion handle
+ * @param[in]  buf     Received packet
+ * @param[in]  len     Packet length
+ *
+ * @return
+ *       - ESP_OK                   Success
+ *       - ESP_ERR_INVALID_ARG      Invalid argument
+ *       - ESP_ERR_INVALID_SIZE     Wrong packet length
+ *       - ESP_ERR_INVALID_VERSION  Unknown magic or version
+ *       - ESP_ERR_INVALID_STATE    No pose has been set for this source
+ */
+esp_err_t audio_doa_fusion_submit_packet(audio_doa_fusion_handle_t handle, const uint8_t *buf, size_t len);
+
+/**
+ * @brief  Copy the live talker tracks
+ *
+ * @param[in]   handle     Fusion handle
+ * @param[in]   now_ms     Current time, tracks older than track_timeout_ms are dropped first
+ * @param[out]  tracks     Output array
+ * @param[in]   max_count  Capacity of `tracks`
+ * @param[out]  count      Number of tracks written
+ *
+ * @return
+ *       - ESP_OK               Success
+ *       - ESP_ERR_INVALID_ARG  Invalid argument
+ */
+esp_err_t audio_doa_fusion_get_tracks(audio_doa_fusion_handle_t handle, uint32_t now_ms,
+                                      audio_doa_fusion_track_t *tracks, int max_count, int *count);
+
+#ifdef __cplusplus
+}
+#endif  /* __cplusplus */
@@ -0,0 +1,155 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif  /* __cplusplus */
+
+/**
+ * Block layout (all fields little-endian, every block decodes on its own):
+ *
+ *   offset  size  field
+ *   0       2     magic AUDIO_DOA_LOG_MAGIC
+ *   2       1     version AUDIO_DOA_LOG_VERSION
+ *   3       1     stream (audio_doa_log_stream_t)
+ *   4       2     payload bytes used after the header
+ *   6       2     entry count, the first entry included
+ *   8       4     timestamp of the first entry, ms
+ *   12      2     first angle in quanta (signed)
+ *   14      2     quantization step, 1/100 degree
+ *
+ * Each further entry is an unsigned LEB128 varint of (zigzag(angle delta) << 1 | t),
+ * followed when t is 1 by a varint of the time delta in ms; t is 0 when the time
+ * delta equals the previous one, so a steady frame stream costs one byte per angle.
+ * tools/audio_doa_log_decode.c decodes blocks on the host.
+ */
+#define AUDIO_DOA_LOG_MAGIC        (0x4C44)  /*!< "DL" */
+#define AUDIO_DOA_LOG_VERSION      (1)
+#define AUDIO_DOA_LOG_HEADER_SIZE  (16)
+
+/**
+ * @brief  Angle streams that can be logged
+ */
+typedef enum {
+    AUDIO_DOA_LOG_MONITOR = 0,  /*!< Per-frame angles (monitor callback) */
+    AUDIO_DOA_LOG_RESULT,       /*!< Tracker outputs (result callback) */
+    AUDIO_DOA_LOG_STREAM_MAX,
+} audio_doa_log_stream_t;
+
+/**
+ * @brief  Handle type for the angle log
+ */
+typedef void *audio_doa_log_handle_t;
+
+/**
+ * @brief  Configuration structure for the angle log
+ */
+typedef struct {
+    uint16_t  block_size;       /*!< Bytes per block, header included, 32-4096 (0 = 256) */
+    uint16_t  block_num;        /*!< Sealed blocks kept in the RAM ring, the oldest is overwritten (0 = 16) */
+    uint16_t  resolution_cdeg;  /*!< Angle quantization step in 1/100 degree (0 = 50, i.e. 0.5 degree) */
+} audio_doa_log_cfg_t;
+
+/**
+ * @brief  Counters of the angle log
+ */
+typedef struct {
+    uint32_t  entries;             /*!< Angles appended */
+    uint32_t  blocks_sealed;       /*!< Blocks completed */
+    uint32_t  blocks_overwritten;  /*!< Sealed blocks lost because the ring was full */
+    uint32_t  blocks_queued;       /*!< Sealed blocks waiting to be read */
+} audio_doa_log_stats_t;
+
+/**
+ * @brief  Create an angle log
+ *
+ * @param[in]   cfg         Configuration (can be NULL for defaults)
+ * @param[out]  out_handle  Created handle
+ *
+ * @return
+ *       - ESP_OK               Success
+ *       - ESP_ERR_INVALID_ARG  Invalid argument
+ *       - ESP_ERR_NO_MEM       Memory allocation failed
+ */
+esp_err_t audio_doa_log_create(const audio_doa_log_cfg_t *cfg, audio_doa_log_handle_t *out_handle);
+
+/**
+ * @brief  Append an angle to a stream
+ *
+ *         Entries go to the stream's open block; when the next entry might not fit
+ *         the block is sealed into the ring.
+ *
+ * @param[in]  handle        Angle log handle
+ * @param[in]  stream        Stream to append to
+ * @param[in]  timestamp_ms  Time of the angle, non-decreasing within a stream
+ * @param[in]  angle         Angle in degrees
+ *
+ * @return
+ *       - ESP_OK               Success
+ *       - ESP_ERR_INVALID_ARG  Invalid argument
+ */
+esp_err_t audio_doa_log_append(audio_doa_log_handle_t handle, audio_doa_log_stream_t stream, uint32_t timestamp_ms, float angle);
+
+/**
+ * @brief  Seal the open blocks of all streams so they can be read
+ *
+ * @param[in]  handle  Angle log handle
+ *
+ * @return
+ *       - ESP_OK               Success
+ *       - ESP_ERR_INVALID_ARG  Invalid argument
+ */
+esp_err_t audio_doa_log_flush(audio_doa_log_handle_t handle);
+
+/**
+ * @brief  Take the oldest sealed block out of the ring
+ *
+ * @param[in]   handle  Angle log handle
+ * @param[out]  block   Destination, at least `block_size` bytes
+ * @param[in]   size    Capacity of `block`
+ * @param[out]  len     Bytes written (header and used payload only)
+ *
+ * @return
+ *       - ESP_OK                Success
+ *       - ESP_ERR_INVALID_ARG   Invalid argument
+ *       - ESP_ERR_INVALID_SIZE  `block` is smaller than `block_size`
+ *       - ESP_ERR_NOT_FOUND     No sealed block
+ */
+esp_err_t audio_doa_log_read(audio_doa_log_handle_t handle, uint8_t *block, size_t size, size_t *len);
+
+/**
+ * @brief  Get the counters of the angle log
+ *
+ * @param[in]   handle  Angle log handle
+ * @param[out]  stats   Counters
+ *
+ * @return
+ *       - ESP_OK               Success
+ *       - ESP_ERR_INVALID_ARG  Invalid argument
+ */
+esp_err_t audio_doa_log_get_stats(audio_doa_log_handle_t handle, audio_doa_log_stats_t *stats);
+
+/**
+ * @brief  Destroy an angle log
+ *
+ * @param[in]  handle  Angle log handle
+ *
+ * @return
+ *       - ESP_OK               Success
+ *       - ESP_ERR_INVALID_ARG  Invalid argument
+ */
+esp_err_t audio_doa_log_destroy(audio_doa_log_handle_t handle);
+
+#ifdef __cplusplus
+}
+#endif  /* __cplusplus */
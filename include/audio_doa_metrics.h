@@ -0,0 +1,123 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "audio_doa_app.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  /* __cplusplus */
+
+/**
+ * @brief  Instances one exporter can serve
+ */
+#define AUDIO_DOA_METRICS_MAX_INSTANCES  (8)
+
+/**
+ * @brief  Longest instance label, terminator included
+ */
+#define AUDIO_DOA_METRICS_NAME_LEN  (32)
+
+/**
+ * @brief  Handle type for the metrics exporter
+ */
+typedef void *audio_doa_metrics_handle_t;
+
+/**
+ * @brief  Configuration of the metrics exporter
+ */
+typedef struct {
+    uint16_t     port;           /*!< TCP port (0 = 9464) */
+    bool         bind_any;       /*!< Listen on all interfaces instead of loopback only */
+    const char  *unix_path;      /*!< Serve on this Unix socket instead of TCP, Linux target only (NULL = TCP) */
+    int          task_priority;  /*!< Priority of the server task (0 = 2, below the DOA tasks) */
+} audio_doa_metrics_cfg_t;
+
+/**
+ * @brief  Start serving metrics
+ *
+ *         A task answers `GET /metrics` over HTTP/1.0 with the Prometheus text
+ *         exposition format (version 0.0.4): frame, gating, drop and queue counters,
+ *         the per-frame processing time histogram, per-stage timing and tracker
+ *         decisions, each labelled with the instance name.
+ *
+ *         Counters are copied from the instances without taking any lock the DOA
+ *         tasks use, so a scrape never delays processing; values of one instance
+ *         can be a frame apart from each other.
+ *
+ * @param[in]   cfg         Configuration (can be NULL for defaults)
+ * @param[out]  out_handle  Created handle
+ *
+ * @return
+ *       - ESP_OK                 Success
+ *       - ESP_ERR_INVALID_ARG    Invalid argument
+ *       - ESP_ERR_NO_MEM         Memory allocation failed
+ *       - ESP_ERR_NOT_SUPPORTED  `unix_path` on a target without Unix sockets
+ *       - ESP_FAIL               The socket could not be opened, bound or listened on
+ */
+esp_err_t audio_doa_metrics_start(const audio_doa_metrics_cfg_t *cfg, audio_doa_metrics_handle_t *out_handle);
+
+/**
+ * @brief  Export an app instance's metrics under a name
+ *
+ * @param[in]  handle  Metrics handle
+ * @param[in]  app     App instance, must stay alive until removed
+ * @param[in]  name    Value of the `instance` label, copied
+ *
+ * @return
+ *       - ESP_OK               Success
+ *       - ESP_ERR_INVALID_ARG  Invalid argument or name too long
+ *       - ESP_ERR_NO_MEM       AUDIO_DOA_METRICS_MAX_INSTANCES reached
+ */
+esp_err_t audio_doa_metrics_add(audio_doa_metrics_handle_t handle, audio_doa_app_handle_t app, const char *name);
+
+/**
+ * @brief  Stop exporting an app instance, call before destroying it
+ *
+ * @param[in]  handle  Metrics handle
+ * @param[in]  app     App instance
+ *
+ * @return
+ *       - ESP_OK               Success
+ *       - ESP_ERR_INVALID_ARG  Invalid argument
+ *       - ESP_ERR_NOT_FOUND    The instance was not added
+ */
+esp_err_t audio_doa_metrics_remove(audio_doa_metrics_handle_t handle, audio_doa_app_handle_t app);
+
+/**
+ * @brief  Render the current metrics into a buffer, e.g. for another transport
+ *
+ * @param[in]   handle  Metrics handle
+ * @param[out]  buf     Destination, NUL terminated when it fits
+ * @param[in]   size    Capacity of `buf`
+ * @param[out]  len     Length of the text, also set when `buf` is too small
+ *
+ * @return
+ *       - ESP_OK                Success
+ *       - ESP_ERR_INVALID_ARG   Invalid argument
+ *       - ESP_ERR_INVALID_SIZE  `buf` is too small, `len` holds the size needed
+ */
+esp_err_t audio_doa_metrics_render(audio_doa_metrics_handle_t handle, char *buf, size_t size, size_t *len);
+
+/**
+ * @brief  Stop serving and free the exporter
+ *
+ * @param[in]  handle  Metrics handle
+ *
+ * @return
+ *       - ESP_OK               Success
+ *       - ESP_ERR_INVALID_ARG  Invalid argument
+ */
+esp_err_t audio_doa_metrics_stop(audio_doa_metrics_handle_t handle);
+
+#ifdef __cplusplus
+}
+#endif  /* __cplusplus */
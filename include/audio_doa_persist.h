@@ -0,0 +1,76 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  /* __cplusplus */
+
+/**
+ * @brief  NVS namespace used by the NVS persistence helpers
+ */
+#define AUDIO_DOA_PERSIST_NVS_NAMESPACE "audio_doa"
+
+/**
+ * @brief  Store a warm-start blob
+ *
+ * @param[in]  blob  Blob to store
+ * @param[in]  size  Blob size in bytes
+ * @param[in]  ctx   User context
+ */
+typedef esp_err_t (*audio_doa_persist_save_t)(const void *blob, size_t size, void *ctx);
+
+/**
+ * @brief  Load a warm-start blob
+ *
+ * @param[out]     blob  Destination buffer
+ * @param[in,out]  size  Buffer capacity in, bytes loaded out
+ * @param[in]      ctx   User context
+ *
+ * @return  ESP_ERR_NOT_FOUND when nothing has been stored yet
+ */
+typedef esp_err_t (*audio_doa_persist_load_t)(void *blob, size_t *size, void *ctx);
+
+/**
+ * @brief  Storage backend for the warm-start state
+ */
+typedef struct {
+    audio_doa_persist_save_t  save;  /*!< Store callback */
+    audio_doa_persist_load_t  load;  /*!< Load callback */
+    void                     *ctx;   /*!< User context passed to both callbacks */
+} audio_doa_persist_t;
+
+/**
+ * @brief  Store a blob in NVS, `ctx` is the key (const char *) in AUDIO_DOA_PERSIST_NVS_NAMESPACE
+ *
+ *         NVS must have been initialized with nvs_flash_init().
+ */
+esp_err_t audio_doa_persist_nvs_save(const void *blob, size_t size, void *ctx);
+
+/**
+ * @brief  Load a blob from NVS, `ctx` is the key (const char *) in AUDIO_DOA_PERSIST_NVS_NAMESPACE
+ */
+esp_err_t audio_doa_persist_nvs_load(void *blob, size_t *size, void *ctx);
+
+/**
+ * @brief  Store a blob in a file, `ctx` is the path (const char *)
+ *
+ *         Works on the host and on any mounted VFS (SPIFFS, FAT, LittleFS).
+ */
+esp_err_t audio_doa_persist_file_save(const void *blob, size_t size, void *ctx);
+
+/**
+ * @brief  Load a blob from a file, `ctx` is the path (const char *)
+ */
+esp_err_t audio_doa_persist_file_load(void *blob, size_t *size, void *ctx);
+
+#ifdef __cplusplus
+}
+#endif  /* __cplusplus */
@@ -0,0 +1,65 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include <stdint.h>
+#include "audio_doa_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  /* __cplusplus */
+
+/**
+ * @brief  Set in the instance id passed to the hooks for stages of the shadow chain
+ */
+#define AUDIO_DOA_PROFILING_SHADOW_BIT (0x80000000u)
+
+/**
+ * @brief  Profiling hook, called from the DOA task right before or after a stage runs
+ *
+ *         The pipeline boundaries map to stage kinds: frame receive is the begin of the
+ *         first stage, front-end done the end of AUDIO_DOA_STAGE_CONDITIONING, then the
+ *         ends of ENGINE, SMOOTHING and TRACKER, and callback done the end of SINK.
+ *         A frame stopped by a stage (e.g. the gate) gets no hooks after that stage's end.
+ *
+ * @param[in]  instance_id  Id of the DOA instance (`instance_id` in audio_doa_stats_t),
+ *                          with AUDIO_DOA_PROFILING_SHADOW_BIT set for the shadow chain
+ * @param[in]  frame_index  Frame number, starting at 1
+ * @param[in]  stage        Stage about to run or just finished
+ * @param[in]  ctx          User context
+ */
+typedef void (*audio_doa_profiling_hook_t)(uint32_t instance_id, uint32_t frame_index,
+                                           const audio_doa_stage_t *stage, void *ctx);
+
+/**
+ * @brief  Profiling hooks shared by all DOA instances
+ */
+typedef struct {
+    audio_doa_profiling_hook_t  begin;  /*!< Before each stage (can be NULL) */
+    audio_doa_profiling_hook_t  end;    /*!< After each stage (can be NULL) */
+    void                       *ctx;    /*!< User context passed to both hooks */
+} audio_doa_profiling_hooks_t;
+
+/**
+ * @brief  Register the profiling hooks for all DOA instances
+ *
+ *         The hooks run inline in the processing tasks and add to every stage's
+ *         time, so they should only record a timestamp or a trace event.
+ *         The structure is not copied and must stay valid until it is replaced.
+ *
+ * @param[in]  hooks  Hooks to install (NULL = remove)
+ *
+ * @return
+ *       - ESP_OK                 Success
+ *       - ESP_ERR_NOT_SUPPORTED  CONFIG_AUDIO_DOA_PROFILING_HOOKS is disabled
+ */
+esp_err_t audio_doa_set_profiling_hooks(const audio_doa_profiling_hooks_t *hooks);
+
+#ifdef __cplusplus
+}
+#endif  /* __cplusplus */
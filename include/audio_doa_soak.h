@@ -0,0 +1,100 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include <stdint.h>
+#include "audio_doa_app.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  /* __cplusplus */
+
+/**
+ * @brief  Failure flags of a soak run
+ */
+#define AUDIO_DOA_SOAK_FAIL_LATENCY_DRIFT  (1 << 0)  /*!< An interval's p95 latency rose above the first interval's by more than `drift_ms` */
+#define AUDIO_DOA_SOAK_FAIL_LEAK           (1 << 1)  /*!< Free heap after destroying an instance fell by more than `leak_bytes` */
+#define AUDIO_DOA_SOAK_FAIL_STALL          (1 << 2)  /*!< A written frame had no result after `stall_ms` */
+#define AUDIO_DOA_SOAK_FAIL_DROPPED        (1 << 3)  /*!< Samples were dropped or frames discarded at real-time pace */
+#define AUDIO_DOA_SOAK_FAIL_ERROR          (1 << 4)  /*!< An API call returned an error */
+
+/**
+ * @brief  Soak progress, also the final result
+ */
+typedef struct {
+    uint32_t  elapsed_s;            /*!< Wall time since the start */
+    uint64_t  bytes_written;        /*!< Bytes passed to audio_doa_app_data_write(), VAD-off chunks included */
+    uint32_t  frames_written;       /*!< Complete frames written while VAD was on */
+    uint32_t  results;              /*!< Per-frame results received (monitor callback) */
+    uint32_t  tracker_results;      /*!< Tracker outputs received (result callback) */
+    float     frames_per_s;         /*!< Results per second of wall time */
+    uint32_t  latency_p50_ms;       /*!< Write-to-result latency percentiles over the last interval */
+    uint32_t  latency_p95_ms;
+    uint32_t  latency_p99_ms;
+    uint32_t  latency_total_p99_ms; /*!< p99 over the whole run */
+    uint32_t  latency_max_ms;       /*!< Longest latency over the whole run */
+    uint32_t  samples_dropped;      /*!< Sum of audio_doa_stats_t samples_dropped over all instances */
+    uint32_t  frames_discarded;     /*!< Sum of audio_doa_stats_t frames_discarded over all instances */
+    int32_t   heap_growth_bytes;    /*!< Free heap lost since the start, measured with no instance alive */
+    uint32_t  vad_toggles;
+    uint32_t  restarts;             /*!< Stop/start cycles */
+    uint32_t  reconfigures;         /*!< Destroy/create cycles with a changed configuration */
+    uint32_t  failures;             /*!< AUDIO_DOA_SOAK_FAIL_* flags seen so far */
+} audio_doa_soak_report_t;
+
+/**
+ * @brief  Called from the soak task once per report interval
+ *
+ * @param[in]  report  Progress so far
+ * @param[in]  ctx     User context
+ */
+typedef void (*audio_doa_soak_progress_t)(const audio_doa_soak_report_t *report, void *ctx);
+
+/**
+ * @brief  Soak run configuration, 0 selects the default of each field
+ */
+typedef struct {
+    uint32_t                   duration_s;   /*!< Run time (0 = 3600) */
+    uint32_t                   report_s;     /*!< Report interval (0 = 60) */
+    uint32_t                   seed;         /*!< Seed of the random schedule, a run is repeatable for a seed (0 = 1) */
+    uint32_t                   drift_ms;     /*!< Allowed p95 latency rise (0 = 20) */
+    uint32_t                   leak_bytes;   /*!< Allowed free heap loss (0 = 4096) */
+    uint32_t                   stall_ms;     /*!< Longest wait for a frame's result (0 = 2000) */
+    audio_doa_soak_progress_t  progress;     /*!< Progress callback (can be NULL) */
+    void                      *ctx;          /*!< Context passed to `progress` */
+} audio_doa_soak_cfg_t;
+
+/**
+ * @brief  Stream synthetic audio through an app instance for a long time, varying its lifecycle
+ *
+ *         Writes synthetic stereo (or `mic_num` channel) audio at real-time pace in chunks of
+ *         random size from the calling task, and at random toggles VAD, stops and restarts the
+ *         instance, and destroys and recreates it with smoothing, stage timing and decimation
+ *         flipped. The gating stage is left out so every written frame has a result, and the
+ *         user callbacks, persistence and angle log of `config` are not used.
+ *
+ *         Blocks for `duration_s`. Needs about 4 KB of heap for latency histograms besides the instance.
+ *         Also runs on the host port in python/host/, the `soak` check of tools/audio_doa_host_eval.c.
+ *
+ * @param[in]   config  Base configuration of the instance
+ * @param[in]   cfg     Soak configuration (can be NULL for defaults)
+ * @param[out]  report  Final report
+ *
+ * @return
+ *       - ESP_OK               The run finished without failures
+ *       - ESP_FAIL             The run finished with failures, see `report->failures`
+ *       - ESP_ERR_INVALID_ARG  Invalid arguments
+ *       - ESP_ERR_NO_MEM       Memory allocation failed
+ *       - Other                The instance could not be created
+ */
+esp_err_t audio_doa_soak_run(const audio_doa_app_config_t *config, const audio_doa_soak_cfg_t *cfg,
+                             audio_doa_soak_report_t *report);
+
+#ifdef __cplusplus
+}
+#endif  /* __cplusplus */
@@ -0,0 +1,231 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  /* __cplusplus */
+
+/**
+ * @brief  Maximum number of microphones in one array
+ */
+#ifdef CONFIG_AUDIO_DOA_MAX_MICS
+#define AUDIO_DOA_MAX_MICS (CONFIG_AUDIO_DOA_MAX_MICS)
+#else
+#define AUDIO_DOA_MAX_MICS (4)
+#endif  /* CONFIG_AUDIO_DOA_MAX_MICS */
+
+/**
+ * @brief  Maximum number of stages in one processing pipeline, built-in stages included
+ */
+#ifdef CONFIG_AUDIO_DOA_MAX_STAGES
+#define AUDIO_DOA_MAX_STAGES (CONFIG_AUDIO_DOA_MAX_STAGES)
+#else
+#define AUDIO_DOA_MAX_STAGES (12)
+#endif  /* CONFIG_AUDIO_DOA_MAX_STAGES */
+
+/**
+ * @brief  Buckets of the per-frame processing time histogram in audio_doa_stats_t
+ *
+ *         Bucket i counts frames faster than AUDIO_DOA_FRAME_TIME_BUCKET_US(i), the last
+ *         bucket counts everything slower than the one before it.
+ */
+#define AUDIO_DOA_FRAME_TIME_BUCKETS    (9)
+#define AUDIO_DOA_FRAME_TIME_BUCKET_US(i) (250u << (i))
+
+/**
+ * @brief  DOA estimation backend
+ */
+typedef enum {
+    AUDIO_DOA_ENGINE_ESP_SR,    /*!< esp-sr pairwise DOA, two microphones only (default) */
+    AUDIO_DOA_ENGINE_SRP_PHAT,  /*!< Steered response power with PHAT weighting, two or more microphones */
+    AUDIO_DOA_ENGINE_ONE_BIT,   /*!< Sign-bit XOR/popcount correlator, two microphones, no FPU needed in the inner loop */
+} audio_doa_engine_t;
+
+/**
+ * @brief  Microphone position in the array plane, in meters
+ *
+ *         The x axis points from the 0 degree (left) side to the 180 degree (right)
+ *         side and the y axis points to the front (90 degrees).
+ */
+typedef struct {
+    float x;
+    float y;
+} audio_doa_mic_pos_t;
+
+/**
+ * @brief  How a frame broken by a capture gap is handled
+ */
+typedef enum {
+    AUDIO_DOA_GAP_DISCARD,    /*!< Complete the broken frame with silence and skip it (default) */
+    AUDIO_DOA_GAP_ZERO_FILL,  /*!< Insert silence for the missing samples and keep the frame */
+} audio_doa_gap_policy_t;
+
+/**
+ * @brief  Pipeline stage kinds, in processing order
+ *
+ *         Stages run sorted by kind. A stage added with a kind runs after every
+ *         stage of the same or an earlier kind already in the pipeline.
+ */
+typedef enum {
+    AUDIO_DOA_STAGE_SOURCE,        /*!< Raw interleaved frame, before deinterleaving */
+    AUDIO_DOA_STAGE_CONDITIONING,  /*!< Deinterleave and optional 2:1 decimation */
+    AUDIO_DOA_STAGE_GATING,        /*!< Frame rejection, e.g. the RMS gate */
+    AUDIO_DOA_STAGE_ENGINE,        /*!< DOA estimation */
+    AUDIO_DOA_STAGE_SMOOTHING,     /*!< Gaussian smoothing over the last frames */
+    AUDIO_DOA_STAGE_CALIBRATION,   /*!< Engine specific angle correction */
+    AUDIO_DOA_STAGE_TRACKER,       /*!< Slow tracker in the application layer */
+    AUDIO_DOA_STAGE_SINK,          /*!< Result delivery */
+    AUDIO_DOA_STAGE_KIND_MAX,
+} audio_doa_stage_kind_t;
+
+/**
+ * @brief  Frame passed along the pipeline
+ */
+typedef struct {
+    const int16_t   *interleaved;  /*!< Raw frame, `mic_num` interleaved channels */
+    int16_t *const  *mic_data;     /*!< Per-channel samples, NULL before the conditioning stage */
+    int              mic_num;      /*!< Number of channels */
+    int              samples;      /*!< Samples per channel in `mic_data` (halved by decimation) */
+    int              sample_rate;  /*!< Sample rate of `mic_data` */
+    uint32_t         index;        /*!< Frame number, starting at 1 */
+    float            angle;        /*!< Set by the engine stage and refined by later stages, in degrees */
+    float            weight;       /*!< Confidence of `angle` for smoothing, e.g. frame RMS or an engine score (0 = smoothing measures the RMS) */
+} audio_doa_frame_t;
+
+/**
+ * @brief  Stage processing function
+ *
+ * @param[in,out]  frame  Current frame
+ * @param[in]      ctx    Stage context
+ *
+ * @return  true to pass the frame on, false to stop processing it
+ */
+typedef bool (*audio_doa_stage_process_t)(audio_doa_frame_t *frame, void *ctx);
+
+/**
+ * @brief  Analysis window of the engine, see `adaptive_window` in the configuration
+ */
+typedef enum {
+    AUDIO_DOA_WINDOW_SHORT,  /*!< Latest half frame: lowest latency and cost, for a moving talker */
+    AUDIO_DOA_WINDOW_FRAME,  /*!< The current frame, the only window without `adaptive_window` */
+    AUDIO_DOA_WINDOW_LONG,   /*!< Latest two frames: most accurate, for a stationary talker */
+    AUDIO_DOA_WINDOW_NUM,
+} audio_doa_window_t;
+
+/**
+ * @brief  Use and cost of one analysis window
+ */
+typedef struct {
+    uint32_t  samples;     /*!< Per-channel samples analysed, at the engine's sample rate (0 = window not available) */
+    uint32_t  latency_ms;  /*!< Age of the window's centre when the estimate is made */
+    uint32_t  frames;      /*!< Estimates made with this window */
+    uint32_t  engine_us;   /*!< Average engine time per estimate */
+} audio_doa_window_stats_t;
+
+/**
+ * @brief  Called from the DOA task when a window of frames reached its deadline miss limit
+ *
+ *         Fires at most once per window, on the miss that reaches the limit.
+ *
+ * @param[in]  misses  Frames of the window that took longer than the deadline so far
+ * @param[in]  frames  Frames of the window processed so far
+ * @param[in]  ctx     User context
+ */
+typedef void (*audio_doa_deadline_callback_t)(uint32_t misses, uint32_t frames, void *ctx);
+
+/**
+ * @brief  Pipeline stage description
+ */
+typedef struct {
+    const char                *name;     /*!< Name shown in the stage statistics */
+    audio_doa_stage_kind_t     kind;     /*!< Position in the pipeline */
+    audio_doa_stage_process_t  process;  /*!< Processing function, called from the DOA task */
+    void                      *ctx;      /*!< Context passed to `process` */
+} audio_doa_stage_t;
+
+/**
+ * @brief  Timing of one pipeline stage, collected when stage timing is enabled
+ */
+typedef struct {
+    const char              *name;
+    audio_doa_stage_kind_t   kind;
+    uint32_t                 calls;   /*!< Frames that reached the stage */
+    uint32_t                 avg_us;  /*!< Average time per call */
+    uint32_t                 max_us;  /*!< Longest call */
+} audio_doa_stage_stats_t;
+
+/**
+ * @brief  Runtime counters of one DOA instance
+ */
+typedef struct {
+    uint32_t  frames_processed;     /*!< Frames that reached the DOA engine */
+    uint32_t  frames_discarded;     /*!< Frames skipped because a gap broke them */
+    uint32_t  frames_gated;         /*!< Frames stopped by a gating stage */
+    float     noise_floor_rms;      /*!< Noise floor estimate of the gating stage (0 = gating off or not learned) */
+    uint32_t  gap_events;           /*!< Writes that started later than the expected sample index */
+    uint32_t  overlap_events;       /*!< Writes that started earlier than the expected sample index */
+    uint32_t  samples_zero_filled;  /*!< Per-channel samples of silence inserted for gaps */
+    uint32_t  samples_dropped;      /*!< Per-channel samples dropped as overlap or on buffer overflow */
+    uint32_t  wakeups;              /*!< Times the processing task woke up to look for audio */
+    uint32_t  batch_frames;         /*!< Frames received over all wakeups, batch_frames / wakeups is the average batch */
+    uint32_t  max_batch_frames;     /*!< Largest number of frames handled in one wakeup */
+    uint32_t  primary_chain_us;     /*!< Average processing time of the primary chain per frame */
+    uint32_t  shadow_chain_us;      /*!< Average processing time of the shadow chain per frame */
+    uint32_t  shadow_frames;        /*!< Frames processed by the shadow chain */
+    uint32_t  shadow_frames_dropped;           /*!< Frames the shadow skipped to keep the primary on time */
+    float     shadow_mean_disagreement_deg;    /*!< Mean |shadow - primary| over frames seen by both chains */
+    float     shadow_max_disagreement_deg;     /*!< Largest |shadow - primary| seen so far */
+    uint32_t  shadow_tracker_outputs;          /*!< Outputs of the shadow tracker (application layer) */
+    uint32_t  shadow_tracker_disagreements;    /*!< Shadow tracker outputs differing from the last primary output (application layer) */
+    uint32_t  instance_heap_bytes;  /*!< Heap taken by audio_doa_new(): buffers, engine state and task stacks */
+    uint32_t  create_us;            /*!< Time spent creating the instance */
+    uint32_t  first_result_us;      /*!< Time from the start of creation to the first result (0 = none yet) */
+    uint32_t  instance_id;          /*!< Id passed to the profiling hooks, see audio_doa_profiling.h */
+    uint32_t  queue_frames;         /*!< Frames waiting in the stream buffer when the counters were read */
+    uint32_t  frame_time_hist[AUDIO_DOA_FRAME_TIME_BUCKETS];  /*!< Primary chain time per frame, see AUDIO_DOA_FRAME_TIME_BUCKET_US (stage timing builds only) */
+    uint64_t  frame_time_sum_us;    /*!< Sum of the primary chain times counted in `frame_time_hist` (stage timing builds only) */
+    uint32_t  tracker_outputs;      /*!< Tracker results delivered (application layer) */
+    uint32_t  tracker_rejected;     /*!< Angles the tracker refused as implausible (application layer) */
+    uint32_t  tracker_held;         /*!< Tracker outputs withheld: jump too large, change too small or 90 degrees unconfirmed (application layer) */
+    uint32_t  tracker_resets;       /*!< Tracker restarts after silence or a major angle change (application layer) */
+    uint32_t  deadline_us;          /*!< Processing deadline per frame in effect */
+    uint32_t  deadline_misses;      /*!< Frames whose primary chain took longer than `deadline_us` */
+    uint32_t  deadline_worst_overrun_us;  /*!< Largest time past the deadline of a single frame */
+    audio_doa_window_stats_t  windows[AUDIO_DOA_WINDOW_NUM];  /*!< Primary engine use per analysis window */
+    uint32_t  window_switches;      /*!< Frames analysed with a different window than the previous one */
+} audio_doa_stats_t;
+
+/**
+ * @brief  Cost of one pipeline stage measured by the self-benchmark
+ */
+typedef struct {
+    const char              *name;
+    audio_doa_stage_kind_t   kind;
+    uint32_t                 cycles_per_frame;  /*!< Average CPU cycles per call */
+} audio_doa_benchmark_stage_t;
+
+/**
+ * @brief  Result of the self-benchmark
+ */
+typedef struct {
+    uint32_t                     frames;            /*!< Frames run through the pipeline */
+    uint32_t                     cycles_per_frame;  /*!< Average CPU cycles per frame over the whole pipeline */
+    audio_doa_benchmark_stage_t  stages[AUDIO_DOA_MAX_STAGES];  /*!< Per-stage cost, in pipeline order */
+    int                          stage_num;         /*!< Number of entries in `stages` */
+    uint32_t                     peak_stack_bytes;  /*!< Deepest stack use, measured on a task with the DOA task's stack size */
+    uint32_t                     peak_heap_bytes;   /*!< Heap held by the instance at its peak, create-time allocations included */
+    float                        real_time_factor;  /*!< Processing time over audio duration, below 1 keeps up with capture */
+} audio_doa_benchmark_t;
+
+#ifdef __cplusplus
+}
+#endif  /* __cplusplus */
@@ -7,6 +7,9 @@
 #pragma once
 
 #include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include "audio_doa_types.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -27,11 +30,36 @@ typedef void (*audio_doa_callback_t)(float angle, void *ctx);
 
 /**
  * @brief  Configuration structure for audio DOA
- *
- *         Currently empty, reserved for future configuration options.
  */
 typedef struct {
-    float distance;
+    float               distance;  /*!< Microphone spacing in meters (0 = default 0.046) */
+    audio_doa_engine_t  engine;    /*!< DOA estimation backend */
+    int                 mic_num;   /*!< Number of interleaved microphone channels (0 = default 2) */
+    audio_doa_mic_pos_t mic_pos[AUDIO_DOA_MAX_MICS];  /*!< Array geometry for AUDIO_DOA_ENGINE_SRP_PHAT.
+                                                           All zero = uniform linear array spaced by `distance` */
+    bool                decimate;  /*!< Low-pass and decimate each channel 2:1 before the DOA engine.
+                                        The engine then analyses 0-4 kHz at 8 kHz instead of the full
+                                        16 kHz band, which roughly halves the engine cost */
+    audio_doa_gap_policy_t gap_policy;  /*!< Handling of frames broken by gaps, see audio_doa_data_write_with_seq() */
+    uint32_t            batch_interval_ms;  /*!< Batched low-power mode: the task sleeps this long between bursts (0 = off).
+                                                 The stream buffer grows to hold a whole interval of audio */
+    int                 batch_frames;       /*!< Batched mode: wake early once this many frames are queued (0 = interval only) */
+    bool                shadow;             /*!< Run a second chain on the same frames for comparison, its results never reach `cb` */
+    audio_doa_engine_t  shadow_engine;      /*!< Shadow chain: DOA engine */
+    bool                shadow_decimate;    /*!< Shadow chain: 2:1 decimation */
+    float               gate_rms;           /*!< Skip frames whose RMS is below this level or 6 dB above the learned noise floor (0 = no gating stage) */
+    bool                disable_smoothing;  /*!< Leave the Gaussian smoothing stage out of the pipeline */
+    bool                stage_timing;       /*!< Time every pipeline stage, see audio_doa_get_stage_stats() */
+    const audio_doa_stage_t *stages;        /*!< Custom stages inserted at their kind's position (can be NULL) */
+    int                 stage_num;          /*!< Number of entries in `stages` */
+    uint32_t            deadline_us;        /*!< Processing deadline per frame (0 = one frame of audio, 32 ms at 512 samples) */
+    uint32_t            deadline_miss_limit;     /*!< Misses within a window that fire the deadline callback (0 = 3) */
+    uint32_t            deadline_window_frames;  /*!< Frames per deadline window (0 = 32, about one second) */
+    bool                adaptive_window;    /*!< Keep two frames of planar history and analyse the window chosen
+                                                 with audio_doa_set_window() (primary chain only). Creates an
+                                                 engine per window, about three times the engine memory */
+    bool                synchronous;        /*!< No task or stream buffer: frames only reach the stages through
+                                                 audio_doa_process(), in the caller's context. Not with `shadow` */
 } audio_doa_config_t;
 
 /**
@@ -50,6 +78,9 @@ esp_err_t audio_doa_new(audio_doa_handle_t *doa_handle, audio_doa_config_t *conf
 /**
  * @brief  Delete an audio DOA instance
  *
+ *         Stops processing and waits for the DOA task and the shadow task to finish
+ *         the frame in hand before they are deleted and the instance is freed.
+ *
  * @param  doa_handle  DOA handle to delete
  * @return
  *       - ESP_OK               Success
@@ -71,6 +102,39 @@ esp_err_t audio_doa_delete(audio_doa_handle_t doa_handle);
  */
 esp_err_t audio_doa_set_doa_result_callback(audio_doa_handle_t doa_handle, audio_doa_callback_t cb, void *ctx);
 
+/**
+ * @brief  Set the callback fired when deadline misses exceed the configured rate
+ *
+ *         Frames are counted in consecutive windows of `deadline_window_frames`; the callback
+ *         is called from the DOA task when a window reaches `deadline_miss_limit` misses, so a
+ *         scheduler can shed other work before the stream buffer overflows.
+ *
+ * @param  doa_handle  DOA handle
+ * @param  cb          Callback function (can be NULL to disable callback)
+ * @param  ctx         User-defined context pointer passed to callback
+ * @return
+ *       - ESP_OK               Success
+ *       - ESP_ERR_INVALID_ARG  Invalid handle
+ */
+esp_err_t audio_doa_set_deadline_callback(audio_doa_handle_t doa_handle, audio_doa_deadline_callback_t cb, void *ctx);
+
+/**
+ * @brief  Choose the analysis window of the primary engine
+ *
+ *         Takes effect from the next frame; can be called from any task, usually from a
+ *         tracker stage. Until the history holds enough audio the frame window is used.
+ *
+ * @param[in]  doa_handle  DOA handle
+ * @param[in]  window      Window for the following estimates
+ *
+ * @return
+ *       - ESP_OK                 Success
+ *       - ESP_ERR_INVALID_ARG    Invalid argument
+ *       - ESP_ERR_INVALID_STATE  The instance was created without `adaptive_window`
+ *       - ESP_ERR_NOT_SUPPORTED  CONFIG_AUDIO_DOA_ADAPTIVE_WINDOW is disabled
+ */
+esp_err_t audio_doa_set_window(audio_doa_handle_t doa_handle, audio_doa_window_t window);
+
 /**
  * @brief  Start DOA processing
  *
@@ -111,6 +175,160 @@ esp_err_t audio_doa_stop(audio_doa_handle_t doa_handle);
  */
 esp_err_t audio_doa_data_write(audio_doa_handle_t doa_handle, uint8_t *data, int data_size);
 
+/**
+ * @brief  Write audio data tagged with the index of its first sample
+ *
+ *         `sample_index` counts per-channel samples since capture start (for a
+ *         capture timestamp use timestamp_us * 16000 / 1000000). A write that starts
+ *         after the expected index is a gap: the frame it breaks is completed with
+ *         silence and skipped (AUDIO_DOA_GAP_DISCARD) or the missing samples are
+ *         replaced by silence up to the frame boundary (AUDIO_DOA_GAP_ZERO_FILL).
+ *         A write that starts before the expected index is an overlap and the
+ *         repeated samples are dropped. Either way the stream resynchronizes on the
+ *         new index and the event is counted in audio_doa_stats_t.
+ *
+ *         If the internal buffer has no room for the whole write nothing is written,
+ *         the next write is then handled as a gap.
+ *
+ * @param  doa_handle    DOA handle
+ * @param  data          Interleaved 16-bit samples, a whole number of sample frames
+ * @param  data_size     Size of audio data in bytes
+ * @param  sample_index  Index of the first per-channel sample in `data`
+ * @return
+ *       - ESP_OK                Success (including fully overlapped writes, which are dropped)
+ *       - ESP_ERR_INVALID_ARG   Invalid handle or data pointer
+ *       - ESP_ERR_INVALID_SIZE  `data_size` is not a multiple of the sample frame size
+ *       - ESP_FAIL              Buffer full, data dropped
+ */
+esp_err_t audio_doa_data_write_with_seq(audio_doa_handle_t doa_handle, uint8_t *data, int data_size, uint64_t sample_index);
+
+/**
+ * @brief  Run whole frames through the pipeline in the caller's context
+ *
+ *         For instances created with `synchronous`. The stages read `data` in place,
+ *         frame after frame, and the result callback is called before this returns.
+ *
+ * @param[in]  doa_handle  DOA handle
+ * @param[in]  data        Interleaved 16-bit samples, `frames` x CONFIG_AUDIO_DOA_FRAME_SAMPLES sample frames
+ * @param[in]  frames      Number of frames in `data`
+ * @return
+ *       - ESP_OK                 Success
+ *       - ESP_ERR_INVALID_ARG    Invalid handle or data pointer
+ *       - ESP_ERR_INVALID_STATE  Not a synchronous instance, or stopped
+ */
+esp_err_t audio_doa_process(audio_doa_handle_t doa_handle, const int16_t *data, int frames);
+
+/**
+ * @brief  Get the runtime counters of a DOA instance
+ *
+ *         Safe to call from any task while audio is processed: the counters are copied in
+ *         one short critical section, so 64-bit sums and the counts they are averaged over
+ *         belong to the same frames.
+ *
+ * @param  doa_handle  DOA handle
+ * @param  stats       Output counters
+ * @return
+ *       - ESP_OK               Success
+ *       - ESP_ERR_INVALID_ARG  Invalid handle or stats pointer
+ */
+esp_err_t audio_doa_get_stats(audio_doa_handle_t doa_handle, audio_doa_stats_t *stats);
+
+/**
+ * @brief  Seed the noise floor estimate of the gating stage
+ *
+ *         Used to restore a saved estimate so gating is right from the first frame
+ *         instead of after the floor has been learned again.
+ *
+ * @param[in]  doa_handle  DOA handle
+ * @param[in]  rms         Noise floor RMS (0 = learn from scratch)
+ *
+ * @return
+ *       - ESP_OK               Success
+ *       - ESP_ERR_INVALID_ARG  Invalid argument
+ */
+esp_err_t audio_doa_set_noise_floor(audio_doa_handle_t doa_handle, float rms);
+
+/**
+ * @brief  Insert a stage into the processing pipeline
+ *
+ *         The stage runs after every stage of the same or an earlier kind already
+ *         in the pipeline. Stages can only be added while processing is stopped; the
+ *         call first waits for the DOA task to finish its current frame and park.
+ *
+ * @param[in]  doa_handle  DOA handle
+ * @param[in]  stage       Stage description, copied
+ *
+ * @return
+ *       - ESP_OK                 Success
+ *       - ESP_ERR_INVALID_ARG    Invalid argument
+ *       - ESP_ERR_INVALID_STATE  Processing is running
+ *       - ESP_ERR_TIMEOUT        The DOA task did not park after audio_doa_stop()
+ *       - ESP_ERR_NO_MEM         AUDIO_DOA_MAX_STAGES reached
+ */
+esp_err_t audio_doa_add_stage(audio_doa_handle_t doa_handle, const audio_doa_stage_t *stage);
+
+/**
+ * @brief  Get the per-stage timing of the primary pipeline
+ *
+ *         Counters stay zero unless `stage_timing` is set in the configuration.
+ *
+ * @param[in]   doa_handle  DOA handle
+ * @param[out]  stats       Output array, AUDIO_DOA_MAX_STAGES entries are always enough
+ * @param[in]   max_count   Capacity of `stats`
+ * @param[out]  count       Number of entries written
+ *
+ * @return
+ *       - ESP_OK               Success
+ *       - ESP_ERR_INVALID_ARG  Invalid argument
+ */
+esp_err_t audio_doa_get_stage_stats(audio_doa_handle_t doa_handle, audio_doa_stage_stats_t *stats, int max_count, int *count);
+
+/**
+ * @brief  Set the callback receiving the shadow chain's angles
+ *
+ *         Called from the shadow task. The shadow runs at a lower priority than the
+ *         primary and skips frames rather than delaying it.
+ *
+ * @param[in]  doa_handle  DOA handle
+ * @param[in]  cb          Shadow result callback (NULL to clear)
+ * @param[in]  ctx         User context passed to the callback
+ *
+ * @return
+ *       - ESP_OK                 Success
+ *       - ESP_ERR_INVALID_ARG    Invalid argument
+ *       - ESP_ERR_INVALID_STATE  Shadow mode is not enabled
+ */
+esp_err_t audio_doa_set_shadow_result_callback(audio_doa_handle_t doa_handle, audio_doa_callback_t cb, void *ctx);
+
+/**
+ * @brief  Run a synthetic signal through the primary pipeline and measure its cost
+ *
+ *         Frames of broadband noise arriving off broadside are fed straight to the
+ *         stages from a temporary task with the DOA task's stack size and priority,
+ *         bypassing the stream buffer. The instance must be stopped; the call first
+ *         waits for the DOA task to finish its current frame and park, and must not
+ *         overlap audio_doa_start().
+ *
+ *         Buffered audio and a partially received frame are left untouched, but every
+ *         stage processes the synthetic frames: smoothing and decimator history, the
+ *         learned noise floor, the adaptive window history, application stages such as
+ *         the tracker and the shadow chain all carry them afterwards, and the result
+ *         callback is called for them. Meant for a dedicated instance, as
+ *         audio_doa_app_benchmark() creates; recreate the instance before real use.
+ *
+ * @param[in]   doa_handle  DOA handle
+ * @param[in]   frames      Frames to run (0 = 100)
+ * @param[out]  result      Measured cost
+ *
+ * @return
+ *       - ESP_OK                 Success
+ *       - ESP_ERR_INVALID_ARG    Invalid argument
+ *       - ESP_ERR_INVALID_STATE  Processing is running
+ *       - ESP_ERR_TIMEOUT        The DOA task did not park after audio_doa_stop()
+ *       - ESP_ERR_NO_MEM         Benchmark task or frame buffer could not be created
+ */
+esp_err_t audio_doa_benchmark(audio_doa_handle_t doa_handle, uint32_t frames, audio_doa_benchmark_t *result);
+
 #ifdef __cplusplus
 }
 #endif  /* __cplusplus */
@@ -0,0 +1,57 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif  /* __cplusplus */
+
+/**
+ * @brief  Opaque 1-bit correlator engine instance
+ */
+typedef struct audio_doa_onebit audio_doa_onebit_t;
+
+/**
+ * @brief  Create a 1-bit (sign) correlator DOA engine
+ *
+ *         Only the sign of each sample is kept, packed 32 samples per word. The
+ *         cross-correlation over the lag range implied by `distance` is then an
+ *         XOR and a popcount per word and lag, so no multiplier or FPU is needed
+ *         in the inner loop.
+ *
+ * @param  sample_rate    Sample rate of the planar frames in Hz
+ * @param  distance       Microphone spacing in meters
+ * @param  frame_samples  Samples per channel per frame, multiple of 32
+ * @return
+ *       - Engine instance on success
+ *       - NULL on invalid arguments or allocation failure
+ */
+audio_doa_onebit_t *audio_doa_onebit_create(int sample_rate, float distance, int frame_samples);
+
+/**
+ * @brief  Estimate the direction of arrival of one planar frame
+ *
+ * @param  engine  Engine instance
+ * @param  left    Left (0 degree side) microphone samples
+ * @param  right   Right (180 degree side) microphone samples
+ * @return
+ *       - Estimated angle in degrees (0-180)
+ */
+float audio_doa_onebit_process(audio_doa_onebit_t *engine, const int16_t *left, const int16_t *right);
+
+/**
+ * @brief  Destroy a 1-bit correlator engine
+ *
+ * @param  engine  Engine instance (can be NULL)
+ */
+void audio_doa_onebit_destroy(audio_doa_onebit_t *engine);
+
+#ifdef __cplusplus
+}
+#endif  /* __cplusplus */
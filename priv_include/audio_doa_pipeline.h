@@ -0,0 +1,90 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include "audio_doa_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  /* __cplusplus */
+
+/**
+ * @brief  One pipeline entry with its timing counters
+ */
+typedef struct {
+    audio_doa_stage_t  stage;
+    int64_t            total_us;
+    uint32_t           calls;
+    uint32_t           max_us;
+} audio_doa_stage_slot_t;
+
+/**
+ * @brief  Ordered list of stages, built once before processing starts
+ *
+ *         Only stages that are enabled are ever added, so a disabled feature
+ *         costs nothing per frame.
+ */
+typedef struct {
+    audio_doa_stage_slot_t  slots[AUDIO_DOA_MAX_STAGES];
+    int                     stage_num;
+    bool                    timed;        /*!< Collect per-stage timing */
+    uint32_t                instance_id;  /*!< Passed to the profiling hooks */
+} audio_doa_pipeline_t;
+
+/**
+ * @brief  Insert a stage after every stage of the same or an earlier kind
+ *
+ * @param  pipeline  Pipeline
+ * @param  stage     Stage to insert, copied
+ * @return
+ *       - ESP_OK               Success
+ *       - ESP_ERR_INVALID_ARG  Missing process function or invalid kind
+ *       - ESP_ERR_NO_MEM       Pipeline is full
+ */
+esp_err_t audio_doa_pipeline_add(audio_doa_pipeline_t *pipeline, const audio_doa_stage_t *stage);
+
+/**
+ * @brief  Run a frame through the pipeline
+ *
+ * @param  pipeline  Pipeline
+ * @param  frame     Frame to process
+ * @return
+ *       - true   Every stage passed the frame on
+ *       - false  A stage stopped the frame
+ */
+bool audio_doa_pipeline_run(audio_doa_pipeline_t *pipeline, audio_doa_frame_t *frame);
+
+/**
+ * @brief  Run a frame through the pipeline counting CPU cycles per stage
+ *
+ * @param  pipeline  Pipeline
+ * @param  frame     Frame to process
+ * @param  cycles    Cycles added per slot, `stage_num` entries
+ * @param  calls     Calls added per slot, `stage_num` entries
+ * @return
+ *       - true   Every stage passed the frame on
+ *       - false  A stage stopped the frame
+ */
+bool audio_doa_pipeline_run_counted(audio_doa_pipeline_t *pipeline, audio_doa_frame_t *frame, uint64_t *cycles, uint32_t *calls);
+
+/**
+ * @brief  Copy the per-stage timing
+ *
+ * @param  pipeline   Pipeline
+ * @param  stats      Output array
+ * @param  max_count  Capacity of `stats`
+ * @return
+ *       - Number of entries written
+ */
+int audio_doa_pipeline_get_stats(const audio_doa_pipeline_t *pipeline, audio_doa_stage_stats_t *stats, int max_count);
+
+#ifdef __cplusplus
+}
+#endif  /* __cplusplus */
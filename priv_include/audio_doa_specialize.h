@@ -0,0 +1,85 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "sdkconfig.h"
+
+/**
+ * Fixed-format code generators
+ *
+ * Each macro expands to a static function whose sizes and channel count are
+ * compile-time constants, so the loops unroll and the index arithmetic folds
+ * away. The pipeline picks an instantiation once at create time when the
+ * runtime configuration matches it and falls back to the generic code otherwise.
+ */
+
+/**
+ * @brief  Use the fixed-format instantiations (0 = always run the generic code, for comparison)
+ *
+ *         Follows CONFIG_AUDIO_DOA_SPECIALIZE unless defined on the command line.
+ */
+#ifndef AUDIO_DOA_SPECIALIZE
+#if CONFIG_AUDIO_DOA_SPECIALIZE
+#define AUDIO_DOA_SPECIALIZE 1
+#else
+#define AUDIO_DOA_SPECIALIZE 0
+#endif  /* CONFIG_AUDIO_DOA_SPECIALIZE */
+#endif  /* AUDIO_DOA_SPECIALIZE */
+
+/**
+ * @brief  Generate `static void name(int16_t *const *out, const int16_t *in)`
+ *
+ *         Splits SAMPLES frames of MICS interleaved channels into planar buffers
+ *         in one pass over the input, the channel loop unrolls completely.
+ */
+#define AUDIO_DOA_DEFINE_DEINTERLEAVE(name, MICS, SAMPLES)                       \
+    static void name(int16_t *const *out, const int16_t *in)                     \
+    {                                                                            \
+        int16_t *restrict dst[(MICS)];                                           \
+        for (int m = 0; m < (MICS); m++) {                                       \
+            dst[m] = out[m];                                                     \
+        }                                                                        \
+        for (int i = 0; i < (SAMPLES); i++) {                                    \
+            for (int m = 0; m < (MICS); m++) {                                   \
+                dst[m][i] = in[i * (MICS) + m];                                  \
+            }                                                                    \
+        }                                                                        \
+    }
+
+/**
+ * @brief  Generate `static float name(float *history, float *confidence, int *index,
+ *                                     const float *weights, float angle, float conf)`
+ *
+ *         Average over the last WINDOW angles weighted by the window `weights`
+ *         (`weights[0]` applying to the newest angle) times each angle's
+ *         confidence. `history` and `confidence` hold 2 * WINDOW entries: each
+ *         value is stored twice, WINDOW apart, so the newest WINDOW values are
+ *         always contiguous and no modulo is needed. Entries never written keep
+ *         confidence 0 and do not count.
+ */
+#define AUDIO_DOA_DEFINE_SMOOTHING(name, WINDOW)                                 \
+    static float name(float *history, float *confidence, int *index,             \
+                      const float *weights, float angle, float conf)             \
+    {                                                                            \
+        int pos = *index;                                                        \
+        history[pos] = angle;                                                    \
+        history[pos + (WINDOW)] = angle;                                         \
+        confidence[pos] = conf;                                                  \
+        confidence[pos + (WINDOW)] = conf;                                       \
+        const float *newest = &history[pos + (WINDOW)];                          \
+        const float *newest_conf = &confidence[pos + (WINDOW)];                  \
+        float num = 0.0f;                                                        \
+        float den = 0.0f;                                                        \
+        for (int i = 0; i < (WINDOW); i++) {                                     \
+            float w = weights[i] * newest_conf[-i];                              \
+            num += newest[-i] * w;                                               \
+            den += w;                                                            \
+        }                                                                        \
+        *index = (pos + 1 == (WINDOW)) ? 0 : pos + 1;                            \
+        return num / den;                                                        \
+    }
@@ -0,0 +1,67 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "audio_doa_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  /* __cplusplus */
+
+/**
+ * @brief  Opaque SRP-PHAT engine instance
+ */
+typedef struct audio_doa_srp audio_doa_srp_t;
+
+/**
+ * @brief  Configuration structure for the SRP-PHAT engine
+ */
+typedef struct {
+    int                         sample_rate;     /*!< Sample rate of the planar frames in Hz */
+    int                         frame_samples;   /*!< Samples per channel per frame, must be a power of two */
+    int                         mic_num;         /*!< Number of microphones (2 to AUDIO_DOA_MAX_MICS) */
+    const audio_doa_mic_pos_t  *mic_pos;         /*!< Microphone positions, `mic_num` entries */
+    float                       coarse_step_deg; /*!< Coarse search grid step (0 = default 10 degrees) */
+    float                       fine_step_deg;   /*!< Refinement grid step (0 = default 1 degree).
+                                                      Setting both steps equal gives an exhaustive search */
+    float                       max_freq_hz;     /*!< Upper edge of the analysed band (0 = Nyquist) */
+} audio_doa_srp_cfg_t;
+
+/**
+ * @brief  Create an SRP-PHAT engine
+ *
+ *         The FFT twiddles and the per-pair steering delay table for every fine
+ *         grid angle are computed here, so processing does no trigonometry.
+ *
+ * @param  cfg  Engine configuration
+ * @return
+ *       - Engine instance on success
+ *       - NULL on invalid configuration or allocation failure
+ */
+audio_doa_srp_t *audio_doa_srp_create(const audio_doa_srp_cfg_t *cfg);
+
+/**
+ * @brief  Estimate the direction of arrival of one planar frame
+ *
+ * @param  srp       Engine instance
+ * @param  mic_data  One pointer per microphone to `frame_samples` samples
+ * @return
+ *       - Estimated angle in degrees (0-180)
+ */
+float audio_doa_srp_process(audio_doa_srp_t *srp, int16_t *const *mic_data);
+
+/**
+ * @brief  Destroy an SRP-PHAT engine
+ *
+ * @param  srp  Engine instance (can be NULL)
+ */
+void audio_doa_srp_destroy(audio_doa_srp_t *srp);
+
+#ifdef __cplusplus
+}
+#endif  /* __cplusplus */
@@ -30,8 +30,29 @@ typedef struct {
     void                                *ctx;              /*!< User context pointer */
     uint32_t                            output_interval_ms; /*!< Output interval in milliseconds (0 = output every time buffer is full) */
     float                               min_angle_change_threshold; /*!< Minimum angle change threshold in degrees (default: 15.0f, 0 = disabled) */
+    uint32_t                            max_sample_age_ms;  /*!< Angles older than this are dropped from the buffer (0 = never) */
+    uint32_t                            silence_timeout_ms;  /*!< A feed gap this long resets the state to unknown (0 = never) */
 } audio_doa_tracker_cfg_t;
 
+/**
+ * @brief  Warm-start prior of the DOA tracker
+ */
+typedef struct {
+    bool   valid;         /*!< A stable direction is known */
+    float  angle;         /*!< Last stable output angle in degrees */
+    bool   front_facing;  /*!< Front-facing speech was detected */
+} audio_doa_tracker_prior_t;
+
+/**
+ * @brief  Decision counters of the tracker
+ */
+typedef struct {
+    uint32_t  outputs;   /*!< Results delivered to the callback */
+    uint32_t  rejected;  /*!< Angles refused as implausible */
+    uint32_t  held;      /*!< Due outputs withheld: jump too large, change too small or 90 degrees unconfirmed */
+    uint32_t  resets;    /*!< State restarts after silence or a major angle change */
+} audio_doa_tracker_stats_t;
+
 /**
  * @brief  Handle type for DOA tracker
  */
@@ -53,6 +74,8 @@ esp_err_t audio_doa_tracker_init(audio_doa_tracker_cfg_t *cfg, audio_doa_tracker
 /**
  * @brief  Feed DOA angle value to the tracker
  *
+ *         Same as audio_doa_tracker_feed_at() with the tick count as audio time.
+ *
  * @param[in]  handle  DOA tracker handle
  * @param[in]  angle   DOA angle value to feed
  *
@@ -62,6 +85,26 @@ esp_err_t audio_doa_tracker_init(audio_doa_tracker_cfg_t *cfg, audio_doa_tracker
  */
 esp_err_t audio_doa_tracker_feed(audio_doa_tracker_handle_t handle, float angle);
 
+/**
+ * @brief  Feed a DOA angle together with the audio time it was measured at
+ *
+ *         The velocity is computed over these times, so it stays right when frames are
+ *         processed in bursts (batched or synchronous processing), where the tick count
+ *         barely moves between feeds. Sample ages, the silence timeout, the output
+ *         interval and the 90 degree hold time follow these times as well, so the gap
+ *         between two feeds counts as silence only when the audio between them was not
+ *         fed.
+ *
+ * @param[in]  handle    DOA tracker handle
+ * @param[in]  angle     DOA angle value to feed
+ * @param[in]  audio_ms  Audio time of the angle in milliseconds, e.g. the end of its frame (may wrap)
+ *
+ * @return
+ *       - ESP_OK               Success
+ *       - ESP_ERR_INVALID_ARG  Invalid argument
+ */
+esp_err_t audio_doa_tracker_feed_at(audio_doa_tracker_handle_t handle, float angle, uint32_t audio_ms);
+
 /**
  * @brief  Enable or disable the DOA tracker
  *
@@ -77,6 +120,70 @@ esp_err_t audio_doa_tracker_feed(audio_doa_tracker_handle_t handle, float angle)
  */
 esp_err_t audio_doa_tracker_enable(audio_doa_tracker_handle_t handle, bool enable);
 
+/**
+ * @brief  Get the tracker's current prior
+ *
+ *         The last stable output and front-facing mode, or the prior set earlier
+ *         if nothing has been output since. Only reads the state, and like the other
+ *         calls may run while another task feeds the tracker.
+ *
+ * @param[in]   handle  DOA tracker handle
+ * @param[out]  prior   Current prior
+ *
+ * @return
+ *       - ESP_OK               Success
+ *       - ESP_ERR_INVALID_ARG  Invalid argument
+ */
+esp_err_t audio_doa_tracker_get_prior(audio_doa_tracker_handle_t handle, audio_doa_tracker_prior_t *prior);
+
+/**
+ * @brief  Set the prior the tracker starts from
+ *
+ *         Applied now if nothing has been output yet, and on every enable. The first
+ *         output then needs only two samples agreeing with the prior instead of a full
+ *         buffer; the tracker falls back to a full buffer if they disagree. The state is
+ *         locked against a concurrent feed.
+ *
+ * @param[in]  handle  DOA tracker handle
+ * @param[in]  prior   Prior to start from
+ *
+ * @return
+ *       - ESP_OK               Success
+ *       - ESP_ERR_INVALID_ARG  Invalid argument or angle out of 0-180
+ */
+esp_err_t audio_doa_tracker_set_prior(audio_doa_tracker_handle_t handle, const audio_doa_tracker_prior_t *prior);
+
+/**
+ * @brief  Get the tracker's decision counters
+ *
+ *         Plain reads of counters only the feeding task writes, safe to call from any task.
+ *
+ * @param[in]   handle  DOA tracker handle
+ * @param[out]  stats   Counters since init
+ *
+ * @return
+ *       - ESP_OK               Success
+ *       - ESP_ERR_INVALID_ARG  Invalid argument
+ */
+esp_err_t audio_doa_tracker_get_stats(audio_doa_tracker_handle_t handle, audio_doa_tracker_stats_t *stats);
+
+/**
+ * @brief  Get how fast the tracked direction is moving
+ *
+ *         Least-squares slope of the buffered angles over their audio times (see
+ *         audio_doa_tracker_feed_at()), so it reflects the last CONFIG_AUDIO_DOA_TRACKER_WINDOW
+ *         accepted angles. Call from the feeding task.
+ *
+ * @param[in]   handle      DOA tracker handle
+ * @param[out]  deg_per_s   Absolute angular velocity in degrees per second
+ *
+ * @return
+ *       - ESP_OK               Success
+ *       - ESP_ERR_INVALID_ARG  Invalid argument
+ *       - ESP_ERR_NOT_FOUND    Fewer than three angles buffered, or all at the same audio time
+ */
+esp_err_t audio_doa_tracker_get_velocity(audio_doa_tracker_handle_t handle, float *deg_per_s);
+
 /**
  * @brief  Deinitialize the DOA tracker
  *
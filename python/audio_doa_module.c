@@ -0,0 +1,547 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Python binding of the synchronous processing path (audio_doa_app_process()).
+ *
+ * Audio comes in through the buffer protocol: int16 samples are read in place, float
+ * samples are converted one frame at a time into a scratch buffer, so no copy of the
+ * input is ever made. Angles are written straight into NumPy arrays. The GIL is released
+ * while frames are processed, instances on different threads run in parallel.
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "sdkconfig.h"
+#include "audio_doa_app.h"
+#include "audio_doa_host.h"
+
+#define FRAME_SAMPLES  CONFIG_AUDIO_DOA_FRAME_SAMPLES
+#define SAMPLE_RATE    16000
+
+typedef enum {
+    SAMPLE_INT16,
+    SAMPLE_FLOAT32,
+    SAMPLE_FLOAT64,
+} sample_format_t;
+
+typedef struct {
+    PyObject_HEAD
+    audio_doa_app_handle_t  app;
+    int                     mic_num;
+    uint64_t                frames;           /*!< Frames processed since creation */
+    int16_t                *pending;          /*!< Partial frame carried over to the next call */
+    int                     pending_samples;  /*!< Per-channel samples in `pending` */
+    int16_t                *scratch;          /*!< One frame converted from float input */
+    float                   frame_angle;
+    bool                    frame_has_angle;
+    int64_t                *result_frames;    /*!< Tracker outputs of the current call */
+    float                  *result_angles;
+    size_t                  result_num;
+    size_t                  result_cap;
+    bool                    result_no_mem;
+    bool                    busy;
+} DoaObject;
+
+static PyObject *s_numpy_empty;
+
+static void doa_monitor_callback(float angle, void *ctx)
+{
+    DoaObject *self = (DoaObject *)ctx;
+    self->frame_angle = angle;
+    self->frame_has_angle = true;
+}
+
+static void doa_result_callback(float angle, void *ctx)
+{
+    DoaObject *self = (DoaObject *)ctx;
+    if (self->result_num == self->result_cap) {
+        size_t cap = self->result_cap ? self->result_cap * 2 : 64;
+        int64_t *frames = (int64_t *)realloc(self->result_frames, cap * sizeof(int64_t));
+        if (frames != NULL) {
+            self->result_frames = frames;
+        }
+        float *angles = (float *)realloc(self->result_angles, cap * sizeof(float));
+        if (angles != NULL) {
+            self->result_angles = angles;
+        }
+        if (frames == NULL || angles == NULL) {
+            self->result_no_mem = true;
+            return;
+        }
+        self->result_cap = cap;
+    }
+    self->result_frames[self->result_num] = (int64_t)self->frames;
+    self->result_angles[self->result_num] = angle;
+    self->result_num++;
+}
+
+static int doa_parse_engine(const char *name, audio_doa_engine_t *engine)
+{
+    if (strcmp(name, "srp_phat") == 0) {
+        *engine = AUDIO_DOA_ENGINE_SRP_PHAT;
+    } else if (strcmp(name, "one_bit") == 0) {
+        *engine = AUDIO_DOA_ENGINE_ONE_BIT;
+    } else if (strcmp(name, "esp_sr") == 0) {
+        PyErr_SetString(PyExc_ValueError, "engine 'esp_sr' needs esp-sr and is only available on target");
+        return -1;
+    } else {
+        PyErr_Format(PyExc_ValueError, "unknown engine '%s', expected 'srp_phat' or 'one_bit'", name);
+        return -1;
+    }
+    return 0;
+}
+
+static int doa_parse_mic_pos(PyObject *seq, audio_doa_mic_pos_t *mic_pos, int mic_num)
+{
+    PyObject *fast = PySequence_Fast(seq, "mic_pos must be a sequence of (x, y) pairs");
+    if (fast == NULL) {
+        return -1;
+    }
+    if (PySequence_Fast_GET_SIZE(fast) != mic_num) {
+        Py_DECREF(fast);
+        PyErr_Format(PyExc_ValueError, "mic_pos needs %d entries", mic_num);
+        return -1;
+    }
+    for (int i = 0; i < mic_num; i++) {
+        if (!PyArg_ParseTuple(PySequence_Fast_GET_ITEM(fast, i), "ff", &mic_pos[i].x, &mic_pos[i].y)) {
+            Py_DECREF(fast);
+            return -1;
+        }
+    }
+    Py_DECREF(fast);
+    return 0;
+}
+
+static int Doa_init(DoaObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *kwlist[] = {"mic_num", "engine", "distance", "mic_pos", "decimate", "gate_rms", "smoothing",
+                             "tracker_max_age_ms", "tracker_silence_timeout_ms", "stage_timing", "adaptive_window",
+                             "window_moving_dps", "window_still_dps", NULL};
+    int mic_num = 2;
+    const char *engine_name = "srp_phat";
+    float distance = 0.0f;
+    PyObject *mic_pos = Py_None;
+    int decimate = 0;
+    float gate_rms = 0.0f;
+    int smoothing = 1;
+    unsigned int tracker_max_age_ms = 0;
+    unsigned int tracker_silence_timeout_ms = 0;
+    int stage_timing = 0;
+    int adaptive_window = 0;
+    float window_moving_dps = 0.0f;
+    float window_still_dps = 0.0f;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|$isfOpfpIIppff", kwlist, &mic_num, &engine_name, &distance,
+                                     &mic_pos, &decimate, &gate_rms, &smoothing, &tracker_max_age_ms,
+                                     &tracker_silence_timeout_ms, &stage_timing, &adaptive_window,
+                                     &window_moving_dps, &window_still_dps)) {
+        return -1;
+    }
+    if (self->app != NULL) {
+        PyErr_SetString(PyExc_RuntimeError, "Doa is already initialized");
+        return -1;
+    }
+    if (mic_num < 2 || mic_num > AUDIO_DOA_MAX_MICS) {
+        PyErr_Format(PyExc_ValueError, "mic_num must be between 2 and %d", AUDIO_DOA_MAX_MICS);
+        return -1;
+    }
+    audio_doa_app_config_t config = {
+        .distance = distance,
+        .decimate = decimate,
+        .mic_num = mic_num,
+        .gate_rms = gate_rms,
+        .disable_smoothing = !smoothing,
+        .stage_timing = stage_timing,
+        .tracker_max_age_ms = tracker_max_age_ms,
+        .tracker_silence_timeout_ms = tracker_silence_timeout_ms,
+        .adaptive_window = adaptive_window,
+        .window_moving_dps = window_moving_dps,
+        .window_still_dps = window_still_dps,
+        .synchronous = true,
+        .audio_doa_monitor_callback = doa_monitor_callback,
+        .audio_doa_monitor_callback_ctx = self,
+        .audio_doa_result_callback = doa_result_callback,
+        .audio_doa_result_callback_ctx = self,
+    };
+    if (doa_parse_engine(engine_name, &config.engine) < 0) {
+        return -1;
+    }
+    if (mic_pos != Py_None && doa_parse_mic_pos(mic_pos, config.mic_pos, mic_num) < 0) {
+        return -1;
+    }
+    self->mic_num = mic_num;
+    PyMem_RawFree(self->pending);
+    PyMem_RawFree(self->scratch);
+    self->pending = (int16_t *)PyMem_RawCalloc(FRAME_SAMPLES * mic_num, sizeof(int16_t));
+    self->scratch = (int16_t *)PyMem_RawCalloc(FRAME_SAMPLES * mic_num, sizeof(int16_t));
+    if (self->pending == NULL || self->scratch == NULL) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    audio_doa_app_handle_t app = NULL;
+    esp_err_t ret = audio_doa_app_create(&app, &config);
+    if (ret != ESP_OK) {
+        if (app != NULL) {
+            audio_doa_app_destroy(app);
+        }
+        PyMem_RawFree(self->pending);
+        PyMem_RawFree(self->scratch);
+        self->pending = NULL;
+        self->scratch = NULL;
+        PyErr_Format(PyExc_RuntimeError, "audio_doa_app_create failed: %s", esp_err_to_name(ret));
+        return -1;
+    }
+    self->app = app;
+    return 0;
+}
+
+static void Doa_dealloc(DoaObject *self)
+{
+    if (self->app != NULL) {
+        audio_doa_app_destroy(self->app);
+    }
+    PyMem_RawFree(self->pending);
+    PyMem_RawFree(self->scratch);
+    free(self->result_frames);
+    free(self->result_angles);
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+static int doa_parse_format(const Py_buffer *view, sample_format_t *format)
+{
+    const char *fmt = view->format ? view->format : "B";
+    if (*fmt == '@' || *fmt == '=' || *fmt == '<') {
+        fmt++;
+    }
+    if (strcmp(fmt, "h") == 0 && view->itemsize == 2) {
+        *format = SAMPLE_INT16;
+    } else if (strcmp(fmt, "f") == 0 && view->itemsize == 4) {
+        *format = SAMPLE_FLOAT32;
+    } else if (strcmp(fmt, "d") == 0 && view->itemsize == 8) {
+        *format = SAMPLE_FLOAT64;
+    } else {
+        PyErr_Format(PyExc_TypeError, "samples must be int16, float32 or float64, not format '%s'", view->format);
+        return -1;
+    }
+    return 0;
+}
+
+static inline int16_t doa_float_to_int16(double value)
+{
+    double scaled = value * 32768.0;
+    if (scaled >= 32767.0) {
+        return 32767;
+    }
+    if (scaled <= -32768.0) {
+        return -32768;
+    }
+    return (int16_t)lrint(scaled);
+}
+
+/**
+ * @brief  Copy `count` interleaved samples to `out`, converting float input to full-scale int16
+ */
+static void doa_convert(int16_t *out, const void *in, size_t offset, size_t count, sample_format_t format)
+{
+    switch (format) {
+    case SAMPLE_INT16:
+        memcpy(out, (const int16_t *)in + offset, count * sizeof(int16_t));
+        break;
+    case SAMPLE_FLOAT32:
+        for (size_t i = 0; i < count; i++) {
+            out[i] = doa_float_to_int16(((const float *)in)[offset + i]);
+        }
+        break;
+    case SAMPLE_FLOAT64:
+        for (size_t i = 0; i < count; i++) {
+            out[i] = doa_float_to_int16(((const double *)in)[offset + i]);
+        }
+        break;
+    }
+}
+
+/**
+ * @brief  Run one frame with the tracker clock at the frame's end, GIL released
+ */
+static esp_err_t doa_run_frame(DoaObject *self, const int16_t *frame, float *angle)
+{
+    audio_doa_host_set_audio_time_ms((uint32_t)((self->frames + 1) * FRAME_SAMPLES * 1000 / SAMPLE_RATE));
+    self->frame_has_angle = false;
+    esp_err_t ret = audio_doa_app_process(self->app, frame, 1);
+    // Frames stopped by the gating stage have no angle
+    *angle = self->frame_has_angle ? self->frame_angle : NAN;
+    self->frames++;
+    return ret;
+}
+
+static esp_err_t doa_process(DoaObject *self, const void *data, size_t samples, sample_format_t format, float *angles)
+{
+    size_t frame_items = (size_t)FRAME_SAMPLES * self->mic_num;
+    size_t pos = 0;
+    int out = 0;
+    esp_err_t ret = ESP_OK;
+    if (self->pending_samples > 0) {
+        size_t take = FRAME_SAMPLES - self->pending_samples;
+        if (take > samples) {
+            take = samples;
+        }
+        doa_convert(self->pending + (size_t)self->pending_samples * self->mic_num, data, 0, take * self->mic_num, format);
+        self->pending_samples += (int)take;
+        pos = take;
+        if (self->pending_samples < FRAME_SAMPLES) {
+            return ESP_OK;
+        }
+        self->pending_samples = 0;
+        ret = doa_run_frame(self, self->pending, &angles[out++]);
+    }
+    while (ret == ESP_OK && samples - pos >= FRAME_SAMPLES) {
+        const int16_t *frame = self->scratch;
+        if (format == SAMPLE_INT16) {
+            frame = (const int16_t *)data + pos * self->mic_num;
+        } else {
+            doa_convert(self->scratch, data, pos * self->mic_num, frame_items, format);
+        }
+        ret = doa_run_frame(self, frame, &angles[out++]);
+        pos += FRAME_SAMPLES;
+    }
+    if (ret == ESP_OK && pos < samples) {
+        doa_convert(self->pending, data, pos * self->mic_num, (samples - pos) * self->mic_num, format);
+        self->pending_samples = (int)(samples - pos);
+    }
+    return ret;
+}
+
+static PyObject *doa_new_array(Py_ssize_t length, const char *dtype, Py_buffer *view)
+{
+    PyObject *array = PyObject_CallFunction(s_numpy_empty, "ns", length, dtype);
+    if (array == NULL) {
+        return NULL;
+    }
+    if (PyObject_GetBuffer(array, view, PyBUF_C_CONTIGUOUS | PyBUF_WRITABLE) < 0) {
+        Py_DECREF(array);
+        return NULL;
+    }
+    return array;
+}
+
+PyDoc_STRVAR(Doa_process_doc,
+"process(samples) -> (angles, result_frames, result_angles)\n"
+"\n"
+"Run audio through the pipeline. `samples` is any C-contiguous buffer of int16,\n"
+"float32 or float64 samples, shaped (n, mic_num) or flat and interleaved. Float\n"
+"samples are full scale at 1.0. A partial frame at the end is kept for the next call.\n"
+"\n"
+"Returns a float32 array with one angle per completed frame (NaN for gated frames),\n"
+"and the tracker outputs of this call: their frame numbers (int64, counted since\n"
+"the instance was created) and angles (float32).");
+
+static PyObject *doa_process_buffer(DoaObject *self, PyObject *arg)
+{
+    Py_buffer input;
+    if (PyObject_GetBuffer(arg, &input, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) < 0) {
+        return NULL;
+    }
+    sample_format_t format;
+    size_t items = input.itemsize ? (size_t)(input.len / input.itemsize) : 0;
+    if (doa_parse_format(&input, &format) < 0) {
+        PyBuffer_Release(&input);
+        return NULL;
+    }
+    if ((input.ndim == 2 && input.shape[1] != self->mic_num) || input.ndim > 2 || items % self->mic_num != 0) {
+        PyBuffer_Release(&input);
+        PyErr_Format(PyExc_ValueError, "samples must be shaped (n, %d) or flat with a multiple of %d values",
+                     self->mic_num, self->mic_num);
+        return NULL;
+    }
+    size_t samples = items / self->mic_num;
+    Py_ssize_t frames = (Py_ssize_t)((self->pending_samples + samples) / FRAME_SAMPLES);
+    Py_buffer angles_view;
+    PyObject *angles = doa_new_array(frames, "float32", &angles_view);
+    if (angles == NULL) {
+        PyBuffer_Release(&input);
+        return NULL;
+    }
+
+    self->result_num = 0;
+    self->result_no_mem = false;
+    esp_err_t ret;
+    Py_BEGIN_ALLOW_THREADS
+    ret = doa_process(self, input.buf, samples, format, (float *)angles_view.buf);
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&angles_view);
+    PyBuffer_Release(&input);
+
+    if (ret != ESP_OK || self->result_no_mem) {
+        Py_DECREF(angles);
+        if (ret != ESP_OK) {
+            PyErr_Format(PyExc_RuntimeError, "audio_doa_app_process failed: %s", esp_err_to_name(ret));
+        } else {
+            PyErr_NoMemory();
+        }
+        return NULL;
+    }
+    Py_buffer frames_view;
+    Py_buffer results_view;
+    PyObject *result_frames = doa_new_array((Py_ssize_t)self->result_num, "int64", &frames_view);
+    PyObject *result_angles = result_frames ? doa_new_array((Py_ssize_t)self->result_num, "float32", &results_view) : NULL;
+    if (result_angles == NULL) {
+        if (result_frames != NULL) {
+            PyBuffer_Release(&frames_view);
+            Py_DECREF(result_frames);
+        }
+        Py_DECREF(angles);
+        return NULL;
+    }
+    memcpy(frames_view.buf, self->result_frames, self->result_num * sizeof(int64_t));
+    memcpy(results_view.buf, self->result_angles, self->result_num * sizeof(float));
+    PyBuffer_Release(&frames_view);
+    PyBuffer_Release(&results_view);
+    return Py_BuildValue("(NNN)", angles, result_frames, result_angles);
+}
+
+static PyObject *Doa_process(DoaObject *self, PyObject *arg)
+{
+    if (self->app == NULL) {
+        PyErr_SetString(PyExc_RuntimeError, "Doa is not initialized");
+        return NULL;
+    }
+    // Checked and set under the GIL, which numpy may drop before processing starts
+    if (self->busy) {
+        PyErr_SetString(PyExc_RuntimeError, "Doa is being used by another thread");
+        return NULL;
+    }
+    self->busy = true;
+    PyObject *result = doa_process_buffer(self, arg);
+    self->busy = false;
+    return result;
+}
+
+PyDoc_STRVAR(Doa_stats_doc,
+"stats() -> dict\n"
+"\n"
+"Runtime counters of the instance (audio_doa_stats_t). Stage timing is host CPU time.");
+
+static PyObject *Doa_stats(DoaObject *self, PyObject *Py_UNUSED(ignored))
+{
+    if (self->app == NULL) {
+        PyErr_SetString(PyExc_RuntimeError, "Doa is not initialized");
+        return NULL;
+    }
+    audio_doa_stats_t stats;
+    esp_err_t ret = audio_doa_app_get_stats(self->app, &stats);
+    if (ret != ESP_OK) {
+        PyErr_Format(PyExc_RuntimeError, "audio_doa_app_get_stats failed: %s", esp_err_to_name(ret));
+        return NULL;
+    }
+    PyObject *hist = PyTuple_New(AUDIO_DOA_FRAME_TIME_BUCKETS);
+    if (hist == NULL) {
+        return NULL;
+    }
+    for (int i = 0; i < AUDIO_DOA_FRAME_TIME_BUCKETS; i++) {
+        PyTuple_SET_ITEM(hist, i, PyLong_FromUnsignedLong(stats.frame_time_hist[i]));
+    }
+    static const char *const window_names[AUDIO_DOA_WINDOW_NUM] = {"short", "frame", "long"};
+    PyObject *windows = PyDict_New();
+    if (windows == NULL) {
+        Py_DECREF(hist);
+        return NULL;
+    }
+    for (int i = 0; i < AUDIO_DOA_WINDOW_NUM; i++) {
+        const audio_doa_window_stats_t *window = &stats.windows[i];
+        PyObject *item = Py_BuildValue("{sIsIsIsI}", "samples", window->samples, "latency_ms", window->latency_ms,
+                                       "frames", window->frames, "engine_us", window->engine_us);
+        if (item == NULL || PyDict_SetItemString(windows, window_names[i], item) < 0) {
+            Py_XDECREF(item);
+            Py_DECREF(windows);
+            Py_DECREF(hist);
+            return NULL;
+        }
+        Py_DECREF(item);
+    }
+    return Py_BuildValue("{sIsIsfsIsIsIsIsIsIsIsNsKsNsI}",
+                         "frames_processed", stats.frames_processed,
+                         "frames_gated", stats.frames_gated,
+                         "noise_floor_rms", stats.noise_floor_rms,
+                         "primary_chain_us", stats.primary_chain_us,
+                         "tracker_outputs", stats.tracker_outputs,
+                         "tracker_rejected", stats.tracker_rejected,
+                         "tracker_held", stats.tracker_held,
+                         "tracker_resets", stats.tracker_resets,
+                         "deadline_misses", stats.deadline_misses,
+                         "deadline_worst_overrun_us", stats.deadline_worst_overrun_us,
+                         "frame_time_hist", hist,
+                         "frame_time_sum_us", (unsigned long long)stats.frame_time_sum_us,
+                         "windows", windows,
+                         "window_switches", stats.window_switches);
+}
+
+static PyMethodDef Doa_methods[] = {
+    {"process", (PyCFunction)Doa_process, METH_O, Doa_process_doc},
+    {"stats", (PyCFunction)Doa_stats, METH_NOARGS, Doa_stats_doc},
+    {NULL, NULL, 0, NULL},
+};
+
+PyDoc_STRVAR(Doa_doc,
+"Doa(*, mic_num=2, engine='srp_phat', distance=0.0, mic_pos=None, decimate=False,\n"
+"    gate_rms=0.0, smoothing=True, tracker_max_age_ms=0, tracker_silence_timeout_ms=0,\n"
+"    stage_timing=False, adaptive_window=False, window_moving_dps=0.0,\n"
+"    window_still_dps=0.0)\n"
+"\n"
+"One synchronous DOA instance with tracker, fed by process(). The arguments match\n"
+"audio_doa_app_config_t; 0 selects the component default. Audio is 16 kHz.\n"
+"An instance keeps stream state and must be used by one thread at a time.");
+
+static PyTypeObject DoaType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "audio_doa.Doa",
+    .tp_doc = Doa_doc,
+    .tp_basicsize = sizeof(DoaObject),
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_new = PyType_GenericNew,
+    .tp_init = (initproc)Doa_init,
+    .tp_dealloc = (destructor)Doa_dealloc,
+    .tp_methods = Doa_methods,
+};
+
+static struct PyModuleDef audio_doa_module = {
+    PyModuleDef_HEAD_INIT,
+    .m_name = "audio_doa",
+    .m_doc = "Host binding of the audio_doa synchronous processing path",
+    .m_size = -1,
+};
+
+PyMODINIT_FUNC PyInit_audio_doa(void)
+{
+    if (PyType_Ready(&DoaType) < 0) {
+        return NULL;
+    }
+    PyObject *numpy = PyImport_ImportModule("numpy");
+    if (numpy == NULL) {
+        return NULL;
+    }
+    s_numpy_empty = PyObject_GetAttrString(numpy, "empty");
+    Py_DECREF(numpy);
+    if (s_numpy_empty == NULL) {
+        return NULL;
+    }
+    PyObject *module = PyModule_Create(&audio_doa_module);
+    if (module == NULL) {
+        return NULL;
+    }
+    Py_INCREF(&DoaType);
+    if (PyModule_AddObject(module, "Doa", (PyObject *)&DoaType) < 0 ||
+        PyModule_AddIntConstant(module, "FRAME_SAMPLES", FRAME_SAMPLES) < 0 ||
+        PyModule_AddIntConstant(module, "SAMPLE_RATE", SAMPLE_RATE) < 0) {
+        Py_DECREF(&DoaType);
+        Py_DECREF(module);
+        return NULL;
+    }
+    return module;
+}
@@ -0,0 +1,610 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * ESP-IDF and FreeRTOS services used by the component, implemented for the host.
+ *
+ * Tasks are POSIX threads, so asynchronous instances, the soak runner and the services
+ * run as on a target. Every blocking call polls its condition with a short sleep, which
+ * keeps the port small and makes those sleeps the only points where vTaskDelete() can
+ * cancel a task. A target runs the DOA task on one core above the writer's priority: a
+ * write that satisfies it is processed before the write returns. The port reproduces
+ * that hand-over, the writer waits until the woken higher priority task blocks again,
+ * so writer-side ordering bugs show up on the host instead of only under load.
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <time.h>
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+#include <malloc.h>
+#define HOST_HAS_MALLINFO2 1
+#endif
+#include "esp_err.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_cpu.h"
+#include "esp_rom_crc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include "freertos/stream_buffer.h"
+#include "audio_doa_host.h"
+
+#define HOST_POLL_NS     100000   /* Poll period of blocking calls */
+#define HOST_HANDOVER_US 100000   /* Longest wait for a woken task to block again */
+#define HOST_HEAP_SIZE   (256u * 1024 * 1024)  /* Notional heap, free size is this minus the bytes in use */
+
+typedef struct {
+    pthread_t       thread;
+    TaskFunction_t  fn;
+    void           *arg;
+    UBaseType_t     priority;
+    atomic_uint     notify;          /*!< Notification count */
+    atomic_uint     blocks;          /*!< Incremented every time the task blocks */
+    atomic_bool     blocked;
+    atomic_bool     notify_waiting;  /*!< Blocked in ulTaskNotifyTake() */
+} host_task_t;
+
+/**
+ * Counting semaphore, a mutex is one with a single initially available count
+ */
+typedef struct {
+    pthread_mutex_t  mutex;
+    unsigned         count;
+    unsigned         max;
+} host_sem_t;
+
+typedef struct {
+    pthread_mutex_t  mutex;
+    uint8_t         *data;
+    size_t           size;
+    size_t           head;           /*!< Read position */
+    size_t           count;          /*!< Bytes stored */
+    size_t           trigger;
+    host_task_t     *receiver;       /*!< Task waiting in receive, NULL if none */
+    size_t           wanted;         /*!< Bytes that wake the receiver */
+} host_stream_t;
+
+typedef struct {
+    atomic_uint  *bits;
+    EventBits_t   wait;
+    EventBits_t   seen;
+    bool          clear;
+    bool          all;
+} host_event_wait_t;
+
+static _Thread_local TickType_t s_audio_tick;
+static _Thread_local bool s_audio_tick_set;
+static _Thread_local host_task_t *s_current_task;
+
+void audio_doa_host_set_audio_time_ms(uint32_t time_ms)
+{
+    s_audio_tick = (TickType_t)time_ms;
+    s_audio_tick_set = true;
+}
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+    case ESP_OK:
+        return "ESP_OK";
+    case ESP_FAIL:
+        return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:
+        return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:
+        return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:
+        return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE:
+        return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND:
+        return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED:
+        return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT:
+        return "ESP_ERR_TIMEOUT";
+    case ESP_ERR_INVALID_CRC:
+        return "ESP_ERR_INVALID_CRC";
+    case ESP_ERR_INVALID_VERSION:
+        return "ESP_ERR_INVALID_VERSION";
+    default:
+        return "UNKNOWN ERROR";
+    }
+}
+
+int64_t esp_timer_get_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/*
+ * Only differences of the free size are meaningful (instance heap, benchmark peak, soak
+ * leak check). mallinfo2() covers the main arena, where the creating thread allocates
+ * the instances; without glibc 2.33 the free size stays 0 and those figures read 0.
+ */
+size_t heap_caps_get_free_size(uint32_t caps)
+{
+    (void)caps;
+#if HOST_HAS_MALLINFO2
+    struct mallinfo2 info = mallinfo2();
+    return HOST_HEAP_SIZE - (info.uordblks + info.hblkhd);
+#else
+    return 0;
+#endif  /* HOST_HAS_MALLINFO2 */
+}
+
+esp_cpu_cycle_count_t esp_cpu_get_cycle_count(void)
+{
+    // Nanoseconds stand in for cycles, only differences are used
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (esp_cpu_cycle_count_t)((uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec);
+}
+
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len)
+{
+    crc = ~crc;
+    for (uint32_t i = 0; i < len; i++) {
+        crc ^= buf[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & -(crc & 1u));
+        }
+    }
+    return ~crc;
+}
+
+static void host_sleep_ns(long ns)
+{
+    // Tasks only accept cancellation here, never while holding a lock
+    struct timespec ts = {.tv_sec = ns / 1000000000L, .tv_nsec = ns % 1000000000L};
+    int state;
+    pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, &state);
+    nanosleep(&ts, NULL);
+    pthread_setcancelstate(state, NULL);
+}
+
+static UBaseType_t host_current_priority(void)
+{
+    return s_current_task != NULL ? s_current_task->priority : 0;
+}
+
+/**
+ * Poll `attempt` until it succeeds or `ticks` pass, `attempt` performs the operation
+ * atomically when it succeeds
+ */
+static bool host_wait(bool (*attempt)(void *arg), void *arg, TickType_t ticks)
+{
+    if (attempt(arg)) {
+        return true;
+    }
+    if (ticks == 0) {
+        return false;
+    }
+    int64_t deadline = ticks == portMAX_DELAY ? INT64_MAX :
+                       esp_timer_get_time() + (int64_t)ticks * portTICK_PERIOD_MS * 1000;
+    if (s_current_task != NULL) {
+        atomic_fetch_add(&s_current_task->blocks, 1);
+        atomic_store(&s_current_task->blocked, true);
+    }
+    bool done = false;
+    while (!(done = attempt(arg)) && esp_timer_get_time() < deadline) {
+        host_sleep_ns(HOST_POLL_NS);
+    }
+    if (s_current_task != NULL) {
+        atomic_store(&s_current_task->blocked, false);
+    }
+    return done;
+}
+
+/**
+ * Let a woken higher priority task run until it blocks again, as it would preempt the
+ * caller on a single core. `blocks` is the task's block count read while it was blocked.
+ */
+static void host_hand_over(host_task_t *task, unsigned blocks)
+{
+    if (task == NULL || task == s_current_task || task->priority <= host_current_priority()) {
+        return;
+    }
+    int64_t deadline = esp_timer_get_time() + HOST_HANDOVER_US;
+    while (atomic_load(&task->blocks) == blocks && esp_timer_get_time() < deadline) {
+        host_sleep_ns(HOST_POLL_NS);
+    }
+}
+
+static void *host_task_entry(void *arg)
+{
+    host_task_t *task = (host_task_t *)arg;
+    s_current_task = task;
+    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+    task->fn(task->arg);
+    // FreeRTOS tasks must not return, treat it as deleting itself
+    vTaskDelete(NULL);
+    return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_size, void *arg,
+                       UBaseType_t priority, TaskHandle_t *handle)
+{
+    (void)name;
+    (void)stack_size;
+    host_task_t *task = (host_task_t *)calloc(1, sizeof(host_task_t));
+    if (task == NULL) {
+        return pdFAIL;
+    }
+    task->fn = fn;
+    task->arg = arg;
+    task->priority = priority;
+    atomic_init(&task->notify, 0);
+    atomic_init(&task->blocks, 0);
+    atomic_init(&task->blocked, false);
+    atomic_init(&task->notify_waiting, false);
+    // The handle is visible before the task runs, as on FreeRTOS
+    if (handle != NULL) {
+        *handle = (TaskHandle_t)task;
+    }
+    if (pthread_create(&task->thread, NULL, host_task_entry, task) != 0) {
+        if (handle != NULL) {
+            *handle = NULL;
+        }
+        free(task);
+        return pdFAIL;
+    }
+    return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_size, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *handle, BaseType_t core_id)
+{
+    (void)core_id;
+    return xTaskCreate(fn, name, stack_size, arg, priority, handle);
+}
+
+void vTaskDelete(TaskHandle_t handle)
+{
+    host_task_t *task = handle != NULL ? (host_task_t *)handle : s_current_task;
+    if (task == NULL) {
+        return;
+    }
+    if (task == s_current_task) {
+        pthread_detach(task->thread);
+        free(task);
+        s_current_task = NULL;
+        pthread_exit(NULL);
+    }
+    pthread_cancel(task->thread);
+    pthread_join(task->thread, NULL);
+    free(task);
+}
+
+static bool host_never(void *arg)
+{
+    (void)arg;
+    return false;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    host_wait(host_never, NULL, ticks);
+}
+
+void vTaskSuspend(TaskHandle_t handle)
+{
+    (void)handle;
+    host_wait(host_never, NULL, portMAX_DELAY);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    if (s_audio_tick_set) {
+        return s_audio_tick;
+    }
+    return (TickType_t)(esp_timer_get_time() / 1000 / portTICK_PERIOD_MS);
+}
+
+typedef struct {
+    host_task_t  *task;
+    bool          clear;
+    uint32_t      value;
+} host_notify_wait_t;
+
+static bool host_notify_attempt(void *arg)
+{
+    host_notify_wait_t *w = (host_notify_wait_t *)arg;
+    unsigned count = atomic_load(&w->task->notify);
+    while (count > 0) {
+        if (atomic_compare_exchange_weak(&w->task->notify, &count, w->clear ? 0 : count - 1)) {
+            w->value = count;
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks)
+{
+    if (s_current_task == NULL) {
+        return 0;
+    }
+    host_notify_wait_t w = {.task = s_current_task, .clear = clear_on_exit != pdFALSE};
+    atomic_store(&s_current_task->notify_waiting, true);
+    host_wait(host_notify_attempt, &w, ticks);
+    atomic_store(&s_current_task->notify_waiting, false);
+    return w.value;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t handle)
+{
+    host_task_t *task = (host_task_t *)handle;
+    unsigned blocks = atomic_load(&task->blocks);
+    bool waiting = atomic_load(&task->notify_waiting) && atomic_load(&task->blocked);
+    atomic_fetch_add(&task->notify, 1);
+    if (waiting) {
+        host_hand_over(task, blocks);
+    }
+    return pdPASS;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t handle)
+{
+    (void)handle;
+    return 0;
+}
+
+BaseType_t xPortGetCoreID(void)
+{
+    return 0;
+}
+
+/* Not a cancellation point, a task is never deleted while it holds a mux */
+void vPortEnterCritical(portMUX_TYPE *mux)
+{
+    while (__atomic_exchange_n(&mux->locked, 1, __ATOMIC_ACQUIRE)) {
+        sched_yield();
+    }
+}
+
+void vPortExitCritical(portMUX_TYPE *mux)
+{
+    __atomic_store_n(&mux->locked, 0, __ATOMIC_RELEASE);
+}
+
+static host_sem_t *host_sem_create(unsigned count, unsigned max)
+{
+    host_sem_t *sem = (host_sem_t *)calloc(1, sizeof(host_sem_t));
+    if (sem == NULL) {
+        return NULL;
+    }
+    pthread_mutex_init(&sem->mutex, NULL);
+    sem->count = count;
+    sem->max = max;
+    return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return (SemaphoreHandle_t)host_sem_create(0, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return (SemaphoreHandle_t)host_sem_create(1, 1);
+}
+
+static bool host_sem_attempt(void *arg)
+{
+    host_sem_t *sem = (host_sem_t *)arg;
+    pthread_mutex_lock(&sem->mutex);
+    bool taken = sem->count > 0;
+    if (taken) {
+        sem->count--;
+    }
+    pthread_mutex_unlock(&sem->mutex);
+    return taken;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t handle, TickType_t ticks)
+{
+    return host_wait(host_sem_attempt, handle, ticks) ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t handle)
+{
+    host_sem_t *sem = (host_sem_t *)handle;
+    pthread_mutex_lock(&sem->mutex);
+    BaseType_t given = sem->count < sem->max ? pdTRUE : pdFALSE;
+    if (given) {
+        sem->count++;
+    }
+    pthread_mutex_unlock(&sem->mutex);
+    return given;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t handle)
+{
+    host_sem_t *sem = (host_sem_t *)handle;
+    if (sem == NULL) {
+        return;
+    }
+    pthread_mutex_destroy(&sem->mutex);
+    free(sem);
+}
+
+EventGroupHandle_t xEventGroupCreate(void)
+{
+    atomic_uint *bits = (atomic_uint *)malloc(sizeof(atomic_uint));
+    if (bits != NULL) {
+        atomic_init(bits, 0);
+    }
+    return (EventGroupHandle_t)bits;
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits)
+{
+    return atomic_fetch_or((atomic_uint *)group, bits) | bits;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits)
+{
+    return atomic_fetch_and((atomic_uint *)group, ~bits);
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group)
+{
+    return atomic_load((atomic_uint *)group);
+}
+
+static bool host_event_attempt(void *arg)
+{
+    host_event_wait_t *w = (host_event_wait_t *)arg;
+    w->seen = atomic_load(w->bits);
+    bool met = w->all ? (w->seen & w->wait) == w->wait : (w->seen & w->wait) != 0;
+    if (met && w->clear) {
+        w->seen = atomic_fetch_and(w->bits, ~w->wait);
+    }
+    return met;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clear_on_exit,
+                                BaseType_t wait_for_all, TickType_t ticks)
+{
+    host_event_wait_t w = {
+        .bits = (atomic_uint *)group,
+        .wait = bits,
+        .clear = clear_on_exit != pdFALSE,
+        .all = wait_for_all != pdFALSE,
+    };
+    host_wait(host_event_attempt, &w, ticks);
+    return w.seen;
+}
+
+void vEventGroupDelete(EventGroupHandle_t group)
+{
+    free(group);
+}
+
+StreamBufferHandle_t xStreamBufferCreate(size_t size, size_t trigger_level)
+{
+    host_stream_t *sb = (host_stream_t *)calloc(1, sizeof(host_stream_t));
+    if (sb == NULL) {
+        return NULL;
+    }
+    sb->data = (uint8_t *)malloc(size);
+    if (sb->data == NULL) {
+        free(sb);
+        return NULL;
+    }
+    pthread_mutex_init(&sb->mutex, NULL);
+    sb->size = size;
+    sb->trigger = trigger_level > 0 ? trigger_level : 1;
+    return (StreamBufferHandle_t)sb;
+}
+
+typedef struct {
+    host_stream_t  *sb;
+    size_t          bytes;
+} host_stream_wait_t;
+
+static bool host_stream_readable(void *arg)
+{
+    host_stream_wait_t *w = (host_stream_wait_t *)arg;
+    pthread_mutex_lock(&w->sb->mutex);
+    bool ready = w->sb->count >= w->bytes;
+    pthread_mutex_unlock(&w->sb->mutex);
+    return ready;
+}
+
+static bool host_stream_writable(void *arg)
+{
+    host_stream_wait_t *w = (host_stream_wait_t *)arg;
+    pthread_mutex_lock(&w->sb->mutex);
+    bool ready = w->sb->size - w->sb->count >= w->bytes;
+    pthread_mutex_unlock(&w->sb->mutex);
+    return ready;
+}
+
+size_t xStreamBufferSend(StreamBufferHandle_t buffer, const void *data, size_t size, TickType_t ticks)
+{
+    host_stream_t *sb = (host_stream_t *)buffer;
+    host_stream_wait_t w = {.sb = sb, .bytes = size < sb->size ? size : sb->size};
+    host_wait(host_stream_writable, &w, ticks);
+
+    pthread_mutex_lock(&sb->mutex);
+    size_t space = sb->size - sb->count;
+    size_t sent = size < space ? size : space;
+    size_t tail = (sb->head + sb->count) % sb->size;
+    for (size_t i = 0; i < sent; i++) {
+        sb->data[(tail + i) % sb->size] = ((const uint8_t *)data)[i];
+    }
+    sb->count += sent;
+    host_task_t *woken = NULL;
+    unsigned blocks = 0;
+    if (sent > 0 && sb->receiver != NULL && atomic_load(&sb->receiver->blocked) && sb->count >= sb->wanted) {
+        woken = sb->receiver;
+        blocks = atomic_load(&woken->blocks);
+    }
+    pthread_mutex_unlock(&sb->mutex);
+    host_hand_over(woken, blocks);
+    return sent;
+}
+
+size_t xStreamBufferReceive(StreamBufferHandle_t buffer, void *data, size_t size, TickType_t ticks)
+{
+    host_stream_t *sb = (host_stream_t *)buffer;
+    host_stream_wait_t w = {.sb = sb, .bytes = size < sb->trigger ? size : sb->trigger};
+    pthread_mutex_lock(&sb->mutex);
+    sb->receiver = s_current_task;
+    sb->wanted = w.bytes;
+    pthread_mutex_unlock(&sb->mutex);
+    host_wait(host_stream_readable, &w, ticks);
+
+    pthread_mutex_lock(&sb->mutex);
+    sb->receiver = NULL;
+    size_t received = size < sb->count ? size : sb->count;
+    for (size_t i = 0; i < received; i++) {
+        ((uint8_t *)data)[i] = sb->data[(sb->head + i) % sb->size];
+    }
+    sb->head = (sb->head + received) % sb->size;
+    sb->count -= received;
+    pthread_mutex_unlock(&sb->mutex);
+    return received;
+}
+
+size_t xStreamBufferBytesAvailable(StreamBufferHandle_t buffer)
+{
+    host_stream_t *sb = (host_stream_t *)buffer;
+    pthread_mutex_lock(&sb->mutex);
+    size_t count = sb->count;
+    pthread_mutex_unlock(&sb->mutex);
+    return count;
+}
+
+size_t xStreamBufferSpacesAvailable(StreamBufferHandle_t buffer)
+{
+    host_stream_t *sb = (host_stream_t *)buffer;
+    pthread_mutex_lock(&sb->mutex);
+    size_t space = sb->size - sb->count;
+    pthread_mutex_unlock(&sb->mutex);
+    return space;
+}
+
+void vStreamBufferDelete(StreamBufferHandle_t buffer)
+{
+    host_stream_t *sb = (host_stream_t *)buffer;
+    if (sb == NULL) {
+        return;
+    }
+    pthread_mutex_destroy(&sb->mutex);
+    free(sb->data);
+    free(sb);
+}
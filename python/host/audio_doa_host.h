@@ -0,0 +1,28 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif  /* __cplusplus */
+
+/**
+ * @brief  Set the tick count seen by xTaskGetTickCount() on the calling thread
+ *
+ *         Offline processing runs faster than real time, so the tracker's output interval and
+ *         sample ageing follow the position in the audio instead of the wall clock. Each thread
+ *         has its own count, instances processed on different threads do not disturb each other.
+ *
+ * @param[in]  time_ms  Audio time in milliseconds, one tick per millisecond
+ */
+void audio_doa_host_set_audio_time_ms(uint32_t time_ms);
+
+#ifdef __cplusplus
+}
+#endif  /* __cplusplus */
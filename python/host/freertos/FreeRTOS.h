@@ -0,0 +1,40 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Minimal FreeRTOS API for the host build, implemented on POSIX threads in
+ * audio_doa_host.c.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef int          BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t     TickType_t;
+
+#define pdFALSE             0
+#define pdTRUE              1
+#define pdFAIL              0
+#define pdPASS              1
+#define portMAX_DELAY       ((TickType_t)0xffffffffu)
+#define configTICK_RATE_HZ  1000
+#define portTICK_PERIOD_MS  (1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms)   ((TickType_t)(ms))
+
+/* Critical sections are a spinlock per mux, there are no interrupts to mask */
+typedef struct {
+    int  locked;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED  {0}
+#define portENTER_CRITICAL(mux)       vPortEnterCritical(mux)
+#define portEXIT_CRITICAL(mux)        vPortExitCritical(mux)
+
+void vPortEnterCritical(portMUX_TYPE *mux);
+void vPortExitCritical(portMUX_TYPE *mux);
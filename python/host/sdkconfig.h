@@ -0,0 +1,34 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Host build configuration of the Python extension.
+ *
+ * Mirrors the Kconfig defaults, plus the adaptive window of the full profile that the
+ * extension exposes. Left out are esp-sr (not available off target) and the features
+ * the extension does not expose: shadow mode and metrics exporter. The soak
+ * runner has no build switch of its own, tools/audio_doa_host_eval.c links it directly.
+ */
+
+#pragma once
+
+#define CONFIG_AUDIO_DOA_ENGINE_SRP_PHAT     1
+#define CONFIG_AUDIO_DOA_ENGINE_ONE_BIT      1
+#define CONFIG_AUDIO_DOA_DECIMATION          1
+#define CONFIG_AUDIO_DOA_SMOOTHING           1
+#define CONFIG_AUDIO_DOA_CALIBRATION         1
+#define CONFIG_AUDIO_DOA_TRACKER             1
+#define CONFIG_AUDIO_DOA_ADAPTIVE_WINDOW     1
+#define CONFIG_AUDIO_DOA_STAGE_TIMING        1
+#define CONFIG_AUDIO_DOA_SPECIALIZE          1
+#define CONFIG_AUDIO_DOA_FRAME_SAMPLES       512
+#define CONFIG_AUDIO_DOA_MAX_MICS            4
+#define CONFIG_AUDIO_DOA_QUEUE_FRAMES        3
+#define CONFIG_AUDIO_DOA_SMOOTHING_WINDOW    5
+#define CONFIG_AUDIO_DOA_TRACKER_WINDOW      6
+#define CONFIG_AUDIO_DOA_MAX_STAGES          12
+#define CONFIG_AUDIO_DOA_TASK_STACK_SIZE     4096
+#define CONFIG_AUDIO_DOA_TASK_PRIORITY       10
@@ -0,0 +1,56 @@
+# SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+#
+# SPDX-License-Identifier: Apache-2.0
+"""
+Host build of the audio_doa Python extension.
+
+Compiles the component sources against the host port in python/host/ (fixed
+configuration in host/sdkconfig.h, no esp-sr) and the binding in audio_doa_module.c.
+
+Usage:
+    pip install ./python          # or: python python/setup.py build_ext --inplace
+"""
+
+import os
+
+from setuptools import Extension, setup
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+COMPONENT_DIR = os.path.dirname(HERE)
+
+COMPONENT_SOURCES = [
+    'audio_doa.c',
+    'audio_doa_app.c',
+    'audio_doa_pipeline.c',
+    'audio_doa_tracker.c',
+    'audio_doa_srp.c',
+    'audio_doa_onebit.c',
+]
+
+
+def rel(*parts):
+    # setuptools wants source paths relative to the setup.py directory
+    return os.path.relpath(os.path.join(*parts), HERE)
+
+
+extension = Extension(
+    'audio_doa',
+    sources=[rel(HERE, 'audio_doa_module.c'), rel(HERE, 'host', 'audio_doa_host.c')] +
+            [rel(COMPONENT_DIR, src) for src in COMPONENT_SOURCES],
+    include_dirs=[
+        os.path.join(HERE, 'host'),
+        os.path.join(COMPONENT_DIR, 'include'),
+        os.path.join(COMPONENT_DIR, 'priv_include'),
+    ],
+    extra_compile_args=['-std=gnu11', '-O2'],
+    libraries=['m'],
+)
+
+setup(
+    name='audio_doa',
+    version='1.0.0',
+    description='Host binding of the audio_doa synchronous processing path',
+    ext_modules=[extension],
+    install_requires=['numpy'],
+    python_requires='>=3.8',
+)
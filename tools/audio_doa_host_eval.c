@@ -0,0 +1,744 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Host evaluation of the audio_doa engines and services, built against the host port in
+ * python/host/.
+ *
+ * The audio is synthetic: a white noise source at 16 kHz reaching each microphone with
+ * the fractional delay of its direction (windowed-sinc interpolation), plus independent
+ * sensor noise at 20 dB SNR. Every check prints a table and fails when its accuracy
+ * bound is exceeded. Times are host CPU times, only their ratios carry over to targets.
+ *
+ * Build (from the component directory):
+ *   cc -std=gnu11 -O2 -Ipython/host -Iinclude -Ipriv_include -o audio_doa_host_eval \
+ *      tools/audio_doa_host_eval.c python/host/audio_doa_host.c audio_doa.c audio_doa_app.c \
+ *      audio_doa_pipeline.c audio_doa_tracker.c audio_doa_srp.c audio_doa_onebit.c \
+ *      audio_doa_fusion.c audio_doa_soak.c -lm -lpthread
+ * Usage: audio_doa_host_eval [check ...]   (no argument runs every check)
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sdkconfig.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "audio_doa.h"
+#include "audio_doa_srp.h"
+#include "audio_doa_fusion.h"
+#include "audio_doa_soak.h"
+
+#define EVAL_SAMPLE_RATE     16000
+#define EVAL_FRAME_SAMPLES   CONFIG_AUDIO_DOA_FRAME_SAMPLES
+#define EVAL_FRAMES          60
+#define EVAL_SKIP_FRAMES     2      /* Decimator and engine warm-up */
+#define EVAL_DISTANCE        0.046f
+#define EVAL_SPEED_OF_SOUND  343.0f
+#define EVAL_SNR_DB          20.0f
+#define EVAL_SINC_HALF       16     /* Taps on each side of the fractional delay filter */
+#define EVAL_ANGLE_STEP      15
+#define EVAL_MAX_ANGLES      (180 / EVAL_ANGLE_STEP + 1)
+#define EVAL_GAP_FRAMES      40
+#define EVAL_GAP_CHUNK       160    /* Samples per write, 10 ms */
+#define EVAL_GAP_EVERY       8      /* Every eighth chunk is lost */
+#define EVAL_GAP_ZERO_RUN    32     /* Zero samples in a row that mark a padded frame */
+#define EVAL_GAP_BATCH_MS    1000   /* Batch interval, its stream buffer holds 34 frames */
+#define EVAL_GAP_BATCH_BURST 33     /* Frames queued before the first wakeup, more than one mask word */
+#define EVAL_BENCH_FRAMES    20
+#define EVAL_SOAK_S          8
+#define EVAL_SOAK_REPORT_S   2
+#define EVAL_SOAK_SEED       68     /* Schedules two restarts and a reconfiguration within EVAL_SOAK_S */
+#define EVAL_SOAK_LEAK_BYTES 32768  /* glibc keeps freed chunks in per-thread caches, counted as in use */
+#define EVAL_WINDOW_FRAMES   40
+#define EVAL_WINDOW_WARMUP   8      /* Frames before the tracker has a velocity and two frames of history */
+#define EVAL_SILENCE_FRAMES  200
+#define EVAL_SILENCE_BATCH_MS 1000
+#define EVAL_SILENCE_FIRST   200    /* First chunk dropped by VAD */
+#define EVAL_SILENCE_CHUNKS  150    /* 1.5 s outside VAD, above the 1 s silence timeout */
+#define EVAL_FUSION_REPORTS  20
+#define EVAL_FUSION_PERIOD   100    /* ms between the reports of one device */
+#define EVAL_FUSION_MAX_ERR  0.05f  /* Position error bound in meters */
+
+typedef struct {
+    float     angles[EVAL_FRAMES];
+    int       count;
+} eval_angles_t;
+
+typedef struct {
+    const char          *name;
+    audio_doa_engine_t   engine;
+    bool                 decimate;
+    float                max_mean_err_deg;  /* Bound on the mean error over 15-165 degrees */
+} eval_engine_case_t;
+
+typedef struct {
+    const char  *name;
+    int          mic_num;
+    float        coarse_step_deg;
+    float        fine_step_deg;
+    float        max_mean_err_deg;
+} eval_grid_case_t;
+
+static uint32_t s_rand = 1;
+
+static float eval_randn(void)
+{
+    // Sum of uniforms, close enough to Gaussian for a noise source
+    float sum = 0.0f;
+    for (int i = 0; i < 12; i++) {
+        s_rand = s_rand * 1664525u + 1013904223u;
+        sum += (float)(s_rand >> 8) / (float)(1u << 24);
+    }
+    return sum - 6.0f;
+}
+
+/**
+ * Interleaved `mic_num` channel audio of a far-field source at `angle_deg` for a linear
+ * array spaced by `distance`, microphone 0 on the 0 degree side.
+ */
+static int16_t *eval_make_audio(int mic_num, float angle_deg, int frames)
+{
+    int samples = frames * EVAL_FRAME_SAMPLES;
+    int pad = EVAL_SINC_HALF + 8;
+    float *source = (float *)malloc((samples + 2 * pad) * sizeof(float));
+    int16_t *out = (int16_t *)malloc((size_t)samples * mic_num * sizeof(int16_t));
+    if (source == NULL || out == NULL) {
+        free(source);
+        free(out);
+        return NULL;
+    }
+    for (int i = 0; i < samples + 2 * pad; i++) {
+        source[i] = eval_randn() * 3000.0f;
+    }
+    float noise = 3000.0f * powf(10.0f, -EVAL_SNR_DB / 20.0f);
+    float cos_angle = cosf(angle_deg * (float)M_PI / 180.0f);
+    for (int m = 0; m < mic_num; m++) {
+        // Microphones nearer the source hear it earlier
+        float x = (m - (mic_num - 1) / 2.0f) * EVAL_DISTANCE;
+        float delay = x * cos_angle / EVAL_SPEED_OF_SOUND * EVAL_SAMPLE_RATE;
+        for (int n = 0; n < samples; n++) {
+            float t = n + pad - delay;
+            int k0 = (int)floorf(t);
+            float acc = 0.0f;
+            for (int k = k0 - EVAL_SINC_HALF + 1; k <= k0 + EVAL_SINC_HALF; k++) {
+                float u = t - k;
+                float sinc = fabsf(u) < 1e-6f ? 1.0f : sinf((float)M_PI * u) / ((float)M_PI * u);
+                float window = 0.5f + 0.5f * cosf((float)M_PI * u / EVAL_SINC_HALF);
+                acc += source[k] * sinc * window;
+            }
+            acc += eval_randn() * noise;
+            out[n * mic_num + m] = (int16_t)(acc > 32767.0f ? 32767.0f : acc < -32768.0f ? -32768.0f : acc);
+        }
+    }
+    free(source);
+    return out;
+}
+
+static void eval_collect(float angle, void *ctx)
+{
+    eval_angles_t *angles = (eval_angles_t *)ctx;
+    if (angles->count < EVAL_FRAMES) {
+        angles->angles[angles->count++] = angle;
+    }
+}
+
+/**
+ * Run `frames` frames through a synchronous instance without smoothing, returning the
+ * mean absolute error after warm-up and the engine stage's average time.
+ */
+static esp_err_t eval_run(audio_doa_config_t *config, const int16_t *audio, int frames, float truth,
+                          float *mean_err, uint32_t *engine_us)
+{
+    eval_angles_t angles = {0};
+    audio_doa_handle_t doa = NULL;
+    esp_err_t ret = audio_doa_new(&doa, config);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    audio_doa_set_doa_result_callback(doa, eval_collect, &angles);
+    audio_doa_start(doa);
+    ret = audio_doa_process(doa, audio, frames);
+    audio_doa_stage_stats_t stages[CONFIG_AUDIO_DOA_MAX_STAGES];
+    int count = 0;
+    audio_doa_get_stage_stats(doa, stages, CONFIG_AUDIO_DOA_MAX_STAGES, &count);
+    *engine_us = 0;
+    for (int i = 0; i < count; i++) {
+        if (stages[i].kind == AUDIO_DOA_STAGE_ENGINE) {
+            *engine_us = stages[i].avg_us;
+        }
+    }
+    audio_doa_delete(doa);
+    float sum = 0.0f;
+    for (int i = EVAL_SKIP_FRAMES; i < angles.count; i++) {
+        sum += fabsf(angles.angles[i] - truth);
+    }
+    *mean_err = angles.count > EVAL_SKIP_FRAMES ? sum / (angles.count - EVAL_SKIP_FRAMES) : 180.0f;
+    return ret;
+}
+
+static const eval_engine_case_t s_engine_cases[] = {
+    {"srp_phat", AUDIO_DOA_ENGINE_SRP_PHAT, false, 1.5f},
+    {"srp_phat decimated", AUDIO_DOA_ENGINE_SRP_PHAT, true, 2.5f},
+    {"one_bit", AUDIO_DOA_ENGINE_ONE_BIT, false, 2.5f},
+    {"one_bit decimated", AUDIO_DOA_ENGINE_ONE_BIT, true, 4.5f},
+};
+
+/**
+ * Accuracy and engine time per engine configuration over the whole angle range
+ */
+static int eval_check_engines(void)
+{
+    int angle_num = 180 / EVAL_ANGLE_STEP + 1;
+    int16_t *audio[EVAL_MAX_ANGLES] = {0};
+    int failed = 0;
+    for (int a = 0; a < angle_num; a++) {
+        audio[a] = eval_make_audio(2, (float)(a * EVAL_ANGLE_STEP), EVAL_FRAMES);
+        if (audio[a] == NULL) {
+            failed = 1;
+        }
+    }
+    printf("%-22s", "engine \\ angle");
+    for (int a = 0; a < angle_num; a++) {
+        printf("%6d", a * EVAL_ANGLE_STEP);
+    }
+    printf("  mean(15-165)  engine_us\n");
+    for (size_t c = 0; c < sizeof(s_engine_cases) / sizeof(s_engine_cases[0]) && !failed; c++) {
+        const eval_engine_case_t *ec = &s_engine_cases[c];
+        audio_doa_config_t config = {
+            .distance = EVAL_DISTANCE,
+            .engine = ec->engine,
+            .mic_num = 2,
+            .decimate = ec->decimate,
+            .disable_smoothing = true,
+            .stage_timing = true,
+            .synchronous = true,
+        };
+        float inner_sum = 0.0f;
+        int inner = 0;
+        uint64_t us_sum = 0;
+        printf("%-22s", ec->name);
+        for (int a = 0; a < angle_num; a++) {
+            float err;
+            uint32_t engine_us;
+            if (eval_run(&config, audio[a], EVAL_FRAMES, (float)(a * EVAL_ANGLE_STEP), &err, &engine_us) != ESP_OK) {
+                printf("  fail");
+                failed = 1;
+                continue;
+            }
+            printf("%6.1f", err);
+            us_sum += engine_us;
+            if (a > 0 && a < angle_num - 1) {
+                inner_sum += err;
+                inner++;
+            }
+        }
+        float mean = inner ? inner_sum / inner : 180.0f;
+        printf("  %8.2f %s  %9.1f\n", mean, mean <= ec->max_mean_err_deg ? "ok  " : "FAIL", (double)us_sum / angle_num);
+        if (mean > ec->max_mean_err_deg) {
+            failed = 1;
+        }
+    }
+    for (int a = 0; a < angle_num; a++) {
+        free(audio[a]);
+    }
+    return failed;
+}
+
+static const eval_grid_case_t s_grid_cases[] = {
+    {"2 mics hierarchical", 2, 10.0f, 1.0f, 1.5f},
+    {"2 mics exhaustive", 2, 1.0f, 1.0f, 1.5f},
+    {"4 mics hierarchical", 4, 10.0f, 1.0f, 1.5f},
+    {"4 mics exhaustive", 4, 1.0f, 1.0f, 1.5f},
+};
+
+/**
+ * Hierarchical (coarse then fine) against exhaustive SRP-PHAT grid search, run on the
+ * engine directly: accuracy over 15-165 degrees and time per frame
+ */
+static int eval_check_grid(void)
+{
+    int failed = 0;
+    printf("%-22s  coarse  fine  mean(15-165)  us/frame\n", "search");
+    for (size_t c = 0; c < sizeof(s_grid_cases) / sizeof(s_grid_cases[0]) && !failed; c++) {
+        const eval_grid_case_t *gc = &s_grid_cases[c];
+        audio_doa_mic_pos_t mic_pos[AUDIO_DOA_MAX_MICS] = {0};
+        for (int m = 0; m < gc->mic_num; m++) {
+            mic_pos[m].x = (m - (gc->mic_num - 1) / 2.0f) * EVAL_DISTANCE;
+        }
+        audio_doa_srp_cfg_t cfg = {
+            .sample_rate = EVAL_SAMPLE_RATE,
+            .frame_samples = EVAL_FRAME_SAMPLES,
+            .mic_num = gc->mic_num,
+            .mic_pos = mic_pos,
+            .coarse_step_deg = gc->coarse_step_deg,
+            .fine_step_deg = gc->fine_step_deg,
+        };
+        audio_doa_srp_t *srp = audio_doa_srp_create(&cfg);
+        int16_t *planar = (int16_t *)malloc((size_t)gc->mic_num * EVAL_FRAME_SAMPLES * sizeof(int16_t));
+        if (srp == NULL || planar == NULL) {
+            audio_doa_srp_destroy(srp);
+            free(planar);
+            return 1;
+        }
+        int16_t *mic_data[AUDIO_DOA_MAX_MICS];
+        for (int m = 0; m < gc->mic_num; m++) {
+            mic_data[m] = &planar[m * EVAL_FRAME_SAMPLES];
+        }
+        float err_sum = 0.0f;
+        int err_count = 0;
+        int64_t time_us = 0;
+        for (int angle = EVAL_ANGLE_STEP; angle < 180; angle += EVAL_ANGLE_STEP) {
+            int16_t *audio = eval_make_audio(gc->mic_num, (float)angle, EVAL_FRAMES);
+            if (audio == NULL) {
+                failed = 1;
+                break;
+            }
+            for (int f = 0; f < EVAL_FRAMES; f++) {
+                const int16_t *frame = &audio[(size_t)f * EVAL_FRAME_SAMPLES * gc->mic_num];
+                for (int n = 0; n < EVAL_FRAME_SAMPLES; n++) {
+                    for (int m = 0; m < gc->mic_num; m++) {
+                        mic_data[m][n] = frame[n * gc->mic_num + m];
+                    }
+                }
+                int64_t start = esp_timer_get_time();
+                float estimate = audio_doa_srp_process(srp, mic_data);
+                time_us += esp_timer_get_time() - start;
+                err_sum += fabsf(estimate - angle);
+                err_count++;
+            }
+            free(audio);
+        }
+        audio_doa_srp_destroy(srp);
+        free(planar);
+        float mean = err_count ? err_sum / err_count : 180.0f;
+        printf("%-22s  %6.0f  %4.0f  %8.2f %s  %8.1f\n", gc->name, gc->coarse_step_deg, gc->fine_step_deg, mean,
+               mean <= gc->max_mean_err_deg ? "ok  " : "FAIL", err_count ? (double)time_us / err_count : 0.0);
+        if (mean > gc->max_mean_err_deg) {
+            failed = 1;
+        }
+    }
+    return failed;
+}
+
+typedef struct {
+    int  frames;
+    int  padded;
+} eval_gap_probe_t;
+
+static bool eval_gap_probe(audio_doa_frame_t *frame, void *ctx)
+{
+    eval_gap_probe_t *probe = (eval_gap_probe_t *)ctx;
+    int run = 0;
+    bool padded = false;
+    for (int i = 0; i < EVAL_FRAME_SAMPLES * frame->mic_num && !padded; i++) {
+        run = frame->interleaved[i] == 0 ? run + 1 : 0;
+        padded = run >= EVAL_GAP_ZERO_RUN * frame->mic_num;
+    }
+    probe->frames++;
+    probe->padded += padded;
+    return true;
+}
+
+/**
+ * Capture gaps on an asynchronous instance with AUDIO_DOA_GAP_DISCARD: every frame
+ * completed with silence is skipped and every intact frame is processed, also when the
+ * DOA task preempts the writer the moment the padding completes a frame. With a batch
+ * interval the writer stops once `burst_frames` frames are queued instead of pacing
+ */
+static int eval_run_gap(uint32_t batch_interval_ms, int burst_frames)
+{
+    int16_t *audio = eval_make_audio(2, 60.0f, EVAL_GAP_FRAMES);
+    if (audio == NULL) {
+        return 1;
+    }
+    audio_doa_config_t config = {
+        .distance = EVAL_DISTANCE,
+        .engine = AUDIO_DOA_ENGINE_SRP_PHAT,
+        .mic_num = 2,
+        .gap_policy = AUDIO_DOA_GAP_DISCARD,
+        .disable_smoothing = true,
+        .batch_interval_ms = batch_interval_ms,
+    };
+    eval_gap_probe_t probe = {0};
+    audio_doa_stage_t stage = {
+        .name = "gap_probe",
+        .kind = AUDIO_DOA_STAGE_SOURCE,
+        .process = eval_gap_probe,
+        .ctx = &probe,
+    };
+    audio_doa_handle_t doa = NULL;
+    if (audio_doa_new(&doa, &config) != ESP_OK || audio_doa_add_stage(doa, &stage) != ESP_OK) {
+        audio_doa_delete(doa);
+        free(audio);
+        return 1;
+    }
+    audio_doa_start(doa);
+
+    // Track the writer's frame boundary to know how many frames the stream carries
+    int fill = 0;
+    int broken = 0;
+    int intact = 0;
+    int failed = 0;
+    int chunks = EVAL_GAP_FRAMES * EVAL_FRAME_SAMPLES / EVAL_GAP_CHUNK;
+    for (int c = 0; c < chunks && (burst_frames == 0 || intact + broken < burst_frames); c++) {
+        if (c % EVAL_GAP_EVERY == EVAL_GAP_EVERY - 1) {
+            continue;
+        }
+        uint64_t index = (uint64_t)c * EVAL_GAP_CHUNK;
+        if (c > 0 && (c - 1) % EVAL_GAP_EVERY == EVAL_GAP_EVERY - 1 && fill > 0) {
+            broken++;
+            fill = 0;
+        }
+        if (audio_doa_data_write_with_seq(doa, (uint8_t *)&audio[index * 2], EVAL_GAP_CHUNK * 2 * sizeof(int16_t),
+                                          index) != ESP_OK) {
+            failed = 1;
+        }
+        fill += EVAL_GAP_CHUNK;
+        intact += fill / EVAL_FRAME_SAMPLES;
+        fill %= EVAL_FRAME_SAMPLES;
+        if (burst_frames == 0) {
+            vTaskDelay(pdMS_TO_TICKS(EVAL_GAP_CHUNK * 1000 / EVAL_SAMPLE_RATE));
+        }
+    }
+    vTaskDelay(pdMS_TO_TICKS(batch_interval_ms + 200));
+    audio_doa_stats_t stats = {0};
+    audio_doa_get_stats(doa, &stats);
+    audio_doa_delete(doa);
+    free(audio);
+
+    printf("frames intact %d broken %d  processed %d  padded frames processed %d  discarded %lu\n",
+           intact, broken, probe.frames, probe.padded, (unsigned long)stats.frames_discarded);
+    return failed || probe.padded != 0 || probe.frames != intact || (int)stats.frames_discarded != broken;
+}
+
+static int eval_check_gap(void)
+{
+    return eval_run_gap(0, 0);
+}
+
+/**
+ * The same in batched mode: one second of sleep queues more frames than one word of
+ * the bad frame mask covers, the burst fills the stream buffer before the first wakeup
+ */
+static int eval_check_gap_batch(void)
+{
+    return eval_run_gap(EVAL_GAP_BATCH_MS, EVAL_GAP_BATCH_BURST);
+}
+
+typedef struct {
+    const int16_t  *audio;
+    bool            benching;
+    int             bench_frames;
+    int             frames;
+    int             mismatched;
+} eval_bench_probe_t;
+
+static bool eval_bench_probe(audio_doa_frame_t *frame, void *ctx)
+{
+    eval_bench_probe_t *probe = (eval_bench_probe_t *)ctx;
+    if (probe->benching) {
+        probe->bench_frames++;
+        return true;
+    }
+    size_t samples = (size_t)EVAL_FRAME_SAMPLES * frame->mic_num;
+    probe->mismatched += memcmp(frame->interleaved, &probe->audio[probe->frames * samples],
+                                samples * sizeof(int16_t)) != 0;
+    probe->frames++;
+    return true;
+}
+
+/**
+ * Self-benchmark on a stopped instance that holds half a received frame: the benchmark
+ * runs once the DOA task has parked, and the frame completed after restarting carries
+ * the captured audio, not the synthetic signal
+ */
+static int eval_check_bench(void)
+{
+    int16_t *audio = eval_make_audio(2, 60.0f, 2);
+    if (audio == NULL) {
+        return 1;
+    }
+    audio_doa_config_t config = {
+        .distance = EVAL_DISTANCE,
+        .engine = AUDIO_DOA_ENGINE_SRP_PHAT,
+        .mic_num = 2,
+        .disable_smoothing = true,
+    };
+    eval_bench_probe_t probe = {.audio = audio};
+    audio_doa_stage_t stage = {
+        .name = "bench_probe",
+        .kind = AUDIO_DOA_STAGE_SOURCE,
+        .process = eval_bench_probe,
+        .ctx = &probe,
+    };
+    audio_doa_handle_t doa = NULL;
+    if (audio_doa_new(&doa, &config) != ESP_OK || audio_doa_add_stage(doa, &stage) != ESP_OK) {
+        audio_doa_delete(doa);
+        free(audio);
+        return 1;
+    }
+    audio_doa_start(doa);
+    size_t half = EVAL_FRAME_SAMPLES / 2 * 2 * sizeof(int16_t);
+    int failed = audio_doa_data_write(doa, (uint8_t *)audio, half) != ESP_OK;
+    vTaskDelay(pdMS_TO_TICKS(50));
+
+    audio_doa_stop(doa);
+    probe.benching = true;
+    audio_doa_benchmark_t result = {0};
+    esp_err_t ret = audio_doa_benchmark(doa, EVAL_BENCH_FRAMES, &result);
+    probe.benching = false;
+
+    audio_doa_start(doa);
+    failed |= audio_doa_data_write(doa, (uint8_t *)audio + half, 3 * half) != ESP_OK;
+    vTaskDelay(pdMS_TO_TICKS(200));
+    audio_doa_delete(doa);
+    free(audio);
+
+    printf("benchmark %s  synthetic frames %d  captured frames %d  mismatched %d  real-time factor %.3f\n",
+           esp_err_to_name(ret), probe.bench_frames, probe.frames, probe.mismatched, result.real_time_factor);
+    return failed || ret != ESP_OK || probe.bench_frames != EVAL_BENCH_FRAMES || probe.frames != 2 ||
+           probe.mismatched != 0;
+}
+
+/**
+ * Adaptive window on a synchronous instance fed a still talker in one call: the tracker
+ * velocity follows audio time, not the tick count, so the long window is chosen although
+ * every frame is processed within the same few milliseconds
+ */
+static int eval_check_window(void)
+{
+    int16_t *audio = eval_make_audio(2, 60.0f, EVAL_WINDOW_FRAMES);
+    if (audio == NULL) {
+        return 1;
+    }
+    audio_doa_app_config_t config = {
+        .distance = EVAL_DISTANCE,
+        .engine = AUDIO_DOA_ENGINE_SRP_PHAT,
+        .mic_num = 2,
+        .adaptive_window = true,
+        .synchronous = true,
+    };
+    audio_doa_app_handle_t app = NULL;
+    if (audio_doa_app_create(&app, &config) != ESP_OK) {
+        free(audio);
+        return 1;
+    }
+    int64_t start_us = esp_timer_get_time();
+    esp_err_t ret = audio_doa_app_process(app, audio, EVAL_WINDOW_FRAMES);
+    int64_t elapsed_us = esp_timer_get_time() - start_us;
+    audio_doa_stats_t stats = {0};
+    audio_doa_app_get_stats(app, &stats);
+    audio_doa_app_destroy(app);
+    free(audio);
+
+    printf("%d frames in %.1f ms  short %lu  frame %lu  long %lu  switches %lu\n", EVAL_WINDOW_FRAMES,
+           elapsed_us / 1000.0, (unsigned long)stats.windows[AUDIO_DOA_WINDOW_SHORT].frames,
+           (unsigned long)stats.windows[AUDIO_DOA_WINDOW_FRAME].frames,
+           (unsigned long)stats.windows[AUDIO_DOA_WINDOW_LONG].frames, (unsigned long)stats.window_switches);
+    return ret != ESP_OK || stats.windows[AUDIO_DOA_WINDOW_LONG].frames < EVAL_WINDOW_FRAMES - EVAL_WINDOW_WARMUP;
+}
+
+/**
+ * Tracker of a batched instance fed at real-time pace with one VAD pause: ages and
+ * silence follow audio time, so one-second bursts of queued frames do not restart the
+ * tracker, only the pause does
+ */
+static int eval_check_silence(void)
+{
+    int16_t *audio = eval_make_audio(2, 60.0f, EVAL_SILENCE_FRAMES);
+    if (audio == NULL) {
+        return 1;
+    }
+    audio_doa_app_config_t config = {
+        .distance = EVAL_DISTANCE,
+        .engine = AUDIO_DOA_ENGINE_SRP_PHAT,
+        .mic_num = 2,
+        .batch_interval_ms = EVAL_SILENCE_BATCH_MS,
+    };
+    audio_doa_app_handle_t app = NULL;
+    if (audio_doa_app_create(&app, &config) != ESP_OK) {
+        free(audio);
+        return 1;
+    }
+    int failed = 0;
+    int chunks = EVAL_SILENCE_FRAMES * EVAL_FRAME_SAMPLES / EVAL_GAP_CHUNK;
+    for (int c = 0; c < chunks; c++) {
+        audio_doa_app_set_vad_detect(app, c < EVAL_SILENCE_FIRST || c >= EVAL_SILENCE_FIRST + EVAL_SILENCE_CHUNKS);
+        failed |= audio_doa_app_data_write(app, (uint8_t *)&audio[c * EVAL_GAP_CHUNK * 2],
+                                           EVAL_GAP_CHUNK * 2 * sizeof(int16_t)) != ESP_OK;
+        vTaskDelay(pdMS_TO_TICKS(EVAL_GAP_CHUNK * 1000 / EVAL_SAMPLE_RATE));
+    }
+    vTaskDelay(pdMS_TO_TICKS(EVAL_SILENCE_BATCH_MS + 200));
+    audio_doa_stats_t stats = {0};
+    audio_doa_app_get_stats(app, &stats);
+    audio_doa_app_destroy(app);
+    free(audio);
+
+    printf("frames %lu  wakeups %lu  tracker outputs %lu  resets %lu\n", (unsigned long)stats.frames_processed,
+           (unsigned long)stats.wakeups, (unsigned long)stats.tracker_outputs, (unsigned long)stats.tracker_resets);
+    return failed || stats.tracker_resets != 1;
+}
+
+static void eval_soak_progress(const audio_doa_soak_report_t *report, void *ctx)
+{
+    printf("%3lu s  %5lu/%-5lu frames  p50/p95/p99 %lu/%lu/%lu ms  heap growth %ld  failures 0x%lx\n",
+           (unsigned long)report->elapsed_s, (unsigned long)report->results, (unsigned long)report->frames_written,
+           (unsigned long)report->latency_p50_ms, (unsigned long)report->latency_p95_ms,
+           (unsigned long)report->latency_p99_ms, (long)report->heap_growth_bytes, (unsigned long)report->failures);
+}
+
+/**
+ * Short run of the soak runner: VAD toggles, restarts and a reconfiguration at real-time
+ * pace, with the leak check measuring the host heap after every destroy
+ */
+static int eval_check_soak(void)
+{
+    audio_doa_app_config_t config = {
+        .distance = EVAL_DISTANCE,
+        .engine = AUDIO_DOA_ENGINE_SRP_PHAT,
+        .mic_num = 2,
+    };
+    audio_doa_soak_cfg_t cfg = {
+        .duration_s = EVAL_SOAK_S,
+        .report_s = EVAL_SOAK_REPORT_S,
+        .seed = EVAL_SOAK_SEED,
+        .leak_bytes = EVAL_SOAK_LEAK_BYTES,
+        .progress = eval_soak_progress,
+    };
+    // The first task deletion loads the unwinder into the C library's heap for good, keep
+    // that out of the leak check's baseline
+    audio_doa_app_handle_t app = NULL;
+    if (audio_doa_app_create(&app, &config) != ESP_OK || audio_doa_app_destroy(app) != ESP_OK) {
+        return 1;
+    }
+    audio_doa_soak_report_t report = {0};
+    esp_err_t ret = audio_doa_soak_run(&config, &cfg, &report);
+    printf("%s  vad toggles %lu  restarts %lu  reconfigures %lu  tracker results %lu  max latency %lu ms\n",
+           esp_err_to_name(ret), (unsigned long)report.vad_toggles, (unsigned long)report.restarts,
+           (unsigned long)report.reconfigures, (unsigned long)report.tracker_results,
+           (unsigned long)report.latency_max_ms);
+    return ret != ESP_OK || report.results == 0 || report.reconfigures == 0;
+}
+
+/**
+ * Device-local bearing of the room point (x, y) seen from `pose`
+ */
+static float eval_bearing(const audio_doa_fusion_pose_t *pose, float x, float y)
+{
+    float world = atan2f(y - pose->y, x - pose->x) * 180.0f / (float)M_PI;
+    float bearing = 90.0f - (world - pose->heading_deg);
+    while (bearing < 0.0f) {
+        bearing += 360.0f;
+    }
+    while (bearing >= 360.0f) {
+        bearing -= 360.0f;
+    }
+    return bearing;
+}
+
+static int eval_fusion_submit(audio_doa_fusion_handle_t fusion, uint8_t source_id, uint32_t timestamp_ms, float bearing)
+{
+    uint8_t packet[AUDIO_DOA_FUSION_PACKET_SIZE];
+    if (audio_doa_fusion_pack_bearing(source_id, timestamp_ms, bearing, packet) != ESP_OK ||
+        audio_doa_fusion_submit_packet(fusion, packet, sizeof(packet)) != ESP_OK) {
+        printf("submit of source %u at %lu ms failed\n", source_id, (unsigned long)timestamp_ms);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * Loopback of packed bearing reports from two devices into the fusion service: the
+ * talker position is recovered and reordered reports never move the track back in time
+ */
+static int eval_check_fusion(void)
+{
+    const audio_doa_fusion_pose_t poses[2] = {
+        {.x = 0.0f, .y = 0.0f, .heading_deg = 90.0f},
+        {.x = 3.0f, .y = 0.0f, .heading_deg = 90.0f},
+    };
+    const float talker_x = 1.0f, talker_y = 2.0f;
+    audio_doa_fusion_handle_t fusion = NULL;
+    if (audio_doa_fusion_create(NULL, &fusion) != ESP_OK) {
+        return 1;
+    }
+    int failed = 0;
+    for (uint8_t s = 0; s < 2; s++) {
+        failed |= audio_doa_fusion_set_pose(fusion, s, &poses[s]) != ESP_OK;
+    }
+
+    // Device 1's reports lag device 0's, as if they crossed the network later
+    uint32_t last_track_ms = 0;
+    int backwards = 0;
+    audio_doa_fusion_track_t track = {0};
+    int count = 0;
+    for (int r = 0; r < 2 * EVAL_FUSION_REPORTS && !failed; r++) {
+        uint8_t s = r & 1;
+        uint32_t t = 1000 + (r / 2) * EVAL_FUSION_PERIOD + (s == 0 ? 40 : 0);
+        failed |= eval_fusion_submit(fusion, s, t, eval_bearing(&poses[s], talker_x, talker_y));
+        audio_doa_fusion_get_tracks(fusion, t, &track, 1, &count);
+        if (count == 1) {
+            backwards += (int32_t)(track.timestamp_ms - last_track_ms) < 0;
+            last_track_ms = track.timestamp_ms;
+        }
+    }
+    uint32_t end_ms = 1000 + (EVAL_FUSION_REPORTS - 1) * EVAL_FUSION_PERIOD + 40;
+
+    // A stale bearing of device 0 towards another point arriving last must be dropped
+    failed |= eval_fusion_submit(fusion, 0, end_ms - 200, eval_bearing(&poses[0], 1.5f, 2.0f));
+    audio_doa_fusion_track_t after = {0};
+    int after_count = 0;
+    audio_doa_fusion_get_tracks(fusion, end_ms, &after, 1, &after_count);
+    audio_doa_fusion_destroy(fusion);
+
+    float err = count == 1 ? hypotf(track.x - talker_x, track.y - talker_y) : INFINITY;
+    bool stale_ignored = after_count == 1 && after.timestamp_ms == track.timestamp_ms &&
+                         after.x == track.x && after.y == track.y;
+    printf("tracks %d  position (%.3f, %.3f) error %.3f m  last fix %lu ms  time reversals %d  stale report %s\n",
+           count, track.x, track.y, err, (unsigned long)track.timestamp_ms, backwards,
+           stale_ignored ? "dropped" : "applied");
+    return failed || count != 1 || err > EVAL_FUSION_MAX_ERR || track.timestamp_ms != end_ms ||
+           backwards != 0 || !stale_ignored;
+}
+
+static const struct {
+    const char  *name;
+    int        (*run)(void);
+    const char  *help;
+} s_checks[] = {
+    {"engines", eval_check_engines, "mean absolute angle error and engine time per engine"},
+    {"grid", eval_check_grid, "hierarchical versus exhaustive SRP-PHAT grid search"},
+    {"gap", eval_check_gap, "capture gaps on an asynchronous instance discard exactly the broken frames"},
+    {"gap_batch", eval_check_gap_batch, "the same with a 1 s batch interval"},
+    {"bench", eval_check_bench, "self-benchmark of a stopped instance keeps its partially received frame"},
+    {"window", eval_check_window, "adaptive window of a synchronous instance follows audio time"},
+    {"silence", eval_check_silence, "tracker of a batched instance restarts on the VAD pause only"},
+    {"soak", eval_check_soak, "short soak run with lifecycle churn and the heap leak check"},
+    {"fusion", eval_check_fusion, "packed bearing loopback through the multi-array fusion service"},
+};
+
+int main(int argc, char **argv)
+{
+    int failed = 0;
+    for (size_t i = 0; i < sizeof(s_checks) / sizeof(s_checks[0]); i++) {
+        bool selected = argc < 2;
+        for (int a = 1; a < argc; a++) {
+            selected |= strcmp(argv[a], s_checks[i].name) == 0;
+        }
+        if (!selected) {
+            continue;
+        }
+        printf("== %s: %s\n", s_checks[i].name, s_checks[i].help);
+        int ret = s_checks[i].run();
+        printf("== %s %s\n\n", s_checks[i].name, ret ? "FAILED" : "passed");
+        failed |= ret;
+    }
+    return failed;
+}
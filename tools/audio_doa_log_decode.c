@@ -0,0 +1,176 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Host decoder for audio_doa_log blocks (format in include/audio_doa_log.h).
+ *
+ * The input is the uploaded blocks concatenated as read by audio_doa_log_read().
+ * Prints one "stream,timestamp_ms,angle" CSV line per entry, or with -s a size
+ * summary comparing the encoded stream to CSV and to raw float records.
+ *
+ * Build: cc -std=c99 -O2 -o audio_doa_log_decode audio_doa_log_decode.c
+ * Usage: audio_doa_log_decode [-s] blocks.bin
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LOG_MAGIC        0x4C44
+#define LOG_VERSION      1
+#define LOG_HEADER_SIZE  16
+#define LOG_STREAM_NUM   2
+#define RAW_RECORD_SIZE  8  /* uint32 timestamp + float angle */
+
+typedef struct {
+    unsigned long  entries;
+    unsigned long  csv_bytes;
+    uint32_t       first_ms;
+    uint32_t       last_ms;
+    int            has_time;
+} stream_summary_t;
+
+static uint32_t get_le16(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8);
+}
+
+static uint32_t get_le32(const uint8_t *p)
+{
+    return get_le16(p) | (get_le16(p + 2) << 16);
+}
+
+static int get_varint(const uint8_t *p, const uint8_t *end, uint32_t *value)
+{
+    uint32_t v = 0;
+    int n = 0;
+    for (int shift = 0; p + n < end && shift < 35; shift += 7) {
+        uint8_t b = p[n++];
+        v |= (uint32_t)(b & 0x7f) << shift;
+        if (!(b & 0x80)) {
+            *value = v;
+            return n;
+        }
+    }
+    return -1;
+}
+
+static void emit(stream_summary_t *sum, int stream, uint32_t ms, float angle, int quiet)
+{
+    char line[64];
+    int len = snprintf(line, sizeof(line), "%d,%lu,%.2f\n", stream, (unsigned long)ms, angle);
+    if (!quiet) {
+        fputs(line, stdout);
+    }
+    stream_summary_t *s = &sum[stream];
+    s->entries++;
+    s->csv_bytes += (unsigned long)len - 2;  /* the stream column is implied per file in a CSV export */
+    if (!s->has_time) {
+        s->first_ms = ms;
+        s->has_time = 1;
+    }
+    s->last_ms = ms;
+}
+
+/* Returns the block length, or -1 if the data at `p` is not a valid block */
+static long decode_block(const uint8_t *p, size_t avail, stream_summary_t *sum, int quiet)
+{
+    if (avail < LOG_HEADER_SIZE || get_le16(p) != LOG_MAGIC || p[2] != LOG_VERSION || p[3] >= LOG_STREAM_NUM) {
+        return -1;
+    }
+    size_t len = LOG_HEADER_SIZE + get_le16(p + 4);
+    if (len > avail) {
+        return -1;
+    }
+    int stream = p[3];
+    uint32_t count = get_le16(p + 6);
+    uint32_t ms = get_le32(p + 8);
+    int32_t q = (int16_t)get_le16(p + 12);
+    float step = get_le16(p + 14) / 100.0f;
+    uint32_t dt = 0;
+
+    emit(sum, stream, ms, q * step, quiet);
+    const uint8_t *cur = p + LOG_HEADER_SIZE;
+    const uint8_t *end = p + len;
+    for (uint32_t i = 1; i < count; i++) {
+        uint32_t v;
+        int n = get_varint(cur, end, &v);
+        if (n < 0) {
+            return -1;
+        }
+        cur += n;
+        if (v & 1) {
+            n = get_varint(cur, end, &dt);
+            if (n < 0) {
+                return -1;
+            }
+            cur += n;
+        }
+        uint32_t zigzag = v >> 1;
+        q += (int32_t)(zigzag >> 1) ^ -(int32_t)(zigzag & 1);
+        ms += dt;
+        emit(sum, stream, ms, q * step, quiet);
+    }
+    return (long)len;
+}
+
+int main(int argc, char **argv)
+{
+    int summary = argc == 3 && strcmp(argv[1], "-s") == 0;
+    if (argc != 2 && !summary) {
+        fprintf(stderr, "usage: %s [-s] blocks.bin\n", argv[0]);
+        return 2;
+    }
+    FILE *fp = fopen(argv[argc - 1], "rb");
+    if (fp == NULL) {
+        perror(argv[argc - 1]);
+        return 1;
+    }
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    uint8_t *data = (uint8_t *)malloc(size > 0 ? (size_t)size : 1);
+    if (data == NULL || fread(data, 1, (size_t)size, fp) != (size_t)size) {
+        fprintf(stderr, "failed to read %s\n", argv[argc - 1]);
+        return 1;
+    }
+    fclose(fp);
+
+    stream_summary_t sum[LOG_STREAM_NUM] = {0};
+    unsigned long blocks = 0;
+    unsigned long encoded[LOG_STREAM_NUM] = {0};
+    for (long off = 0; off < size;) {
+        int stream = size - off > 3 ? data[off + 3] : 0;
+        long len = decode_block(data + off, (size_t)(size - off), sum, summary);
+        if (len < 0) {
+            fprintf(stderr, "bad block at offset %ld\n", off);
+            return 1;
+        }
+        encoded[stream] += (unsigned long)len;
+        blocks++;
+        off += len;
+    }
+    free(data);
+
+    if (summary) {
+        static const char *names[LOG_STREAM_NUM] = {"monitor", "result"};
+        printf("%lu blocks\n", blocks);
+        for (int s = 0; s < LOG_STREAM_NUM; s++) {
+            if (sum[s].entries == 0) {
+                continue;
+            }
+            double hours = (sum[s].last_ms - sum[s].first_ms) / 3600000.0;
+            if (hours <= 0.0) {
+                hours = 1.0 / 3600000.0;
+            }
+            printf("%-8s %lu entries over %.2f h, bytes/hour: encoded %.0f  csv %.0f  raw float %.0f  (%.2f bytes/entry)\n",
+                   names[s], sum[s].entries, hours, encoded[s] / hours, sum[s].csv_bytes / hours,
+                   sum[s].entries * (double)RAW_RECORD_SIZE / hours, (double)encoded[s] / sum[s].entries);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,125 @@
+#!/usr/bin/env python3
+# SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+#
+# SPDX-License-Identifier: Apache-2.0
+"""
+Flash/RAM footprint report for the audio_doa build profiles.
+
+The component cannot be linked on its own, so the report builds an application
+project that depends on audio_doa once per profile in profiles/ and reads the
+per-archive sizes of libaudio_doa.a from `idf.py size-components`.
+
+Per-instance heap is not visible to the linker. The report estimates it from the
+profile's sdkconfig; the exact value for a running instance is reported by
+audio_doa_app_get_stats() in instance_heap_bytes.
+
+Usage:
+    python tools/footprint_report.py --project <app_project> [--profile minimal ...] [--budget 20480]
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+
+COMPONENT_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+PROFILE_DIR = os.path.join(COMPONENT_DIR, 'profiles')
+ARCHIVE = 'libaudio_doa.a'
+
+# Fixed allocations that do not depend on the frame format: instance and chain
+# structs, FreeRTOS objects and allocator headers (rounded up)
+INSTANCE_OVERHEAD = 1536
+DECIM_FIR_HISTORY = 14
+
+
+def list_profiles():
+    prefix = 'sdkconfig.defaults.'
+    return sorted(f[len(prefix):] for f in os.listdir(PROFILE_DIR) if f.startswith(prefix))
+
+
+def build_profile(project, profile):
+    build_dir = os.path.join(project, 'build_' + profile)
+    defaults = os.path.join(PROFILE_DIR, 'sdkconfig.defaults.' + profile)
+    sdkconfig = os.path.join(build_dir, 'sdkconfig')
+    base = ['idf.py', '-C', project, '-B', build_dir,
+            '-D', 'SDKCONFIG=' + sdkconfig, '-D', 'SDKCONFIG_DEFAULTS=' + defaults]
+    subprocess.run(base + ['build'], check=True, stdout=subprocess.DEVNULL)
+    out = subprocess.run(base + ['size-components', '--format', 'json'],
+                         check=True, capture_output=True, text=True).stdout
+    with open(os.path.join(build_dir, 'config', 'sdkconfig.json')) as f:
+        config = json.load(f)
+    return json.loads(out[out.index('{'):]), config
+
+
+def find_archive(sizes):
+    if ARCHIVE in sizes:
+        return sizes[ARCHIVE]
+    # esp-idf-size 1.x nests archives under "archives"
+    return sizes.get('archives', {}).get(ARCHIVE, {})
+
+
+def section_sum(entry, region, kinds):
+    # Key names differ between idf_size versions (".flash.text", "flash_text", ...),
+    # so match on the memory region and the section kind
+    total = 0
+    for key, value in entry.items():
+        name = key.lower()
+        if region in name and any(k in name for k in kinds):
+            total += value if isinstance(value, int) else value.get('size', 0)
+    return total
+
+
+def estimate_heap(config):
+    mics = config.get('AUDIO_DOA_MAX_MICS', 2)
+    samples = config.get('AUDIO_DOA_FRAME_SAMPLES', 512)
+    frame_bytes = samples * mics * 2
+    heap = {
+        'stream buffer': frame_bytes * config.get('AUDIO_DOA_QUEUE_FRAMES', 3),
+        'frame buffer': frame_bytes,
+        'channel buffers': samples * 2 * mics,
+        'task stack': config.get('AUDIO_DOA_TASK_STACK_SIZE', 4096),
+        'instance': INSTANCE_OVERHEAD,
+    }
+    if config.get('AUDIO_DOA_DECIMATION'):
+        heap['decimation buffers (decimate = true)'] = (samples + DECIM_FIR_HISTORY) * 2 * mics
+    if config.get('AUDIO_DOA_ENGINE_ONE_BIT') and not config.get('AUDIO_DOA_ENGINE_ESP_SR'):
+        heap['1-bit engine'] = 2 * (samples // 32) * 4 + 256
+    if config.get('AUDIO_DOA_ENGINE_ESP_SR'):
+        heap['esp-sr engine (not estimated)'] = 0
+    return heap
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--project', required=True, help='ESP-IDF application project that depends on audio_doa')
+    parser.add_argument('--profile', action='append', choices=list_profiles(), help='Profile to report (default: all)')
+    parser.add_argument('--budget', type=int, default=20 * 1024, help='RAM budget in bytes (default: 20480)')
+    args = parser.parse_args()
+
+    for profile in args.profile or list_profiles():
+        sizes, config = build_profile(args.project, profile)
+        entry = find_archive(sizes)
+        if not entry:
+            print('%s: %s not found in the size report' % (profile, ARCHIVE), file=sys.stderr)
+            continue
+        flash_code = section_sum(entry, 'flash', ('text',)) + section_sum(entry, 'iram', ('text',))
+        flash_rodata = section_sum(entry, 'flash', ('rodata',))
+        static_ram = section_sum(entry, 'dram', ('data', 'bss'))
+        heap = estimate_heap(config)
+        heap_total = sum(heap.values())
+        ram_total = static_ram + heap_total
+
+        print('== %s ==' % profile)
+        print('  flash code     %7d' % flash_code)
+        print('  flash rodata   %7d' % flash_rodata)
+        print('  static RAM     %7d' % static_ram)
+        for name, size in heap.items():
+            print('  heap (est.) %-19s %7d' % (name, size))
+        print('  RAM total (est.) %5d  (%s %d byte budget)' %
+              (ram_total, 'within' if ram_total <= args.budget else 'OVER', args.budget))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())